@@ -37,10 +37,15 @@
 #include <progress_dlg.h>
 #include <unistd.h>
 #include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
 #include "SDL.h"
 #include "view_main_dialog.h"
 #include "sdl_graphics.h"
 #include "sdl_world.h"
+#include "sdl_background.h"
+#include "sdl_raster.h"
 #include "timeout.h"
 #include "lingual.h"
 #include "image_dlg.h"
@@ -58,6 +63,10 @@
 #include "font_dlg.h"
 #include "audio_dlg.h"
 #include "bar_dlg.h"
+#include "sdl_json_object.h"
+#include "sdl_profiler.h"
+#include "json_reader.h"
+#include "json_arena.h"
 
 bool mainLoop( Iworld *world);
 
@@ -172,6 +181,15 @@ void createSettings()
 	defaults.full_screen =false;
 	defaults.handwriting_detection_enabled =false;
 	defaults.country =0;
+	defaults.text_cache_size =4*1024*1024;
+	defaults.image_cache_size =64*1024*1024;
+	defaults.image_decode_threads =2;
+	defaults.damage_tracking =1;
+	defaults.maximum_idle_time =100;
+	defaults.raster_fill =1;
+	defaults.look_cache_size =8*1024*1024;
+	defaults.font_manifest ="fonts.txt";
+	defaults.debug_profiler =0;
 	// Functions
 	defaults.next_language =NULL;
 	defaults.find_text_id =NULL;
@@ -275,6 +293,281 @@ bool mainLoop( Iworld *world)
 	return retVal;
 }
 
+/// Paints per fill style and method in the benchmark.
+#define BENCHMARK_LOOPS		200
+
+/*============================================================================*/
+///
+///  @brief 	Compare painting backgrounds pixel by pixel and in a buffer.
+///
+///  @param		world [in] World to paint in.
+///
+///  @post      Time per paint written to stdout.
+///
+/*============================================================================*/
+void benchmarkFill( Iworld *world)
+{
+	CmainDialog dialog( world);
+	Cbackground background( &dialog, Crect( 2,2,40,16), KEY_NONE,
+			                COLOUR_LIGHTBLUE, 8, FILL_GRADIENT, COLOUR_DARKBLUE);
+	const EfillType fills[] ={ FILL_GRADIENT, FILL_PYRAMID, FILL_CIRCULAR, FILL_PIE };
+	const char *names[] ={ "gradient", "pyramid", "circular", "pie" };
+
+	background.setCorner( 135);
+	for ( int a=0; a<(int)(sizeof(fills)/sizeof(fills[0])); a++)
+	{
+		background.setFillStyle( fills[a]);
+		// -1 is the old pixel by pixel painting.
+		for ( int method=-1; method<=(int)Craster::bestLevel(); method++)
+		{
+			Cgraphics::m_defaults.raster_fill =( method>=0) ? 1:0;
+			Craster::setLevel( ( method>=0) ? (ErasterLevel)method:RASTER_BEST);
+			Uint32 start =SDL_GetTicks();
+			for ( int n=0; n<BENCHMARK_LOOPS; n++)
+			{
+				background.onPaint( 0);
+			}
+			world->graphics()->update();
+			double time =(double)(SDL_GetTicks()-start)/BENCHMARK_LOOPS;
+			printf( "%-10s %-7s %8.3f msec\n", names[a],
+					( method>=0) ? Craster::levelName( (ErasterLevel)method):"pixel", time);
+		}
+	}
+	Cgraphics::m_defaults.raster_fill =defaults.raster_fill;
+	Craster::setLevel( RASTER_BEST);
+}
+
+/// Parses per file and reader in the JSON benchmark.
+#define BENCHMARK_JSON_LOOPS	200
+
+/// Allocations done with new by this thread while counting.
+static thread_local size_t s_allocations =0;
+/// Only the JSON benchmark counts, and only in its own thread.
+static thread_local bool s_countAllocations =false;
+
+void *operator new( size_t size)
+{
+	if ( s_countAllocations)
+	{
+		s_allocations++;
+	}
+	for (;;)
+	{
+		void *memory =malloc( size ? size:1);
+		if ( memory)
+		{
+			return memory;
+		}
+		std::new_handler handler =std::set_new_handler( NULL);
+		std::set_new_handler( handler);
+		if ( handler ==NULL)
+		{
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+void operator delete( void *memory) noexcept
+{
+	free( memory);
+}
+
+/*============================================================================*/
+///
+///  @brief 	Compare parsing JSON into Json::Value and into an arena.
+///
+///  @param		count [in] Number of files.
+///  @param		files [in] JSON files, e.g. menus and configuration.
+///
+///  @post      Time and allocations per parse written to stdout.
+///
+/*============================================================================*/
+void benchmarkJson( int count, char *files[])
+{
+	s_countAllocations =true;
+	for ( int a=0; a<count; a++)
+	{
+		std::string text;
+		FILE *f =fopen( files[a], "rb");
+		if ( f ==NULL)
+		{
+			printf( "%s cannot be read\n", files[a]);
+			continue;
+		}
+		char buffer[4096];
+		size_t length;
+		while ( (length =fread( buffer, 1, sizeof(buffer), f)) >0)
+		{
+			text.append( buffer, length);
+		}
+		fclose( f);
+
+		size_t allocations =s_allocations;
+		Uint32 start =SDL_GetTicks();
+		for ( int n=0; n<BENCHMARK_JSON_LOOPS; n++)
+		{
+			Json::Reader reader;
+			Json::Value root;
+			reader.parse( text, root);
+		}
+		printf( "%-30s value %8.3f msec %8d allocations\n", files[a],
+				(double)(SDL_GetTicks()-start)/BENCHMARK_JSON_LOOPS,
+				(int)((s_allocations-allocations)/BENCHMARK_JSON_LOOPS));
+
+		Json::Arena arena;
+		Json::ArenaReader reader;
+		allocations =s_allocations;
+		start =SDL_GetTicks();
+		for ( int n=0; n<BENCHMARK_JSON_LOOPS; n++)
+		{
+			Json::ArenaValue root;
+			arena.clear();
+			reader.parse( text, arena, root);
+		}
+		printf( "%-30s arena %8.3f msec %8d allocations, %d blocks\n", files[a],
+				(double)(SDL_GetTicks()-start)/BENCHMARK_JSON_LOOPS,
+				(int)((s_allocations-allocations)/BENCHMARK_JSON_LOOPS),
+				(int)arena.blockCount());
+	}
+	s_countAllocations =false;
+}
+
+/// Frames painted before a dialog is compared with its golden image.
+#define VISUAL_TEST_FRAMES	20
+
+/// Frames painted per dialog in the dialog benchmark.
+#define BENCHMARK_FRAMES	200
+
+/// @brief What testDialogs does with each dialog.
+typedef enum
+{
+	TEST_BENCHMARK,	///< Time full repaints.
+	TEST_RECORD,	///< Save the golden images.
+	TEST_COMPARE	///< Compare with the golden images.
+} EtestMode;
+
+static Cdialog *s_testDialog =NULL; ///< Dialog driven by the test events.
+static int s_testFrames =0; ///< Frames still to paint.
+
+/*============================================================================*/
+///
+///  @brief 	Test event callback, repaint the dialog and stop it after some frames.
+///
+///  @param		event [out] Not used, no input is given.
+///
+///  @return	Always false.
+///
+/*============================================================================*/
+static bool driveDialog( SDL_Event &event)
+{
+	(void)event;
+	if ( s_testDialog ==NULL)
+	{
+		return false;
+	}
+	if ( --s_testFrames <=0)
+	{
+		s_testDialog->exit();
+	}
+	else
+	{
+		s_testDialog->invalidate();
+	}
+	return false;
+}
+
+/*============================================================================*/
+///
+///  @brief 	Run the demo dialogs without input, as benchmark or visual test.
+///
+///  @param		world [in] World to paint in.
+///  @param		mode [in] Benchmark, record or compare.
+///  @param		path [in] Directory with the golden images.
+///
+///  @return	Number of dialogs that differ from their golden image.
+///
+/*============================================================================*/
+int testDialogs( Iworld *world, EtestMode mode, const std::string &path)
+{
+	CmainDialog mainDlg(world);
+	CimageDlg imageDlg(world);
+	CscrollHorizontalDlg scrollHorizontalDlg(world);
+	CscrollVerticalDlg  scrollVerticalDlg(world);
+	CbuttonDlg buttonDlg(world);
+	CcheckBoxDlg checkBoxDlg(world);
+	Cswype2DverticalDlg  swype2Dvertical(world);
+	Cswype2DhorizontalDlg swype2Dhorizontal(world);
+	CnumberDlg  numberDlg(world);
+	CeditDlg	editDlg(world);
+	CdragDlg    dragDlg(world);
+	CprogressDlg progressDlg(world);
+	CfontDlg	fontDlg(world);
+	CbarDlg		barDlg(world);
+	// Audio and hand writing need devices a build server does not have.
+	Cdialog *dialogs[] ={ &mainDlg, &imageDlg, &scrollHorizontalDlg, &scrollVerticalDlg,
+			              &buttonDlg, &checkBoxDlg, &swype2Dvertical, &swype2Dhorizontal,
+			              &numberDlg, &editDlg, &dragDlg, &progressDlg, &fontDlg, &barDlg };
+	const char *names[] ={ "main", "image", "scroll_horizontal", "scroll_vertical",
+			               "button", "check_box", "swype_2d_vertical", "swype_2d_horizontal",
+			               "number", "edit", "drag", "progress", "font", "bar" };
+	int failed =0;
+
+	Cgraphics::m_defaults.get_test_event =driveDialog;
+	if ( mode !=TEST_BENCHMARK)
+	{
+		// Load images on paint, a golden image must never catch a placeholder.
+		Cgraphics::m_defaults.image_decode_threads =0;
+	}
+	for ( int a=0; a<(int)(sizeof(dialogs)/sizeof(dialogs[0])); a++)
+	{
+		std::string golden =path + "/" + names[a] + ".png";
+		s_testDialog =dialogs[a];
+		s_testFrames =( mode ==TEST_BENCHMARK) ? BENCHMARK_FRAMES:VISUAL_TEST_FRAMES;
+		Uint32 start =SDL_GetTicks();
+		dialogs[a]->onExecute( NULL);
+
+		switch ( mode)
+		{
+		case TEST_BENCHMARK:
+			printf( "%-20s %8.3f msec\n", names[a], (double)(SDL_GetTicks()-start)/BENCHMARK_FRAMES);
+			break;
+		case TEST_RECORD:
+			if ( world->graphics()->savePng( golden) ==false)
+			{
+				printf( "%-20s cannot write %s\n", names[a], golden.c_str());
+				failed++;
+			}
+			break;
+		case TEST_COMPARE:
+		{
+			int differences =world->graphics()->compareGolden( golden);
+			if ( differences ==0)
+			{
+				printf( "%-20s ok\n", names[a]);
+			}
+			else
+			{
+				if ( differences <0)
+				{
+					printf( "%-20s no golden image %s\n", names[a], golden.c_str());
+				}
+				else
+				{
+					printf( "%-20s %d pixels differ\n", names[a], differences);
+				}
+				world->graphics()->savePng( path + "/" + names[a] + ".failed.png");
+				failed++;
+			}
+			break;
+		}
+		}
+	}
+	s_testDialog =NULL;
+	Cgraphics::m_defaults.get_test_event =defaults.get_test_event;
+	return failed;
+}
+
 /*============================================================================*/
 ///
 ///  @brief 	Start program.
@@ -290,9 +583,29 @@ int main(int argc, char *argv[])
 	std::string argv_str(argv[0]);
 	std::string base = argv_str.substr(0, argv_str.find_last_of("/"));
 	base = argv_str.substr(0, base.find_last_of("/"));
+    if ( argc>2 && std::string( argv[1]) =="--compile-layout")
+    {
+    	// Build step: JSON layout to the binary form CjsonObject::load maps.
+    	return CjsonObject::compile( argv[2], ( argc>3) ? argv[3]:"") ? 0:1;
+    }
+    if ( argc>2 && std::string( argv[1]) =="--benchmark-json")
+    {
+    	benchmarkJson( argc-2, argv+2);
+    	return 0;
+    }
     createSettings();
     TTF_Init();
-    std::shared_ptr<Cgraphics> mainGraph =std::shared_ptr<Cgraphics>(new Cgraphics( Csize(defaults.width, defaults.height), true));
+    // --headless paints on a memory surface, e.g. with SDL_VIDEODRIVER=dummy.
+    bool headless =false;
+    int first =1;
+    if ( argc>first && std::string( argv[first]) =="--headless")
+    {
+    	headless =true;
+    	first++;
+    }
+    std::shared_ptr<Cgraphics> mainGraph =std::shared_ptr<Cgraphics>(
+    		new Cgraphics( Csize(defaults.width, defaults.height), true,
+    				       headless ? GRAPHICS_HEADLESS:GRAPHICS_WINDOW));
     defaults.image_path = base + "/images/";
     defaults.font_path = base + "/font/";
     defaults.data_path = base + "/data/";
@@ -301,6 +614,35 @@ int main(int argc, char *argv[])
     Cworld world(mainGraph);
     world.init();
 
+    std::string option =( argc>first) ? argv[first]:"";
+    std::string path =( argc>first+1) ? argv[first+1]:defaults.data_path+"golden";
+    if ( option =="--benchmark-fill")
+    {
+    	benchmarkFill( &world);
+    	return 0;
+    }
+    if ( option =="--benchmark-dialogs")
+    {
+    	testDialogs( &world, TEST_BENCHMARK, path);
+    	return 0;
+    }
+    if ( option =="--record-golden")
+    {
+    	return testDialogs( &world, TEST_RECORD, path) ? 1:0;
+    }
+    if ( option =="--visual-test")
+    {
+    	return testDialogs( &world, TEST_COMPARE, path) ? 1:0;
+    }
+#ifdef USE_PROFILER
+    if ( option =="--profile")
+    {
+    	// Overlay while running, trace for chrome://tracing when stopped.
+    	Cgraphics::m_defaults.debug_profiler =1;
+    	mainLoop(&world);
+    	return Cprofiler::Instance()->dump( ( argc>first+1) ? argv[first+1]:defaults.data_path+"trace.json") ? 0:1;
+    }
+#endif
     mainLoop(&world);
 	return 0;
 }
@@ -63,6 +63,8 @@ CimageDlg::~CimageDlg()
 
 bool CimageDlg::onInit()
 {
+	// Button images are decoded while the dialog starts.
+	prefetch( { "left48.png", "right48.png", "enter48.png", "cancel48.png" });
 	return true;
 }
 
@@ -4,16 +4,19 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../source_json/json_arena.cpp \
 ../source_json/json_reader.cpp \
 ../source_json/json_value.cpp \
 ../source_json/json_writer.cpp 
 
 OBJS += \
+./source_json/json_arena.o \
 ./source_json/json_reader.o \
 ./source_json/json_value.o \
 ./source_json/json_writer.o 
 
 CPP_DEPS += \
+./source_json/json_arena.d \
 ./source_json/json_reader.d \
 ./source_json/json_value.d \
 ./source_json/json_writer.d 
@@ -13,6 +13,7 @@ CPP_SRCS += \
 ../source_sdl_graphics/sdl_button.cpp \
 ../source_sdl_graphics/sdl_checkbox.cpp \
 ../source_sdl_graphics/sdl_combobox.cpp \
+../source_sdl_graphics/sdl_damage_region.cpp \
 ../source_sdl_graphics/sdl_dialog.cpp \
 ../source_sdl_graphics/sdl_dialog_event.cpp \
 ../source_sdl_graphics/sdl_dialog_list.cpp \
@@ -21,14 +22,20 @@ CPP_SRCS += \
 ../source_sdl_graphics/sdl_font.cpp \
 ../source_sdl_graphics/sdl_graphics.cpp \
 ../source_sdl_graphics/sdl_hand_writer.cpp \
+../source_sdl_graphics/sdl_hit_grid.cpp \
 ../source_sdl_graphics/sdl_image.cpp \
+../source_sdl_graphics/sdl_image_loader.cpp \
 ../source_sdl_graphics/sdl_info_button.cpp \
 ../source_sdl_graphics/sdl_json_object.cpp \
 ../source_sdl_graphics/sdl_key_file.cpp \
 ../source_sdl_graphics/sdl_keybutton.cpp \
 ../source_sdl_graphics/sdl_label.cpp \
+../source_sdl_graphics/sdl_layout.cpp \
+../source_sdl_graphics/sdl_look_cache.cpp \
 ../source_sdl_graphics/sdl_message_box.cpp \
+../source_sdl_graphics/sdl_profiler.cpp \
 ../source_sdl_graphics/sdl_progress_bar.cpp \
+../source_sdl_graphics/sdl_raster.cpp \
 ../source_sdl_graphics/sdl_rect.cpp \
 ../source_sdl_graphics/sdl_rectangle.cpp \
 ../source_sdl_graphics/sdl_scroll_text.cpp \
@@ -37,6 +44,10 @@ CPP_SRCS += \
 ../source_sdl_graphics/sdl_swype_dialog.cpp \
 ../source_sdl_graphics/sdl_swype_object_dialog.cpp \
 ../source_sdl_graphics/sdl_text.cpp \
+../source_sdl_graphics/sdl_text_cache.cpp \
+../source_sdl_graphics/sdl_text_layout.cpp \
+../source_sdl_graphics/sdl_text_script.cpp \
+../source_sdl_graphics/sdl_texture_pool.cpp \
 ../source_sdl_graphics/sdl_touch.cpp \
 ../source_sdl_graphics/sdl_world.cpp 
 
@@ -50,6 +61,7 @@ OBJS += \
 ./source_sdl_graphics/sdl_button.o \
 ./source_sdl_graphics/sdl_checkbox.o \
 ./source_sdl_graphics/sdl_combobox.o \
+./source_sdl_graphics/sdl_damage_region.o \
 ./source_sdl_graphics/sdl_dialog.o \
 ./source_sdl_graphics/sdl_dialog_event.o \
 ./source_sdl_graphics/sdl_dialog_list.o \
@@ -58,14 +70,20 @@ OBJS += \
 ./source_sdl_graphics/sdl_font.o \
 ./source_sdl_graphics/sdl_graphics.o \
 ./source_sdl_graphics/sdl_hand_writer.o \
+./source_sdl_graphics/sdl_hit_grid.o \
 ./source_sdl_graphics/sdl_image.o \
+./source_sdl_graphics/sdl_image_loader.o \
 ./source_sdl_graphics/sdl_info_button.o \
 ./source_sdl_graphics/sdl_json_object.o \
 ./source_sdl_graphics/sdl_key_file.o \
 ./source_sdl_graphics/sdl_keybutton.o \
 ./source_sdl_graphics/sdl_label.o \
+./source_sdl_graphics/sdl_layout.o \
+./source_sdl_graphics/sdl_look_cache.o \
 ./source_sdl_graphics/sdl_message_box.o \
+./source_sdl_graphics/sdl_profiler.o \
 ./source_sdl_graphics/sdl_progress_bar.o \
+./source_sdl_graphics/sdl_raster.o \
 ./source_sdl_graphics/sdl_rect.o \
 ./source_sdl_graphics/sdl_rectangle.o \
 ./source_sdl_graphics/sdl_scroll_text.o \
@@ -74,6 +92,10 @@ OBJS += \
 ./source_sdl_graphics/sdl_swype_dialog.o \
 ./source_sdl_graphics/sdl_swype_object_dialog.o \
 ./source_sdl_graphics/sdl_text.o \
+./source_sdl_graphics/sdl_text_cache.o \
+./source_sdl_graphics/sdl_text_layout.o \
+./source_sdl_graphics/sdl_text_script.o \
+./source_sdl_graphics/sdl_texture_pool.o \
 ./source_sdl_graphics/sdl_touch.o \
 ./source_sdl_graphics/sdl_world.o 
 
@@ -87,6 +109,7 @@ CPP_DEPS += \
 ./source_sdl_graphics/sdl_button.d \
 ./source_sdl_graphics/sdl_checkbox.d \
 ./source_sdl_graphics/sdl_combobox.d \
+./source_sdl_graphics/sdl_damage_region.d \
 ./source_sdl_graphics/sdl_dialog.d \
 ./source_sdl_graphics/sdl_dialog_event.d \
 ./source_sdl_graphics/sdl_dialog_list.d \
@@ -95,14 +118,20 @@ CPP_DEPS += \
 ./source_sdl_graphics/sdl_font.d \
 ./source_sdl_graphics/sdl_graphics.d \
 ./source_sdl_graphics/sdl_hand_writer.d \
+./source_sdl_graphics/sdl_hit_grid.d \
 ./source_sdl_graphics/sdl_image.d \
+./source_sdl_graphics/sdl_image_loader.d \
 ./source_sdl_graphics/sdl_info_button.d \
 ./source_sdl_graphics/sdl_json_object.d \
 ./source_sdl_graphics/sdl_key_file.d \
 ./source_sdl_graphics/sdl_keybutton.d \
 ./source_sdl_graphics/sdl_label.d \
+./source_sdl_graphics/sdl_layout.d \
+./source_sdl_graphics/sdl_look_cache.d \
 ./source_sdl_graphics/sdl_message_box.d \
+./source_sdl_graphics/sdl_profiler.d \
 ./source_sdl_graphics/sdl_progress_bar.d \
+./source_sdl_graphics/sdl_raster.d \
 ./source_sdl_graphics/sdl_rect.d \
 ./source_sdl_graphics/sdl_rectangle.d \
 ./source_sdl_graphics/sdl_scroll_text.d \
@@ -111,6 +140,10 @@ CPP_DEPS += \
 ./source_sdl_graphics/sdl_swype_dialog.d \
 ./source_sdl_graphics/sdl_swype_object_dialog.d \
 ./source_sdl_graphics/sdl_text.d \
+./source_sdl_graphics/sdl_text_cache.d \
+./source_sdl_graphics/sdl_text_layout.d \
+./source_sdl_graphics/sdl_text_script.d \
+./source_sdl_graphics/sdl_texture_pool.d \
 ./source_sdl_graphics/sdl_touch.d \
 ./source_sdl_graphics/sdl_world.d 
 
@@ -0,0 +1,182 @@
+#ifndef CPPTL_JSON_ARENA_H_INCLUDED
+# define CPPTL_JSON_ARENA_H_INCLUDED
+
+# include "json_value.h"
+# include <string>
+# include <vector>
+
+namespace Json {
+
+   class ArenaValue;
+   struct ArenaMember;
+
+   /** \brief Bump allocator holding all nodes and decoded strings of documents.
+    *
+    * Memory is taken in large blocks and only given back by clear() or the
+    * destructor, so a document costs a few allocations instead of one per value.
+    */
+   class JSON_API Arena
+   {
+   public:
+      Arena( size_t blockSize = 64*1024 );
+      ~Arena();
+
+      /// Aligned memory, valid until clear().
+      void *allocate( size_t size );
+
+      /// Forget all documents, the last block is kept for the next one.
+      void clear();
+
+      /// Blocks allocated since construction.
+      size_t blockCount() const { return blockCount_; }
+
+      /// Bytes handed out since the last clear().
+      size_t used() const { return used_; }
+
+   private:
+      Arena( const Arena &other );
+      Arena &operator =( const Arena &other );
+
+      struct Block
+      {
+         Block *next_;
+         size_t size_;
+      };
+
+      Block *blocks_;
+      char *current_;
+      char *end_;
+      size_t blockSize_;
+      size_t blockCount_;
+      size_t used_;
+   };
+
+   /** \brief Read-only JSON value living in an Arena.
+    *
+    * Strings without escapes point into the parsed text, so the text and the
+    * arena must outlive the value. Objects are member arrays sorted by name,
+    * found by binary search. Copying a value is cheap, it is only a handle.
+    */
+   class JSON_API ArenaValue
+   {
+      friend class ArenaReader;
+   public:
+      typedef Json::UInt UInt;
+      typedef Json::Int Int;
+
+      static const ArenaValue null;
+
+      ArenaValue();
+
+      ValueType type() const { return type_; }
+      bool isNull() const { return type_ == nullValue; }
+      bool isBool() const { return type_ == booleanValue; }
+      bool isInt() const { return type_ == intValue; }
+      bool isUInt() const { return type_ == uintValue; }
+      bool isIntegral() const;
+      bool isDouble() const { return type_ == realValue; }
+      bool isNumeric() const { return isIntegral() || isDouble(); }
+      bool isString() const { return type_ == stringValue; }
+      bool isArray() const { return type_ == arrayValue; }
+      bool isObject() const { return type_ == objectValue; }
+
+      bool asBool() const;
+      Int asInt() const;
+      UInt asUInt() const;
+      double asDouble() const;
+      std::string asString() const;
+
+      /// Characters of a string, not zero terminated.
+      const char *data() const;
+      /// Length of a string.
+      unsigned length() const;
+      /// Compare a string like strcmp, other types are smaller than any text.
+      int compare( const char *text ) const;
+
+      /// Number of items in an array or members in an object.
+      unsigned size() const;
+      const ArenaValue &operator[]( unsigned index ) const;
+      const ArenaValue &operator[]( int index ) const;
+      const ArenaValue &operator[]( const char *key ) const;
+      const ArenaValue &operator[]( const std::string &key ) const;
+      /// Member of an object, NULL when missing.
+      const ArenaValue *find( const char *key, unsigned length ) const;
+      /// Name of a member in sorted order.
+      std::string memberName( unsigned index ) const;
+      /// Value of a member in sorted order.
+      const ArenaValue &member( unsigned index ) const;
+
+   private:
+      ValueType type_;
+      unsigned size_;
+      union
+      {
+         bool bool_;
+         Int int_;
+         UInt uint_;
+         double real_;
+         const char *string_;
+         const ArenaValue *items_;
+         const ArenaMember *members_;
+      } value_;
+   };
+
+   /** \brief Name and value of an object member, the name is not zero terminated.
+    */
+   struct ArenaMember
+   {
+      const char *name_;
+      unsigned length_;
+      ArenaValue value_;
+   };
+
+   /** \brief Parse a <a HREF="http://www.json.org">JSON</a> document into an Arena.
+    *
+    * Gives the same values as Reader for every document both accept, with
+    * comments and strings in double or single quotes. It is stricter on
+    * malformed arrays: Reader takes any token after an array item as the
+    * separator, here a missing ',' is an error. Trailing commas are
+    * rejected by both. The scratch stacks are kept between documents.
+    */
+   class JSON_API ArenaReader
+   {
+   public:
+      ArenaReader();
+
+      /** \brief Read a document.
+       * \param beginDoc Start of the text, must stay valid as long as the values.
+       * \param endDoc End of the text.
+       * \param arena Where nodes and decoded strings are allocated.
+       * \param root [out] Root value.
+       * \return \c true if the document was successfully parsed.
+       */
+      bool parse( const char *beginDoc, const char *endDoc,
+                  Arena &arena, ArenaValue &root );
+      bool parse( const std::string &document, Arena &arena, ArenaValue &root );
+
+      /// Error with line and column of the last failed parse.
+      std::string getFormattedErrorMessages() const;
+
+   private:
+      bool readValue( ArenaValue &value, int depth );
+      bool readObject( ArenaValue &value, int depth );
+      bool readArray( ArenaValue &value, int depth );
+      bool readString( const char *&text, unsigned &length );
+      bool readNumber( ArenaValue &value );
+      bool skipSpaces();
+      bool match( const char *pattern, int patternLength );
+      bool addError( const std::string &message, const char *location );
+
+      Arena *arena_;
+      const char *begin_;
+      const char *current_;
+      const char *end_;
+      std::vector<ArenaValue> items_;
+      std::vector<ArenaMember> members_;
+      std::string error_;
+      const char *errorLocation_;
+   };
+
+} // namespace Json
+
+#endif // CPPTL_JSON_ARENA_H_INCLUDED
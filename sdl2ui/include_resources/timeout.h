@@ -68,9 +68,13 @@ public:
 	bool expired(void);
 	void setExpired(void);
 	static unsigned long GetTickCount();
+	static int nextDeadline();
 	void stop();
 	int elapsed(void);
 
+private:
+	void arm( bool armed);
+
 private:
 	int m_startTime; ///< Start time value.
 	int m_timeout; ///< Time value.
@@ -83,6 +87,18 @@ private:
 
 extern void delay( double milisec);
 
+/** @brief Earliest of two deadlines.
+ *  @param a [in] Milliseconds, -1 is no deadline.
+ *  @param b [in] Milliseconds, -1 is no deadline.
+ *  @return Earliest deadline, -1 when both have none.
+ */
+inline int earliestDeadline( int a, int b)
+{
+	if ( a<0) return b;
+	if ( b<0) return a;
+	return ( a<b) ? a:b;
+}
+
 /*=============================================================================
 **      end of file
 **===========================================================================*/
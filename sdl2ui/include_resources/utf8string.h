@@ -40,9 +40,36 @@
 /*------------- Standard includes --------------------------------------------*/
 #include <vector>
 #include <string>
+#include <iterator>
+#include <stddef.h>
 
+/// @brief UTF-8 text with character access. Length and character offsets
+///        are found once and kept until the text changes.
 class utf8string
 {
+public:
+	/// @brief Walk over the characters of a string.
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef int value_type;
+		typedef ptrdiff_t difference_type;
+		typedef const int *pointer;
+		typedef int reference;
+
+		const_iterator( const char *p=NULL) : m_p(p) {}
+		int operator*() const { return utf8string::utf8character( m_p); }
+		const_iterator &operator++() { m_p +=utf8string::characterLength( m_p); return *this; }
+		const_iterator operator++(int) { const_iterator it(*this); ++(*this); return it; }
+		bool operator ==( const const_iterator &it) const { return m_p ==it.m_p; }
+		bool operator !=( const const_iterator &it) const { return m_p !=it.m_p; }
+		const char *position() const { return m_p; }
+
+	private:
+		const char *m_p; ///< Start of the current character.
+	};
+
 public:
 	utf8string( const std::string & s="");
 	utf8string( const char *s);
@@ -56,25 +83,36 @@ public:
 	std::string sub( size_t left, size_t right=-1);
 	void onlyAscii();
 	void sort();
-	operator std::string() { return m_string; }
+	operator std::string() const { return m_string; }
+	const std::string &str() const { return m_string; }
 	void firstCharacterCapital();
 	void toUpper();
 	void toLower();
 	const char *c_str() const;
-	void clear() { m_string.clear(); }
+	void clear() { m_string.clear(); changed(); }
 	void push_back( int n);
 	void push_back( const std::string &s);
 	void pop_back();
 	bool startWith( int cursor, const std::string &compare);
 	static int characterLength( const char *value);
 	static int utf8character( const char *value);
+	const_iterator begin() const { return const_iterator( m_string.c_str()); }
+	const_iterator end() const { return const_iterator( m_string.c_str()+getOffset( size())); }
+	bool containsAbove( int value) const;
+	bool isValid() const;
 
 private:
 	int utf8character( size_t index) const;
 	int getOffset( size_t cursor) const;
+	void analyse() const;
+	void changed();
 
-public:
-	std::string			m_string;
+private:
+	std::string			m_string;	///< UTF-8 bytes.
+	mutable int			m_length;	///< Characters, -1 when not known yet.
+	mutable bool		m_ascii;	///< Every character is one byte.
+	mutable std::vector<int> m_offsets; ///< Byte offset per character and the end.
+	mutable int			m_valid;	///< Valid UTF-8: 1 yes, 0 no, -1 not known yet.
 };
 
 bool strfind( const char *s1, const char *s2);
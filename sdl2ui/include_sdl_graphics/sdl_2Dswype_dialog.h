@@ -63,6 +63,9 @@ public: // New functions.
 	virtual void makeSureIndexVisible( int index, int time);
 	virtual bool scrollToIndex( int index, int time);
 
+protected:
+	virtual int tileCount();
+
 private:
 	virtual void calculateSurfacePosition();
 	virtual void paintSurfaceTop();
@@ -46,10 +46,13 @@ typedef struct
 {
 	CdialogObject 	*object;	// What object to use
 	bool		  	pressed;	// true=press, false=release
-	int				last_time;	// time of invalidate
+	bool			painted;	// The press is painted
 	unsigned int	startTime;  // Press or release start
+	int				factor;		// Glow from the last tick
 } StouchInfo;
 
+/// @brief Objects glowing after a touch. Each object knows its slot, so a
+///        lookup is O(1); update() advances all glows once per frame.
 class CafterGlowList : public CmyLock
 {
 public:
@@ -58,15 +61,21 @@ public:
 
 public:
 	unsigned int elapsed();
+	static unsigned int now();
 
 	bool update( bool pressed, const Cpoint &mouse);
 	bool getFactor( CdialogObject *object, int *factor);
 	void clear();
 	int size();
+	int nextDeadline();
 	void addObject( CdialogObject *object);
 
 private:
-	std::vector<StouchInfo> m_info;
-	unsigned int m_time_now; ///< Current time
-	unsigned int m_last_time; ///< Previous call
+	void remove( int slot);
+	unsigned int nextChange( const StouchInfo &ti);
+
+private:
+	std::vector<StouchInfo> m_info; ///< Dense list, object->m_glow is the index.
+	unsigned int m_time_now; ///< Time of the last tick
+	unsigned int m_last_time; ///< Previous call of elapsed()
 };
@@ -35,6 +35,7 @@
 #include "sdl_dialog_object.h"
 #include "sdl_graphics.h"
 #include "sdl_rect.h"
+#include "sdl_raster.h"
 
 /// @brief  Fill pattern.
 typedef enum
@@ -79,10 +80,14 @@ public:
 	void setBorderWidth( int width) { m_borderWidth=width; }
 	void setCode( keybutton key) { m_key=key; }
 	colour getColour() { return m_col1; }
+	colour getColour2() { return m_col2; }
+	EfillType getFillStyle() { return m_pattern; }
 	void setCorner(int cr) { m_pieCorner =cr%360; }
+	int getCorner() { return m_pieCorner; }
 
 private:
 	colour calcColour( colour col1, colour col2, double fraction);
+	bool onPaintRaster( colour col1, colour col2);
 
 private:
 	colour	  	m_col1;			///< Fill colour.
@@ -93,6 +98,7 @@ private:
 	std::string m_image;		///< Background for button.
 	int m_R1, m_G1, m_B1, m_R2, m_G2, m_B2;
 	int			m_pieCorner;	///< Corner pie.
+	Craster		m_raster;		///< Pixels of the last fill.
 public:
 	int			m_borderWidth;  ///< To reduce the painting.
 };
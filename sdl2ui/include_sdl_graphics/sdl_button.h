@@ -46,6 +46,7 @@
 #include "sdl_text.h"
 #include "sdl_label.h"
 #include "sdl_image.h"
+#include "sdl_look_cache.h"
 
 /// @brief  Forward declaration.
 class Cdialog;
@@ -157,6 +158,7 @@ public:
 	{ m_background.setCorner( corner ); m_background.setFillStyle( FILL_PIE ); }
 
 private:
+	void	paintLook( int touch);
 	void 	paintBackground( int touch);
 	void	paintBorder( EborderType border, int spacing, int radius, int touch);
 	void 	paintText( const std::string &text, int touch);
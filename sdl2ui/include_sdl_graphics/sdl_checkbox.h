@@ -81,7 +81,14 @@ public:
 
 public:
 	bool isChecked() { return m_checked; }
-	void setChecked(bool state) { m_checked=state; }
+	void setChecked(bool state)
+	{
+		if ( state !=m_checked)
+		{
+			m_checked=state;
+			invalidate();
+		}
+	}
 	void onPaint(int touch);
 
 private:
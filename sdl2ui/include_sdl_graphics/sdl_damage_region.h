@@ -0,0 +1,74 @@
+/*============================================================================*/
+/**  @file       sdl_damage_region.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Keep the parts of the screen that must be painted again.
+ **
+ **  Invalidated rectangles are merged into a short list, so a frame only
+ **  repaints and presents the damaged area.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CdamageRegion
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <vector>
+#include "sdl_rect.h"
+
+/// Above this number of rectangles, we use one rectangle around all.
+#define MAXIMUM_DAMAGE_RECTS	8
+
+/// @brief List of damaged rectangles in pixels.
+class CdamageRegion
+{
+public:
+	CdamageRegion();
+	virtual ~CdamageRegion();
+	void setBounds( const Crect &bounds);
+	void add( const Crect &rect);
+	void addAll();
+	void clear();
+	bool isEmpty() const { return m_rects.empty() && !m_full; }
+	bool isFull() const { return m_full; }
+	bool overlap( const Crect &rect) const;
+	int area() const;
+	const std::vector<Crect> &rects() const { return m_rects; }
+
+private:
+	static Crect join( const Crect &a, const Crect &b);
+	static int area( const Crect &rect) { return rect.width()*rect.height(); }
+
+private:
+	std::vector<Crect>	m_rects;	///< Damage, never overlapping after add().
+	Crect				m_bounds;	///< Screen size.
+	bool				m_full;		///< Everything is damaged.
+};
+
+/* DAMAGE_REGION_H_ */
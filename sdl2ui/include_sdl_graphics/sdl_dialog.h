@@ -53,6 +53,7 @@
 #include "sdl_key_file.h"
 #include "sdl_dialog_list.h"
 #include "sdl_after_glow.h"
+#include "sdl_hit_grid.h"
 #include "sdl_drag_object.h"
 #include "sdl_world_interface.h"
 
@@ -90,6 +91,7 @@ public:
 	void insertDragObject();
 
 	virtual bool onInit();
+	void prefetch( const std::vector<std::string> &images);
 	virtual void onUpdate() =0;
 	virtual void onPaint() =0;
 	virtual void onCleanup() =0;
@@ -97,6 +99,7 @@ public:
 	virtual void onDrag( const Cpoint &position) { (void)position; }
 	virtual void onDragRelease( const Cpoint &position, CdialogObject * movingObject); // 800x600
 	virtual bool onLoop();
+	virtual int nextDeadline();
 	virtual void stop(int exitValue);
 
 	virtual void onInputFocus();
@@ -117,6 +120,7 @@ public:
 	virtual bool isRunning() { return m_running; }
 	virtual void onClearScreen();
 	virtual void invalidate( bool needs_repaint=true);
+	void invalidateRect( const Crect &rect);
 	virtual bool isInvalidated();
 	virtual void invalidateAll();
 	virtual void setBackgroundColour( colour colour);
@@ -143,6 +147,8 @@ public:
 
 protected:
 	void onPaintButtons();
+	void onPaintButtons( const Crect &rect);
+	void onClearScreen( const Crect &rect);
 	Cpoint dragPoint( const Cpoint &mouse);
 
 	Cdialog       * findDialog( const Cpoint &p);
@@ -201,6 +207,7 @@ protected:
 
 public:
 	CafterGlowList		m_touchList;		///< List for touched objects
+	ChitGrid			m_hitGrid;			///< Objects per screen area.
 	std::shared_ptr<Cgraphics> 	m_graphics;		///< Graphics layer from world.
 	std::shared_ptr<Cgraphics>  m_myGraphics; ///< My private Graphics layer.
 	bool				m_render_after_paint;///< Paint only when we render.
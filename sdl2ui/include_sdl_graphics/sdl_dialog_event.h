@@ -41,8 +41,9 @@
 #include <string>
 #include <SDL.h>
 #include <pthread.h>
-#include <queue>
+#include <deque>
 #include <vector>
+#include <atomic>
 #include <singleton.h>
 
 #include "sdl_font.h"
@@ -152,22 +153,47 @@ public:
 	int			which;
 };
 
-/// @brief Queue for events.
+/// Number of events in the queue, must be a power of two.
+#define EVENT_QUEUE_SIZE	256
+/// Keep the reader and writer position on their own cache line.
+#define CACHE_LINE_SIZE		64
+
+/// @brief One place in the event queue.
+typedef struct SeventSlot
+{
+	SeventSlot() : state( 0), event( EVENT_INVALID, Cpoint(0,0), false) {}
+	std::atomic<int>	state;	///< Free, published, reading or merging.
+	Cevent				event;	///< The event.
+} SeventSlot;
+
+/// @brief Queue for events, one thread writes and one thread reads.
+///        No locks, a mouse move is merged with the last move not read yet.
 class CeventQueue
 {
 public:
 	CeventQueue();
 	~CeventQueue();
 	void push_back( const Cevent &event);
-	Cevent front();
-	void pop_front();
+	bool pop( Cevent &event);
+	int drain( std::deque<Cevent> &events, int maximum =EVENT_QUEUE_SIZE);
+	void clear();
 	int size();
 	bool empty();
+	int overflows() { return m_overflows.load(); }
+	int merged() { return m_merged.load(); }
+
+private:
+	bool merge( const Cevent &event);
 
 private:
-	int m_size;
-	std::queue<Cevent> m_eventList; ///< All events in queue.
-	CmyLock m_lock; ///< Lock for this queue.
+	SeventSlot			m_slots[EVENT_QUEUE_SIZE]; ///< All events in queue.
+	char				m_padSlots[CACHE_LINE_SIZE];
+	std::atomic<unsigned int> m_head; ///< Next to read, written by the reader.
+	char				m_padHead[CACHE_LINE_SIZE-sizeof(std::atomic<unsigned int>)];
+	std::atomic<unsigned int> m_tail; ///< Next to write, written by the writer.
+	char				m_padTail[CACHE_LINE_SIZE-sizeof(std::atomic<unsigned int>)];
+	std::atomic<int>	m_overflows; ///< Events lost because the queue was full.
+	std::atomic<int>	m_merged; ///< Mouse moves merged.
 };
 
 /// @brief Interface for keyboard/mouse events.
@@ -209,6 +235,9 @@ public:
 	EpollStatus pollEvent( CeventInterface *callback);
 	virtual void stop() { CmyThread::stop(); }
 	virtual void work();
+	bool waitEvent( int timeout);
+	void wakeUp();
+	int nextDeadline();
 	void stopDrag();
 	Cpoint lastMouse() { return m_lastMousePos; }
 	bool pressMouse() { return m_isPressed; }
@@ -232,6 +261,7 @@ private:
 	void handleMouseRelease( CeventInterface *callback, const Cevent &c);
 	void handleMouseLong( CeventInterface *callback, const Cevent &c);
 	void handleMouseMove( CeventInterface *callback, const Cevent &c);
+	void signalEvents();
 
 private:
 	CeventInterface		*m_interface;		///< Which interface is active.
@@ -247,6 +277,7 @@ private:
 	int					m_repeatDelay;		///< Delay for repeat.
 	int					m_repeatSpeed;		///< Speed for repeat.
 	CeventQueue			m_events;			///< Events to send.
+	std::deque<Cevent>	m_batch;			///< Events taken from the queue, not handled.
 	int					m_repeatCount;		///< Time to repeat.
 	Ctimeout 			m_keyPress;			///< Time to repeat.
 	Ctimeout			m_mousePress;		///< Time to press mouse.
@@ -263,6 +294,9 @@ private:
 	Cpoint				m_press;			///< Where we press the screen.
 	bool				m_isPressed;		///< Is the mouse pressed?
 	bool				m_longDebounced;	///< Long debounce time.
+	pthread_mutex_t		m_waitMutex;		///< Protects waiting for new events.
+	pthread_cond_t		m_eventAdded;		///< Input thread queued events.
+	bool				m_wakeUp;			///< Stop waiting without input.
 public:
 	bool				m_idiot;			///< Idiot test.
 	Cpoint				m_debugPosition;	///< Position to debug
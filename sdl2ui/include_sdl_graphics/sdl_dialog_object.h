@@ -85,8 +85,8 @@ public:
 	virtual void onPaint( const Cpoint &p, int touch);
 	void enableDrag() { m_dragEnable=true; }
 	void enablePainting() { m_painting=true; }
-	void setRect( const Crect &rect) { m_rect=rect; }
-	void setLeft( int left) { m_rect.setLeft(left); }
+	void setRect( const Crect &rect);
+	void setLeft( int left);
 	int height() { return m_rect.height(); }
 	int width() { return m_rect.width(); }
 	int left() { return m_rect.left(); }
@@ -107,6 +107,9 @@ public:
 	virtual bool wheelUp() { return false; }
 	virtual bool wheelDown() { return false; }
 	virtual void onUpdate();
+	void invalidate();
+	void invalidate( const Crect &rect);
+	void setTouchKey();
 public:
 	Crect		m_rect; ///< Rectangle.
 	keybutton 	m_code;		///< Code for keys.
@@ -115,6 +118,7 @@ public:
 	bool		m_visible; ///< are we there?
 	std::shared_ptr<Cgraphics> m_graphics; ///< where to paint.
 	Cdialog		*m_parent; ///< dialog on top.
+	int			m_glow; ///< Slot in the after-glow list of the dialog, -1 when not glowing.
 };
 
 typedef std::vector<CdialogObject*> dialogObjectList;
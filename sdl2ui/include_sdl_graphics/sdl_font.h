@@ -35,6 +35,8 @@
 #include "SDL_ttf.h"
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include "my_thread.h"
 //#include "zhongcan_defines.h"
 
 /// @brief structure to put loaded fonts in an array for quick access.
@@ -45,6 +47,28 @@ typedef struct
 	TTF_Font		*font;
 } SsingleFont;
 
+/// @brief File, size and style of one opened font.
+typedef struct SfontKey
+{
+	std::string		name;	///< File in the font path.
+	int				pixels;	///< Size.
+	int				style;	///< Bold, italic etc.
+
+	bool operator ==( const SfontKey &key) const
+	{
+		return pixels ==key.pixels && style ==key.style && name ==key.name;
+	}
+} SfontKey;
+
+/// @brief Hash for the font registry.
+struct SfontKeyHash
+{
+	size_t operator()( const SfontKey &key) const
+	{
+		return std::hash<std::string>()( key.name) ^ (size_t)(key.pixels*131+key.style);
+	}
+};
+
 /// @brief structure to put loaded fonts in an array for quick access.
 typedef struct
 {
@@ -63,11 +87,15 @@ public:
 	operator Sfont () { return m_font; }
 	TTF_Font *font();
 	static void closeFonts();
+	static int preload( const std::string &manifest);
+	static TTF_Font *styled( TTF_Font *font, int style);
 
 private:
-	static SsingleFont findFont( const std::string &fontName, int pixels);
+	static SsingleFont findFont( const std::string &fontName, int pixels, int style=TTF_STYLE_NORMAL);
 
-	static std::vector<SsingleFont> m_fonts;
+	static std::unordered_map<SfontKey, SsingleFont, SfontKeyHash> m_fonts; ///< All opened fonts.
+	static std::unordered_map<TTF_Font*, SfontKey> m_keys; ///< Key of every opened font.
+	static CmyLock m_lock; ///< Fonts are found from more threads.
 	Sfont  m_font;
 };
 
@@ -41,6 +41,7 @@
 #include <vector>
 #include <deque>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <SDL_image.h>
 #include <SDL_video.h>
@@ -51,6 +52,7 @@
 #include "sdl_types.h"
 #include "sdl_rect.h"
 #include "sdl_touch.h"
+#include "sdl_texture_pool.h"
 
 #ifdef USE_SDL2
 typedef SDL_Texture sdlTexture;
@@ -68,6 +70,10 @@ typedef int language;
 typedef int textId;
 #define INVALID_TEXT_ID -1
 
+/// All registered images
+typedef int imageId;
+#define INVALID_IMAGE_ID -1
+
 /// Colours by default.
 enum Ecolours
 {
@@ -156,8 +162,13 @@ typedef void (*external_loop_func)();
 /// We keep a record of all images inside our program and release it at exit.
 typedef struct
 {
-	sdlTexture *image;	///< Surface to paint.
+	sdlTexture *image;	///< Surface to paint, NULL when not loaded.
 	std::string	name;		///< Filename without path.
+	int			bytes;		///< Memory used by the image.
+	int			users;		///< Reference count, never evicted when >0.
+	unsigned int last_used;	///< Image clock at last paint.
+	bool		missing;	///< File cannot be loaded, do not try again.
+	bool		decoding;	///< Waiting for a decoder thread.
 } SimageSurface;
 
 typedef struct
@@ -238,6 +249,18 @@ typedef struct
 	int touch_debounce_distance;
 	int debug_coordinates;
 	int touch_debounce_long_time;
+	int text_cache_size; ///< Bytes for rendered text, 0 disables the cache.
+	int text_cache_hits; ///< Texts painted from the cache.
+	int text_cache_misses; ///< Texts rendered again.
+	int image_cache_size; ///< Bytes for unused images, 0 is unlimited.
+	int image_decode_threads; ///< Threads to decode images, 0 loads on paint.
+	int damage_tracking; ///< Repaint only invalidated parts of a simple dialog.
+	int painted_pixels; ///< Pixels painted in the last frame.
+	int maximum_idle_time; ///< Longest wait for input in msec when nothing runs.
+	int raster_fill; ///< Fill backgrounds in a pixel buffer, 0 paints pixel by pixel.
+	int look_cache_size; ///< Bytes for painted button backgrounds, 0 disables the cache.
+	std::string font_manifest; ///< Fonts to open at start, in the font path. Empty opens them on first use.
+	int debug_profiler; ///< Show frame times and the slowest objects, needs USE_PROFILER.
 
 	// functions
 	get_translation_func get_translation;
@@ -251,11 +274,18 @@ typedef struct
 	external_loop_func external_loop; /// External main loop over all dialogs
 } Sdefaults;
 
+/// @brief Where the main screen is painted.
+typedef enum
+{
+	GRAPHICS_WINDOW,	///< SDL window with an accelerated renderer.
+	GRAPHICS_HEADLESS	///< Software renderer on a memory surface, no display needed.
+} EgraphicsBackend;
+
 /// @brief Graphics routines for SDL layer.
 class Cgraphics
 {
 public:
-	Cgraphics( const Csize &size, bool mainScreen);
+	Cgraphics( const Csize &size, bool mainScreen, EgraphicsBackend backend=GRAPHICS_WINDOW);
 	virtual ~Cgraphics();
 	bool init( const std::string &caption ="", int pixels=32, int colour=-1 );
 	void close();
@@ -269,6 +299,7 @@ public:
 
 	void line( int x1, int y1, int x2, int y2);
 	void imageLine( const std::string &image, int x1, int y1, int x2, int y2);
+	void imageLine( imageId id, int x1, int y1, int x2, int y2);
 	//void paint();
 	void lock();
 	void unlock();
@@ -279,11 +310,20 @@ public:
 	bool renderTexture( SDL_Texture *surface, int x, int y, int w, int h);
 	bool insertTexture( SDL_Texture *texture, int left, int top, int w, int h);
 	bool renderGraphics( Cgraphics *graphics, const Crect &rect);
+	int uploadSurface( SDL_Surface *surface, int handle=INVALID_TEXTURE_HANDLE);
+	bool renderHandle( int handle, int x, int y, int w=-1, int h=-1);
+	void releaseHandle( int handle);
+	bool isHeadless() { return m_backend ==GRAPHICS_HEADLESS; }
+	SDL_Surface *readPixels();
+	bool savePng( const std::string &fname);
+	int compareGolden( const std::string &fname);
 #endif
 	bool renderSurface( SDL_Surface *surface, int x1, int y1);
 	bool renderSurface( SDL_Surface *surface, int x, int y, int w, int h);
+	bool renderPart( sdlTexture *texture, const SDL_Rect &source, const SDL_Rect &destination);
 	void lock_keycodes() { m_lock_keycode =true; }
 	void unlock_keycodes() { m_lock_keycode =false; }
+	bool keycodesLocked() { return m_lock_keycode; }
 	void update();
 	bool front();
 	bool pop_back();
@@ -298,6 +338,7 @@ public:
 	void moverel(int dx, int dy);
 	void moveto(int x, int y);
 	bool image( const std::string &fname, int x1, int y1, int x2, int y2);
+	bool image( imageId id, int x1, int y1, int x2, int y2);
 	bool imageColour( const std::string &fname, int x1, int y1, int x2, int y2, colour col);
 	bool imageInverse( const std::string &fname, int x1, int y1, int x2, int y2, colour col);
 	void linerel(int dx, int dy);
@@ -313,7 +354,15 @@ public:
 	void clean();
 	bool setRenderArea( sdlTexture *texture );
 	int getOffsetX() { return m_pixelOffset.x; }
+	Cpoint getPixelOffset() { return m_pixelOffset; }
 	sdlTexture *findImage( const std::string &fname);
+	sdlTexture *findImage( imageId id);
+	imageId findImageId( const std::string &fname);
+	imageId acquireImage( const std::string &fname);
+	void releaseImage( imageId id);
+	void prefetchImage( const std::string &fname);
+	bool isDecoding( imageId id);
+	bool collectImages();
 	void update( const Crect &rect);
 	Ctouch m_touch;	///< Touch control.
 	void freeImage( const std::string &image);
@@ -323,6 +372,10 @@ public:
 protected:
 	void mapword(int x1, int x2, int y);
 	void mapvword(int x, int y1, int y2);
+	bool loadImage( SimageSurface &image);
+	void destroyImage( SimageSurface &image);
+	void evictImages( imageId keep);
+	void decodeImage( imageId id);
 
 private:
 	std::vector<SDL_Surface*> m_bitmap; ///< Bitmaps to paint on.
@@ -330,13 +383,21 @@ private:
 	SDL_Window   *m_window; ///< Video screen.
 	SDL_Renderer *m_renderer; ///< Renders a window.
 	SDL_Texture  *m_texture; ///< Where to paint on.
+	SDL_Surface  *m_screen; ///< Memory screen for the headless backend.
+	CtexturePool m_pool; ///< Streaming textures to upload surfaces.
+	std::vector<SDL_Texture*> m_layers; ///< Saved screens, see push_back().
 #else
 	SDL_Surface *m_allocatedSurface; ///< Surface to paint on.
 	SDL_Surface *m_renderSurface; ///< Where to render to.
 #endif
 
 	std::deque<Uint32*> m_background; ///< Backgrounds to use.
-	std::vector<SimageSurface> m_images; ///< Images to use.
+	std::vector<SimageSurface> m_images; ///< Images to use, index is the imageId.
+	std::unordered_map<std::string, imageId> m_imageIds; ///< Find image by name.
+	int m_imageBytes; ///< Memory used by all loaded images.
+	unsigned int m_imageClock; ///< Counts image paints for LRU.
+	int m_imageOwner; ///< Our number for the image decoders.
+	int m_decoding; ///< Images waiting for a decoder.
 	int m_colour; ///< Colour.
 	int m_topLayer; ///< Top layer.
 	int m_cx,m_cy;
@@ -351,6 +412,7 @@ private:
 	bool m_lock_keycode;
 	int m_bits; ///< Bits per pixel.
 	int m_option; ///< 0=window, 1=full, 2=invisible
+	EgraphicsBackend m_backend; ///< Window or memory surface.
 	Uint32 *m_pixels;
 
 public:
@@ -0,0 +1,94 @@
+/*============================================================================*/
+/**  @file       sdl_hit_grid.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Find the object or key under a touch position.
+ **
+ **  Every dialog divides the screen in cells of 8x8 touch squares. A cell
+ **  knows which objects overlap it, so a touch only tests a few objects.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              ChitGrid
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <vector>
+#include <map>
+#include "sdl_keybutton.h"
+#include "sdl_rect.h"
+#include "my_thread.h"
+
+/// Width and height of one cell in touch squares (64 pixels).
+#define HIT_GRID_CELL	8
+
+class CdialogObject;
+
+/// @brief One object in the grid.
+typedef struct ShitEntry
+{
+	ShitEntry( CdialogObject *o, const Crect &r, int z)
+	: object( o), rect( r), order( z), keyed( false) {}
+	CdialogObject	*object;	///< Object to find.
+	Crect			rect;		///< Rectangle in the cells, in touch squares.
+	int				order;		///< Paint order, highest is on top.
+	bool			keyed;		///< Object painted its key code.
+} ShitEntry;
+
+/// @brief Uniform grid with the objects of one dialog.
+class ChitGrid
+{
+public:
+	ChitGrid();
+	virtual ~ChitGrid();
+	void setSize( const Csize &size);
+	void add( CdialogObject *object);
+	void remove( CdialogObject *object);
+	void update( CdialogObject *object);
+	bool setKeyed( CdialogObject *object);
+	CdialogObject *findObject( const Cpoint &p);
+	bool findKey( const Cpoint &p, keybutton &key);
+	void clear();
+
+private:
+	void insertCells( ShitEntry *entry);
+	void removeCells( ShitEntry *entry);
+	bool cellRange( const Crect &rect, int &c1, int &r1, int &c2, int &r2);
+	ShitEntry *topMost( const Cpoint &p, bool keyed);
+
+private:
+	std::map<CdialogObject*, ShitEntry*>	m_entries;	///< All objects.
+	std::vector< std::vector<ShitEntry*> >	m_cells;	///< Objects per cell.
+	int		m_columns;	///< Cells from left to right.
+	int		m_rows;		///< Cells from top to bottom.
+	int		m_order;	///< Next paint order.
+	CmyLock	m_lock;		///< Touch is found from the event thread.
+};
+
+/* SDL_HIT_GRID_H_ */
@@ -88,6 +88,7 @@ private:
 private:
 	Egravity			m_imageAlign; ///< Align of image.
 	std::string			m_image;	///< Image name.
+	imageId				m_imageId;	///< Image kept in the graphics.
 	std::string			m_press;    ///< Image when pressed.
 	Cdialog				*m_parent;	///< Parent dialog for the icon.
 public:
@@ -0,0 +1,102 @@
+/*============================================================================*/
+/**  @file       sdl_image_loader.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Decode images in the background.
+ **
+ **  Worker threads load image files into surfaces, the main thread only
+ **  uploads the finished surfaces to the graphics.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CimageLoader, CimageDecoder
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <pthread.h>
+#include <SDL_image.h>
+#include "singleton.h"
+#include "my_thread.h"
+
+/// @brief Image to decode.
+typedef struct
+{
+	int			owner;		///< Which graphics asked for it.
+	int			id;			///< Image identifier inside the owner.
+	std::string	path;		///< Full file name.
+	SDL_Surface	*surface;	///< Result, NULL when the file cannot be loaded.
+} SimageJob;
+
+class CimageLoader;
+
+/// @brief One worker thread.
+class CimageDecoder : public CmyThread
+{
+public:
+	CimageDecoder( CimageLoader *loader);
+	virtual ~CimageDecoder();
+	virtual void work();
+
+private:
+	CimageLoader *m_loader; ///< Where to get jobs.
+};
+
+/// @brief Queue of images to decode, shared by all graphics.
+class CimageLoader : public Tsingleton<CimageLoader>
+{
+friend class Tsingleton<CimageLoader>;
+
+public:
+	CimageLoader();
+	virtual ~CimageLoader();
+	static int newOwner();
+	void request( int owner, int id, const std::string &path);
+	bool collect( int owner, std::vector<SimageJob> &done);
+	void cancel( int owner);
+	bool next( SimageJob &job, int timeout);
+	void finished( SimageJob &job);
+
+private:
+	void startThreads();
+
+private:
+	std::deque<SimageJob>	m_jobs;		///< Waiting for a decoder.
+	std::vector<SimageJob>	m_done;		///< Waiting for the main thread.
+	std::set<int>			m_owners;	///< Graphics that still want results.
+	std::vector<CimageDecoder*> m_decoders; ///< Worker threads.
+	pthread_mutex_t			m_mutex;	///< Protect the queues.
+	pthread_cond_t			m_wakeup;	///< New job available.
+	static int				m_lastOwner; ///< Unique owner number.
+};
+
+/* IMAGE_LOADER_H_ */
@@ -3,12 +3,13 @@
  **  @ingroup   user_interface
  **  @brief		Record key buttons.
  **
- **  Record key button info.
+ **  Record key button info in a binary journal and play it back.
  **
  **  @author     mensfort
  **
  **  @par Classes:
  **              CkeyFile
+ **              CkeyReplay
  */
 /*------------------------------------------------------------------------------
  ** Copyright (C) 2011, 2014, 2015
@@ -40,30 +41,100 @@
 /*------------- Standard includes --------------------------------------------*/
 #include <sdl_keybutton.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <vector>
 #ifdef USE_SDL2
 #include "SDL_events.h"
 #else
 #include "SDL_events.h"
 #endif
+#include "my_thread.h"
+#include "singleton.h"
 
 class Cevent;
 
-/// @brief  Create and display buttons.
-class CkeyFile
+/// Records kept in memory, when full new events are lost.
+#define KEY_FILE_RING		4096
+
+/// Milliseconds between two writes of the journal.
+#define KEY_FILE_FLUSH_TIME	200
+
+/// First word of a journal, "KEY1".
+#define KEY_FILE_MAGIC		0x3159454b
+
+/// @brief Kind of recorded event.
+typedef enum
 {
-	FILE *m_file;
+	KEY_RECORD_KEYDOWN,
+	KEY_RECORD_KEYUP,
+	KEY_RECORD_MOTION,
+	KEY_RECORD_BUTTON_DOWN,
+	KEY_RECORD_BUTTON_UP,
+	KEY_RECORD_TOUCH_LONG,
+	KEY_RECORD_WHEELUP,
+	KEY_RECORD_WHEELDOWN,
+} EkeyRecord;
+
+/// @brief One event in the journal, 16 bytes on disk.
+typedef struct
+{
+	uint32_t	time;	///< Msec since the recording started.
+	uint16_t	type;	///< What happened, see EkeyRecord.
+	uint16_t	mod;	///< Key modifiers.
+	int32_t		value1;	///< Key or x-position.
+	int32_t		value2;	///< Y-position.
+} SkeyRecord;
 
+/// @brief  Record all input, a thread writes it to disk.
+class CkeyFile : public CmyThread
+{
 public:
 	CkeyFile();
 	~CkeyFile();
 
 	void init();
 	void close();
-	void addEvent( const std::string &event, int value1, int value2, const std::string &comment);
+	void addEvent( EkeyRecord type, int value1, int value2, int mod=0);
 	void onEvent(const SDL_Event *event);
 	void onEvent(const Cevent &event);
+	virtual void work();
+	/// @return Events not recorded because the ring was full.
+	int lost() { return m_lost; }
 
 private:
+	void flush();
+
+private:
+	FILE *m_file;
 	bool m_mouseDown; ///< If no mouse pressed, then forget mouse move events.
+	unsigned int m_start; ///< Msec when the recording started.
+	std::vector<SkeyRecord> m_ring; ///< Events waiting for the writer.
+	std::vector<SkeyRecord> m_write; ///< Events being written.
+	int m_head; ///< Oldest event in the ring.
+	int m_count; ///< Events in the ring.
+	int m_lost; ///< Events lost on a full ring.
 };
 
+/// @brief  Play a journal back through Sdefaults::get_test_event.
+class CkeyReplay : public Tsingleton<CkeyReplay>
+{
+	friend class Tsingleton<CkeyReplay>;
+
+public:
+	bool open( const std::string &fname, double speed=1.0);
+	void close();
+	bool nextEvent( SDL_Event &event);
+	static bool getTestEvent( SDL_Event &event);
+	/// @return True when all events are given.
+	bool isFinished() { return m_next>=(int)m_records.size(); }
+
+private:
+	CkeyReplay();
+	virtual ~CkeyReplay();
+
+private:
+	std::vector<SkeyRecord> m_records; ///< Entire journal, times in one range.
+	int m_next; ///< Next event to give.
+	double m_speed; ///< 1.0 is original timing, 0 as fast as possible.
+	unsigned int m_start; ///< Msec when the replay started.
+};
@@ -463,6 +463,7 @@ class Ckeybutton
 public:
 	Ckeybutton( keybutton n) { m_key =n; }
 	Ckeybutton( const std::string &str);
+	Ckeybutton( const char *str, size_t length);
 	operator std::string();
 	operator keybutton();
 	std::string label();
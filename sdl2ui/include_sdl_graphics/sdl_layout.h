@@ -0,0 +1,206 @@
+/*============================================================================*/
+/**  @file       sdl_layout.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Compile JSON dialog layouts to a binary form.
+ **
+ **  A JSON layout is resolved once into packed records: types, gravity,
+ **  borders, fills, keys and colours become numbers and all defaults taken
+ **  over from the previous object are filled in. The records and a string
+ **  table are saved in a versioned file, which is memory-mapped later.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              ClayoutCompiler
+ **              ClayoutFile
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "sdl_button.h"
+#include "sdl_image.h"
+#include "json_arena.h"
+
+/// First word of a compiled layout, "LAY1".
+#define LAYOUT_MAGIC		0x3159414c
+
+/// Change when SlayoutRecord changes.
+#define LAYOUT_VERSION		1
+
+/// Added to the JSON file name for the compiled layout.
+#define LAYOUT_EXTENSION	".lay"
+
+/// @brief Object to create from a record.
+typedef enum
+{
+	LAYOUT_NONE,
+	LAYOUT_IMAGE,
+	LAYOUT_BUTTON,
+	LAYOUT_BOTTOM_BUTTON,
+	LAYOUT_CALCULATOR_BUTTON,
+	LAYOUT_HEADER_BUTTON,
+	LAYOUT_BACKGROUND,
+	LAYOUT_TEXT
+} ElayoutType;
+
+/// Record has a label.
+#define LAYOUT_HAS_LABEL		0x01
+/// Record has a text id to look up.
+#define LAYOUT_HAS_ID			0x02
+/// Record has a text colour to look up.
+#define LAYOUT_HAS_TEXT_COLOUR	0x04
+
+/// @brief Start of a compiled layout.
+typedef struct
+{
+	uint32_t	magic;		///< LAYOUT_MAGIC.
+	uint16_t	version;	///< LAYOUT_VERSION.
+	uint16_t	recordSize;	///< Bytes per SlayoutRecord.
+	uint32_t	records;	///< Records after the header.
+	uint32_t	strings;	///< Bytes in the string table after the records.
+} SlayoutHeader;
+
+/// @brief One object with all values resolved, strings are offsets in the string table.
+typedef struct
+{
+	uint8_t		type;		///< ElayoutType.
+	uint8_t		gravity;	///< Egravity.
+	uint8_t		fill;		///< EfillType.
+	uint8_t		border;		///< EborderType.
+	int32_t		left;		///< Rectangle.
+	int32_t		top;
+	int32_t		width;
+	int32_t		height;
+	int32_t		code;		///< keybutton.
+	int32_t		margin;		///< Image margin.
+	int32_t		radius;		///< Corner radius.
+	int32_t		borderWidth;///< Background border, 0 keeps the default.
+	int32_t		colour1;	///< Background colours.
+	int32_t		colour2;
+	uint32_t	flags;		///< LAYOUT_HAS_...
+	uint32_t	icon;		///< Image or icon.
+	uint32_t	label;		///< Label below an image or button.
+	uint32_t	font;		///< Font name.
+	uint32_t	text;		///< Fixed text.
+	uint32_t	id;			///< Text id, looked up with find_text_id.
+	uint32_t	textColour;	///< Colour name, looked up with find_colour.
+} SlayoutRecord;
+
+/// @brief Turn a JSON layout into records.
+class ClayoutCompiler
+{
+public:
+	ClayoutCompiler();
+	bool compile( const std::string &description);
+	bool save( const std::string &fname);
+	/// @return Number of records from the last compile.
+	int size() { return (int)m_records.size(); }
+	/// @return One record.
+	const SlayoutRecord &record( int index) { return m_records[index]; }
+	/// @return String table.
+	const char *strings() { return &m_strings[0]; }
+	static std::string compiledName( const std::string &fname);
+
+private:
+	void decode( const Json::ArenaValue &root);
+	uint32_t addString( const std::string &text);
+	std::string decodeString( const Json::ArenaValue &root, const char *key, uint32_t flag, SlayoutRecord &record);
+	void decodeText( const Json::ArenaValue &root, SlayoutRecord &record);
+	void decodeImage( const Json::ArenaValue &root, SlayoutRecord &record);
+	void decodeBackground( const Json::ArenaValue &root, SlayoutRecord &record);
+	void decodeButton( const Json::ArenaValue &root, SlayoutRecord &record);
+
+	// Find variables of one type
+	Egravity decodeGravity( const Json::ArenaValue &root, Egravity &gravity);
+	EborderType decodeBorder( const Json::ArenaValue &root, EborderType &border);
+	Crect decodeRect( const Json::ArenaValue &root);
+	keybutton decodeKeybutton( const Json::ArenaValue &root);
+	int decodeMargin( const Json::ArenaValue &root);
+	std::string decodeIcon( const Json::ArenaValue &root);
+	std::string decodeLabel( const Json::ArenaValue &root);
+	EfillType decodeFillType( const Json::ArenaValue &root, EfillType &fill);
+	int decodeBorderWidth( const Json::ArenaValue &root, int &borderWidth);
+	std::string decodeFont( const Json::ArenaValue &root, const std::string &name);
+	colour decodeColour1( const Json::ArenaValue &root);
+	colour decodeColour2( const Json::ArenaValue &root);
+	int decodeRadius( const Json::ArenaValue &root, int &lastvalue);
+
+private:
+	Json::Arena		m_arena;		///< Nodes of the parsed json.
+	Json::ArenaReader m_reader;		///< Needed for parsing json.
+	Json::ArenaValue m_root;		///< Needed for parsing json.
+	std::vector<SlayoutRecord> m_records; ///< Resolved objects.
+	std::vector<char> m_strings;	///< All strings, each ends with a zero.
+	std::unordered_map<std::string, uint32_t> m_offsets; ///< Strings already in the table.
+
+private:
+	int				m_lastCode;		///< Last code for next button
+	Crect			m_lastRect;		///< Last rectangle for next button
+	EborderType 	m_buttonBorder;	///< Default button border
+	EborderType		m_lastBorder;	///< Last border for next button
+	Egravity		m_buttonGravity;///< Default button gravity
+	Egravity		m_imageGravity; ///< Default image gravity
+	int				m_lastMargin;	///< Last margin for next button
+	std::string		m_lastLabel;	///< Last label
+	std::string		m_lastType;     ///< Last type
+	int				m_lastColour1;	///< Last colour type
+	int				m_lastColour2;	///< Last colour type
+	EfillType		m_lastButtonFill;		///< Last fill type
+	int				m_lastBackgroundRadius; ///< Radius for backgrounds
+	int				m_lastBackgroundBorderWidth; ///< Width border
+	EfillType		m_lastBackgroundFill; ///< Fill type
+	int				m_lastButtonRadius; ///< Radius calculate
+};
+
+/// @brief Memory-mapped compiled layout.
+class ClayoutFile
+{
+public:
+	ClayoutFile();
+	~ClayoutFile();
+	bool open( const std::string &fname);
+	void close();
+	static bool isUpToDate( const std::string &compiled, const std::string &source);
+	/// @return Number of records.
+	int size() { return m_header ? (int)m_header->records:0; }
+	/// @return One record.
+	const SlayoutRecord &record( int index) { return m_records[index]; }
+	/// @return String table.
+	const char *strings() { return m_strings; }
+
+private:
+	void *m_map; ///< Mapped file.
+	size_t m_length; ///< Bytes mapped.
+	const SlayoutHeader *m_header; ///< Start of the file.
+	const SlayoutRecord *m_records; ///< Records after the header.
+	const char *m_strings; ///< String table after the records.
+};
@@ -0,0 +1,132 @@
+/*============================================================================*/
+/**  @file       sdl_look_cache.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Keep painted button backgrounds between frames.
+ **
+ **  The background fill and border of a button are painted once in a
+ **  texture per look. Buttons with the same size, colours, border and
+ **  touch level share the texture.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              ClookCache
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <list>
+#include <map>
+#include "singleton.h"
+#include "my_thread.h"
+#include "sdl_graphics.h"
+#include "sdl_background.h"
+#include "sdl_rectangle.h"
+
+/// Touch levels between not pressed and fully pressed.
+#define LOOK_TOUCH_STEPS	8
+
+/// @brief Everything that changes the background and border of a button.
+typedef struct SlookKey
+{
+	void		*renderer;	///< Renderer owning the texture.
+	int			width;		///< Width in pixels.
+	int			height;		///< Height in pixels.
+	EfillType	fill;		///< Fill pattern.
+	int			radius;		///< Corner radius.
+	colour		fill1;		///< First fill colour.
+	colour		fill2;		///< Second fill colour.
+	int			corner;		///< Pie corner.
+	EborderType	border;		///< Border type.
+	colour		border1;	///< First border colour.
+	colour		border2;	///< Second border colour.
+	colour		shadow;		///< Button shadow colour.
+	int			spacing;	///< Space around the button.
+	bool		background;	///< Background is painted.
+	int			touch;		///< Quantized touch level.
+
+	bool operator <( const SlookKey &key) const
+	{
+		if ( renderer !=key.renderer) return renderer <key.renderer;
+		if ( width !=key.width) return width <key.width;
+		if ( height !=key.height) return height <key.height;
+		if ( fill !=key.fill) return fill <key.fill;
+		if ( radius !=key.radius) return radius <key.radius;
+		if ( fill1 !=key.fill1) return fill1 <key.fill1;
+		if ( fill2 !=key.fill2) return fill2 <key.fill2;
+		if ( corner !=key.corner) return corner <key.corner;
+		if ( border !=key.border) return border <key.border;
+		if ( border1 !=key.border1) return border1 <key.border1;
+		if ( border2 !=key.border2) return border2 <key.border2;
+		if ( shadow !=key.shadow) return shadow <key.shadow;
+		if ( spacing !=key.spacing) return spacing <key.spacing;
+		if ( background !=key.background) return background <key.background;
+		return touch <key.touch;
+	}
+} SlookKey;
+
+#ifdef USE_SDL2
+/// @brief One painted look.
+typedef struct
+{
+	SDL_Texture	*texture;	///< Background and border.
+	std::list<SlookKey>::iterator lru;	///< Position in the LRU list.
+} Slook;
+
+/// @brief Cache of painted button looks, least recently used is removed first.
+class ClookCache : public Tsingleton<ClookCache>
+{
+friend class Tsingleton<ClookCache>;
+
+public:
+	ClookCache();
+	virtual ~ClookCache();
+	bool paint( const SlookKey &key, Cgraphics *graphics, int left, int top);
+	bool begin( const SlookKey &key, Cgraphics *graphics);
+	void end( const SlookKey &key, Cgraphics *graphics);
+	void clear();
+	int bytes() { return m_bytes; }
+	static int quantize( int touch);
+
+private:
+	void evict( int budget);
+
+private:
+	std::map<SlookKey, Slook>	m_looks;	///< All painted looks.
+	std::list<SlookKey>			m_lru;		///< Most recent at front.
+	int							m_bytes;	///< Memory used now.
+	CmyLock						m_lock;		///< Protect the lists.
+	SDL_Texture					*m_painting; ///< Texture between begin() and end().
+	SDL_Texture					*m_target;	///< Render target before begin().
+	SDL_Rect					m_viewport;	///< Viewport before begin().
+	SDL_Rect					m_clip;		///< Clipping before begin().
+	Cpoint						m_offset;	///< Pixel offset before begin().
+};
+#endif
+
+/* LOOK_CACHE_H_ */
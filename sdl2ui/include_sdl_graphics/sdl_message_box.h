@@ -39,6 +39,7 @@
 
 /*------------- Standard includes --------------------------------------------*/
 #include <string>
+#include <pthread.h>
 #include "sdl_keybutton.h"
 #include "sdl_dialog.h"
 #include "timeout.h"
@@ -73,6 +74,10 @@ typedef enum
   MB_TEXT_CENTER=0x400000,
 } Ebutton;
 
+class CmessageBox;
+
+/// @brief Called once when an opened message box closes, exitValue is MB_OK, MB_QUIT or the stop() value.
+typedef void (*message_box_result_func)( CmessageBox *box, int exitValue, void *context);
 
 class CmessageBox : public Cdialog
 {
@@ -87,6 +92,7 @@ public:
 
 public:
 	virtual int onExecute( Cdialog *parent);
+	void open( message_box_result_func done, void *context=NULL);
 	virtual bool onInit();
 	virtual void onUpdate();
 	virtual void onPaint();
@@ -105,6 +111,11 @@ private:
 	Ctimeout m_timer;
  	bool m_push;
 	int  m_flags;
+	bool m_modal;						///< Opened, keys do not reach the dialog below.
+	message_box_result_func m_done;		///< Continuation after closing.
+	void *m_context;					///< Data for m_done.
+	pthread_mutex_t m_closeMutex;		///< Protects m_running for other threads.
+	pthread_cond_t  m_closed;			///< Signalled when the box closes.
 
 protected:
 	std::string m_text;
@@ -113,6 +124,9 @@ protected:
 	keybutton m_key;
 
 private:
+	void initClose();
 	void setFlags( int FLAGS);
+	void close( int exitValue);
+	void display();
 };
 
@@ -0,0 +1,161 @@
+/*============================================================================*/
+/**  @file       sdl_profiler.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Frame profiler.
+ **
+ **  Time scopes of the main loop and painting, show them on screen and
+ **  write them as a Chrome trace. Only compiled with USE_PROFILER.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              Cprofiler
+ **              CprofileScope
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <typeinfo>
+#include "my_thread.h"
+#include "singleton.h"
+
+#ifdef USE_PROFILER
+
+/// Scopes kept per thread, the oldest are overwritten.
+#define PROFILE_RING		8192
+
+/// Frames kept for the histogram.
+#define PROFILE_FRAMES		128
+
+/// Slowest objects kept of the last frame.
+#define PROFILE_TOP			5
+
+/// @brief What a scope measures.
+typedef enum
+{
+	PROFILE_KIND_SCOPE,		///< Part of the work.
+	PROFILE_KIND_IDLE,		///< Waiting, not counted as busy time.
+	PROFILE_KIND_OBJECT		///< Paint of one dialog object.
+} EprofileKind;
+
+/// @brief One finished scope, 40 bytes.
+typedef struct
+{
+	const char		*name;		///< Static text, not copied.
+	const void		*object;	///< Painted object, NULL for other scopes.
+	int				key;		///< Key of the object.
+	EprofileKind	kind;		///< What is measured.
+	uint64_t		start;		///< Usec on the monotonic clock.
+	uint32_t		duration;	///< Usec.
+} SprofileScope;
+
+class CprofileRing;
+
+/// @brief Collect scopes of all threads, summarize the frames of the main thread.
+class Cprofiler : public Tsingleton<Cprofiler>
+{
+	friend class Tsingleton<Cprofiler>;
+
+public:
+	static uint64_t now();
+	void add( EprofileKind kind, const char *name, const void *object, int key,
+			  uint64_t start, uint64_t end);
+	void frame();
+	bool dump( const std::string &fname);
+	int frames();
+	uint32_t frameTime( int age);
+	/// @return Slowest objects of the last frame, slowest first.
+	const std::vector<SprofileScope> &slowest() { return m_top; }
+	static const char *className( const char *name);
+
+private:
+	Cprofiler();
+	virtual ~Cprofiler();
+	CprofileRing *threadRing();
+
+private:
+	CmyLock		m_lock;			///< Protects the list of rings.
+	std::vector<CprofileRing*> m_rings; ///< One for each thread, never removed.
+	uint64_t	m_start;		///< Usec when the profiler started, 0 in the trace.
+	uint64_t	m_lastFrame;	///< Usec of the last frame mark.
+	unsigned int m_frameFirst;	///< First scope of the running frame.
+	std::vector<uint32_t> m_frames; ///< Busy usec of the last frames.
+	int			m_frameCount;	///< Frames measured.
+	std::vector<SprofileScope> m_top; ///< Slowest objects of the last frame.
+};
+
+/// @brief Measure from construction to destruction.
+class CprofileScope
+{
+public:
+	CprofileScope( const char *name, EprofileKind kind=PROFILE_KIND_SCOPE,
+				   const void *object=NULL, int key=0)
+	: m_name( name)
+	, m_object( object)
+	, m_key( key)
+	, m_kind( kind)
+	, m_start( Cprofiler::now())
+	{
+	}
+	~CprofileScope()
+	{
+		Cprofiler::Instance()->add( m_kind, m_name, m_object, m_key, m_start, Cprofiler::now());
+	}
+
+private:
+	const char		*m_name;	///< Static text.
+	const void		*m_object;	///< Painted object or NULL.
+	int				m_key;		///< Key of the object.
+	EprofileKind	m_kind;		///< What is measured.
+	uint64_t		m_start;	///< Usec at construction.
+};
+
+#define PROFILE_JOIN2(a,b)		a##b
+#define PROFILE_JOIN(a,b)		PROFILE_JOIN2(a,b)
+/// Time the rest of the block.
+#define PROFILE_SCOPE(name)		CprofileScope PROFILE_JOIN(profileScope,__LINE__)( name)
+/// Time the rest of the block as waiting.
+#define PROFILE_IDLE(name)		CprofileScope PROFILE_JOIN(profileScope,__LINE__)( name, PROFILE_KIND_IDLE)
+/// Time the rest of the block as paint of a dialog object.
+#define PROFILE_OBJECT(object)	CprofileScope PROFILE_JOIN(profileScope,__LINE__)( \
+									typeid(*(object)).name(), PROFILE_KIND_OBJECT, (object), (object)->getKey())
+/// End a frame and start the next, call in the main thread.
+#define PROFILE_FRAME()			Cprofiler::Instance()->frame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_IDLE(name)
+#define PROFILE_OBJECT(object)
+#define PROFILE_FRAME()
+
+#endif
@@ -63,6 +63,7 @@ private:
 	void 	paintBackground();
 	void	paintBorder();
 	void	paintImage();
+	Crect	timeRect();
 
 private:
 	Ctimeout	m_timer;
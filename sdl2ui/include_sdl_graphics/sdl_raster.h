@@ -0,0 +1,90 @@
+/*============================================================================*/
+/**  @file       sdl_raster.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Software fill of rounded backgrounds.
+ **
+ **  A background is filled in a pixel buffer with SSE2 or AVX2 when the
+ **  processor has it, and copied to the screen in one go.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              Craster
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <vector>
+#include <SDL.h>
+#include "sdl_graphics.h"
+
+/// @brief Kernels used to fill the buffer.
+typedef enum
+{
+	RASTER_SCALAR,	///< Plain C++.
+	RASTER_SSE2,	///< 4 pixels at once.
+	RASTER_AVX2,	///< 8 pixels at once.
+	RASTER_BEST		///< Best the processor can do.
+} ErasterLevel;
+
+/// @brief ARGB pixel buffer with rounded corners.
+class Craster
+{
+public:
+	Craster();
+	virtual ~Craster();
+	void setSize( int width, int height, int radius);
+	void fillRows( const std::vector<Uint32> &rowColours);
+	void fillCircular( colour col, double maxDistance);
+	void fillPie( colour col1, colour col2, double corner);
+	bool paint( Cgraphics *graphics, int x, int y);
+	int width() { return m_width; }
+	int height() { return m_height; }
+	const Uint32 *pixels() { return m_pixels.empty() ? NULL:&m_pixels[0]; }
+
+	static ErasterLevel level();
+	static ErasterLevel bestLevel();
+	static void setLevel( ErasterLevel level);
+	static const char *levelName( ErasterLevel level);
+
+private:
+	void clearRow( int y);
+	void releaseHandle();
+
+private:
+	std::vector<Uint32>	m_pixels;	///< ARGB, transparent outside the corners.
+	std::vector<int>	m_inset;	///< First painted pixel per row.
+	int					m_width;	///< Width in pixels.
+	int					m_height;	///< Height in pixels.
+	int					m_radius;	///< Corner radius in pixels.
+	Cgraphics			*m_graphics; ///< Graphics owning the texture.
+	int					m_handle;	///< Texture with the last paint.
+	static ErasterLevel	m_level;	///< Kernels in use.
+};
+
+/* SDL_RASTER_H_ */
@@ -72,7 +72,7 @@ public:
 	virtual void onPaint( int touch);
 	void	setCode( keybutton key);
 	EborderType getBorder() { return m_border; }
-	void 	setBorder( EborderType border) { m_border=border; }
+	void 	setBorder( EborderType border) { m_border=border; invalidate(); }
 	void    setFillStyle( EfillType pattern);
 	void 	paintBorder();
 
@@ -74,7 +74,12 @@ public:
 
 	virtual void setValue( double y)
 	{
-		m_value =gLimit( y, m_minimum, m_maximum-m_itemsOnScreen);
+		double value =gLimit( y, m_minimum, m_maximum-m_itemsOnScreen);
+		if ( value !=m_value)
+		{
+			m_value =value;
+			invalidate();
+		}
 	}
 	double getValue() { return m_value; }
 	int getInt() { return (int)(m_value+0.5); }
@@ -46,6 +46,7 @@
 #include <string>
 #include <vector>
 #include "text_splitter.h"
+#include "sdl_text_script.h"
 #include "my_thread.h"
 
 /// @brief Create a text surface for printing, display etc.
@@ -60,11 +61,11 @@ public:
 			      Egravity gravity,
 			      colour textColour,
 			      colour cursorColour,
-			      TTF_Font *font);
+			      const StextFonts &fonts);
 
 	// For printer
 	CtextSurface( const std::string &text,
-			      TTF_Font *font,
+			      const StextFonts &fonts,
 			      const Csize &size,
 			      Egravity gravity);
 
@@ -77,10 +78,11 @@ public:
 private:
 	void setColour( colour text, colour back);
 	void clean();
-	void createSurfaces( TTF_Font *font);
+	void createSurfaces();
 	void createSurface();
 	void renderSurfaces();
-	SDL_Surface * blend( utf8string &text, SDL_Color fg, TTF_Font *font, bool split);
+	void layoutSurfaces( std::vector<SDL_Rect> &positions);
+	SDL_Surface * blend( utf8string &text, SDL_Color fg, bool split);
 	void setCursor( int cursor) { m_cursor =cursor; }
 	// For printer.
 	void calculateSize( TTF_Font *font);
@@ -102,6 +104,7 @@ private:
 	int 		 m_cursor;
 	bool		 m_owner; ///< Should I remove the graphics in the end?
 	bool 		 m_blend;
+	StextFonts	 m_fonts; ///< Font per script.
 	static CmyLock m_lock;
 };
 
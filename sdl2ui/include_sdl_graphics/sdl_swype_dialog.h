@@ -45,32 +45,24 @@
 #endif
 #include "sdl_dialog.h"
 
-/// @brief Structure to hold each texture to paint. We have a queue of this.
+/// @brief One tile slot in the swype atlas. Slots are recycled, never freed while scrolling.
 class CswypeObject
 {
 public:
-	CswypeObject( sdlTexture *texture, int index, const Crect &destination)
-	: item(NULL), texture(texture), index(index), itemId(0), destination(destination){}
-	virtual ~CswypeObject()
-	{
-		clean();
-	}
-	void clean()
-	{
-#ifdef USE_SDL2
-#else
-		if (texture) SDL_FreeSurface(texture);
-		texture =NULL;
-#endif
-	}
+	CswypeObject()
+	: item(NULL), texture(NULL), index(-1), itemId(0), slot(0,0,0,0), ahead(false) {}
+	CswypeObject( sdlTexture *texture, int index, const Crect &slot)
+	: item(NULL), texture(texture), index(index), itemId(0), slot(slot), ahead(false) {}
+	virtual ~CswypeObject() {}
 	void onPaint( Cpoint &point);
 
 public:
 	CdialogObject 		*item; ///< Reference to object (if needed)
-	sdlTexture	 		*texture; ///< Painted area
-	int			  		index; ///< Index in the list
+	sdlTexture	 		*texture; ///< Atlas with the painted area, owned by the dialog.
+	int			  		index; ///< Row or unit painted in this slot, -1 when empty.
 	int					itemId; ///< Item to use.
-	Crect				destination; ///< Where to paint the object should be multiplied by 8.
+	Crect				slot; ///< Area inside the atlas, should be multiplied by 8.
+	bool				ahead; ///< Painted before it was visible, not shown yet.
 };
 
 /// @brief Element in the list to scroll.
@@ -83,23 +75,73 @@ class IscrollElement
 
 #define MEASUREMENTS  	10
 
-/// @brief Speeding class.
+/// Time between two scroll steps when the dialog moves by itself.
+#define SWYPE_FRAME_TIME	16
+
+/// Maximum height in pixels of one column of tiles in the atlas.
+#define SWYPE_ATLAS_PIXELS	2048
+
+/// Maximum width in pixels of an atlas, when the renderer has no limit.
+#define SWYPE_ATLAS_WIDTH	0x7FFF
+
+/// Milliseconds per frame to paint rows before they are visible.
+#define SWYPE_PRERENDER_TIME	4
+
+/// Frames to look ahead when predicting the scroll position.
+#define SWYPE_PREDICT_FRAMES	8
+
+/// @brief Statistics of painting rows ahead.
+typedef struct
+{
+	int		rendered; ///< Rows painted before they were visible.
+	int		served; ///< Rows shown from a tile painted ahead.
+	int		demand; ///< Rows painted while the display waited for them.
+} SswypeStats;
+
+/// Seconds of drag samples used to estimate the release speed.
+#define SPEEDING_WINDOW		0.1
+
+/// Fixed time step in seconds for the fling, equal for every frame rate.
+#define SPEEDING_STEP		(1.0/240.0)
+
+/// Most steps integrated in one call, a longer stall is skipped.
+#define SPEEDING_MAX_STEPS	240
+
+/// Spring constant (1/s^2) pulling back an overscroll or onto a row.
+#define SPEEDING_SPRING		150.0
+
+/// Speed in pixels per second below which the fling settles on a row.
+#define SPEEDING_SNAP_SPEED	120.0
+
+/// @brief Kinetic scrolling. Speed from the drag samples, then a fling with
+///        friction, overscroll spring and snap to a row on a monotonic clock.
 class Cspeeding
 {
 public:
 	Cspeeding();
 	virtual ~Cspeeding() {}
 	void addPosition( double position);
+	bool step( double &position, double maximum, double snap);
 	double getSpeed();
-	void clear() { m_measurements=0; }
+	bool isMoving();
+	void clear();
+	static double now();
+
+private:
+	double velocity();
+	void integrate( double &position, double maximum, double snap);
 
 private:
-	int			m_measurements;
-	double		m_position[MEASUREMENTS];
-	double		m_speed[MEASUREMENTS];
-	double		m_time[MEASUREMENTS];
-	double		m_friction;
-	int			m_previousTime;
+	int			m_measurements; ///< Drag samples in the ring.
+	int			m_head; ///< Newest drag sample.
+	double		m_position[MEASUREMENTS]; ///< Scroll offset of each sample.
+	double		m_time[MEASUREMENTS]; ///< Time of each sample in seconds.
+	double		m_decay; ///< Speed left after one step of friction.
+	double		m_velocity; ///< Fling speed in pixels per second.
+	double		m_clock; ///< Time integrated up to.
+	double		m_target; ///< Edge or row to settle on.
+	bool		m_flinging; ///< Moving without a finger.
+	bool		m_settling; ///< Spring towards m_target.
 };
 
 /// @brief Decide what to paint.
@@ -134,9 +176,10 @@ public:
 	int m_sizes; ///< Number of elements in the list.
     double m_scroll; ///< Amount of scroll.
     double m_speed; ///< Speed scroll;
-    std::vector<CswypeObject*> m_swypeObjects;
-    int m_validBuffers; ///< Increasing amount of object buffers
-    int m_visibleBuffers; ///< Number of visible object buffers
+    std::vector<CswypeObject> m_tiles; ///< Ring of tiles, unit n lives in slot n%size.
+    std::vector<sdlTexture*> m_atlases; ///< Textures shared by the tiles.
+    int m_validBuffers; ///< Number of tile slots in the atlases.
+    int m_visibleBuffers; ///< Number of slots painted, from m_firstUnitPainted.
     int m_firstUnitPainted; ///< First row painted inside the (paintedArea/textures).
     int m_lastUnitPainted; ///< last row painted in the (paintedArea/textures).
     int m_firstVisibleUnit; ///< First item/row on display
@@ -157,6 +200,10 @@ protected:
 	int			m_moveTime; ///< time to move from start to end.
 	double		m_dialogSpeed; ///< Speed dialog.
 	bool		m_repaint; ///< Paint again.
+	bool		m_ahead; ///< Tiles left to paint ahead.
+	bool		m_snap; ///< A fling stops on a row.
+	bool		m_preRendering; ///< Painting a tile before it is visible.
+	SswypeStats	m_stats; ///< How well painting ahead works.
 	bool		m_dragEnable; ///< Can move the button around.
 	int			m_dragIndex; ///< Index of object to drag.
 	CdialogObject *m_object; ///< Need a pointer to any object.
@@ -187,6 +234,7 @@ public:
 
 	Estatus onButton( keymode mod, keybutton sym);
 	virtual bool onLoop();
+	virtual int nextDeadline();
 	virtual void topStop();
 	virtual void wheelDown( int mx, int my);
 	virtual void wheelUp( int mx, int my);
@@ -198,6 +246,7 @@ public:
 	virtual void invalidate( int row);
 	virtual void setCursor( int index);
 	void enableDrag( bool drag) { m_dragEnable=drag; }
+	void enableSnap( bool snap) { m_snap=snap; }
 	virtual bool isScrollDragDialog( const Cpoint &p) { (void)p; return m_dragEnable; }
 	virtual bool isHorizontalScrollDialog( const Cpoint &p) { (void)p; return m_horizontal; }
 	int getDragIndex() { return m_dragIndex; }
@@ -206,12 +255,25 @@ public:
 	void setMargin( double margin) { m_endMargin =(int)( margin*8.0f*itemBlocks()); }
 	CswypeObject *insertAtBegin();
     CswypeObject *insertAtEnd();
+	CswypeObject *tile( int unit);
+	bool paintAhead();
+	const SswypeStats &preRenderStats() { return m_stats; }
+	void clearStats();
 	
 protected:
 	void clearSpeed();
+	void setScroll( double position);
 	virtual void onPaintSurfaceHorizontal( bool optional);
 	virtual void onPaintSurfaceVertical( bool optional);
 	virtual void renderCopy( sdlTexture *surface, SDL_Rect *rect);
+	virtual void renderCopy( CswypeObject *obj, SDL_Rect *rect);
+	virtual int tileCount();
+	bool allocateTiles();
+	bool createAtlases( int count, int perColumn, int perRow);
+	void atlasLimits( int &width, int &height);
+	void paintTile( CswypeObject *obj);
+	double predictScroll();
+	void predictUnits();
 	sdlTexture *createSurface();
 	sdlTexture *createSurface( int w, int h);
 
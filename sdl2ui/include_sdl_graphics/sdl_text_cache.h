@@ -0,0 +1,126 @@
+/*============================================================================*/
+/**  @file       sdl_text_cache.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Keep rendered text lines between frames.
+ **
+ **  Cache for the finished line layout of a CtextSurface. The same text in
+ **  the same font, colour and rectangle is painted from the cache instead of
+ **  being split, measured and rendered again.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtextCache
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include "SDL_ttf.h"
+#include "singleton.h"
+#include "my_thread.h"
+#include "sdl_graphics.h"
+#include "sdl_dialog_object.h"
+
+/// @brief Everything that changes the look of a rendered text.
+typedef struct StextKey
+{
+	TTF_Font	*font;		///< Font, includes file and size.
+	TTF_Font	*fallback;	///< Font for Chinese characters.
+	int			style;		///< Bold, italic etc.
+	colour		textColour;	///< Colour of the characters.
+	colour		cursorColour; ///< Colour of the cursor.
+	int			width;		///< Width of the rectangle in pixels.
+	int			height;		///< Height of the rectangle in pixels.
+	Egravity	gravity;	///< Alignment in the rectangle.
+	int			cursor;		///< Cursor position or -1.
+	std::string	text;		///< What to display.
+
+	bool operator <( const StextKey &key) const
+	{
+		if ( font !=key.font) return font <key.font;
+		if ( fallback !=key.fallback) return fallback <key.fallback;
+		if ( style !=key.style) return style <key.style;
+		if ( textColour !=key.textColour) return textColour <key.textColour;
+		if ( cursorColour !=key.cursorColour) return cursorColour <key.cursorColour;
+		if ( width !=key.width) return width <key.width;
+		if ( height !=key.height) return height <key.height;
+		if ( gravity !=key.gravity) return gravity <key.gravity;
+		if ( cursor !=key.cursor) return cursor <key.cursor;
+		return text <key.text;
+	}
+} StextKey;
+
+/// @brief One rendered line, position relative to the text rectangle.
+typedef struct
+{
+	sdlTexture	*texture;	///< Rendered line.
+	int			x;			///< Offset from the left.
+	int			y;			///< Offset from the top.
+	int			w;			///< Width in pixels.
+	int			h;			///< Height in pixels.
+} StextLine;
+
+/// @brief Finished layout for one text.
+typedef struct
+{
+	std::vector<StextLine>	lines;		///< All lines to paint.
+	int						bytes;		///< Memory used by the lines.
+	std::list<StextKey>::iterator lru;	///< Position in the LRU list.
+} StextLayout;
+
+/// @brief Cache of rendered text, least recently used is removed first.
+class CtextCache : public Tsingleton<CtextCache>
+{
+friend class Tsingleton<CtextCache>;
+
+public:
+	CtextCache();
+	virtual ~CtextCache();
+	bool paint( const StextKey &key, Cgraphics *graphics, int left, int top, bool count=true);
+	bool store( const StextKey &key, Cgraphics *graphics,
+			    const std::vector<SDL_Surface*> &surfaces,
+			    const std::vector<SDL_Rect> &positions);
+	void clear();
+	int bytes() { return m_bytes; }
+
+private:
+	void release( StextLayout &layout);
+	void evict( int budget);
+
+private:
+	std::map<StextKey, StextLayout>	m_layouts;	///< All cached texts.
+	std::list<StextKey>				m_lru;		///< Most recent at front.
+	int								m_bytes;	///< Memory used now.
+	CmyLock							m_lock;		///< Fonts are painted from more threads.
+};
+
+/* TEXT_CACHE_H_ */
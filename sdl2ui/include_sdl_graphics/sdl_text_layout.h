@@ -0,0 +1,131 @@
+/*============================================================================*/
+/**  @file       sdl_text_layout.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Break text into lines that fit a width.
+ **
+ **  Lines are broken at spaces with the advance of every character taken
+ **  from a table per font. The width of each prefix is summed once per
+ **  paragraph and the longest part that fits is found by binary search.
+ **  When the same fonts and width get a changed text, the lines before the
+ **  first changed paragraph are kept.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtextLayout
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <string>
+#include <vector>
+#include <map>
+#include "SDL_ttf.h"
+#include "singleton.h"
+#include "my_thread.h"
+#include "utf8string.h"
+#include "sdl_text_script.h"
+
+/// @brief One line after word wrap.
+typedef struct
+{
+	utf8string	text;		///< Characters on the line.
+	bool		split;		///< A word is broken at the end of this line.
+	int			characters;	///< Cursor positions used by this line.
+} SlayoutLine;
+
+/// Kerning is kept in a table for the printable ASCII characters.
+#define KERN_CHARACTERS	95
+
+/// @brief Advances of the characters in one font and style.
+typedef struct
+{
+	int					low[256];	///< Latin-1.
+	std::map<int,int>	high;		///< All others, filled when used.
+	bool				kerning;	///< Font uses kerning.
+	short				kern[KERN_CHARACTERS][KERN_CHARACTERS]; ///< Kerning from ' ' to '~'.
+} SglyphTable;
+
+/// @brief Fonts and width of a wrap.
+typedef struct SwrapKey
+{
+	TTF_Font	*local;		///< Font for local text.
+	TTF_Font	*cjk;		///< Font for Chinese text.
+	int			style;		///< Bold, italic etc.
+	int			width;		///< Width in pixels, 0 is no limit.
+
+	bool operator <( const SwrapKey &key) const
+	{
+		if ( local !=key.local) return local <key.local;
+		if ( cjk !=key.cjk) return cjk <key.cjk;
+		if ( style !=key.style) return style <key.style;
+		return width <key.width;
+	}
+} SwrapKey;
+
+/// @brief Result of the last wrap for one font and width.
+typedef struct
+{
+	std::vector<utf8string>		paragraphs;	///< Input text.
+	std::vector<int>			linesBefore; ///< Lines before each paragraph.
+	std::vector<std::string>	carry;		///< Text moved into each paragraph.
+	std::vector<SlayoutLine>	lines;		///< Wrapped lines.
+	int							stopped;	///< Paragraph where nothing fitted, or -1.
+} SwrapState;
+
+/// @brief Word wrap with cached glyph advances.
+class CtextLayout : public Tsingleton<CtextLayout>
+{
+friend class Tsingleton<CtextLayout>;
+
+public:
+	CtextLayout();
+	virtual ~CtextLayout();
+	int advance( TTF_Font *font, int character);
+	void prepare( TTF_Font *font);
+	void measure( const StextFonts &fonts, const utf8string &text, std::vector<int> &prefix);
+	void wrap( const StextFonts &fonts, int width,
+			   const std::vector<utf8string> &paragraphs,
+			   std::vector<SlayoutLine> &lines);
+	void clear();
+
+private:
+	int glyphAdvance( TTF_Font *font, int character);
+	SglyphTable &table( TTF_Font *font);
+	int kerning( TTF_Font *font, int previous, int character);
+	bool wrapParagraph( const StextFonts &fonts, int width, const utf8string &paragraph,
+			            std::vector<SlayoutLine> &lines, std::string &carry);
+	static int fitting( const std::vector<int> &prefix, int from, int to, int width);
+
+private:
+	std::map< std::pair<TTF_Font*,int>, SglyphTable>	m_glyphs; ///< Advances per font and style.
+	std::map< SwrapKey, SwrapState>						m_wraps;  ///< Last wrap per fonts and width.
+	CmyLock		m_lock;	///< Text is painted from more threads.
+};
+
+/* SDL_TEXT_LAYOUT_H_ */
@@ -0,0 +1,86 @@
+/*============================================================================*/
+/**  @file       sdl_text_script.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Choose the font per part of a text.
+ **
+ **  Chinese, Japanese and Korean characters are painted with the Chinese
+ **  font, everything else with the local font. A text is split in runs of
+ **  one script, each run is measured and rendered with its own font.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtextScript
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <string>
+#include <vector>
+#include "SDL_ttf.h"
+
+/// @brief Which font paints a character.
+typedef enum
+{
+	SCRIPT_LOCAL,	///< Latin, Cyrillic, symbols etc.
+	SCRIPT_CJK,		///< Chinese, Japanese and Korean.
+	SCRIPT_COUNT
+} Escript;
+
+/// @brief Part of a text in one script.
+typedef struct
+{
+	int		offset;	///< First byte.
+	int		bytes;	///< Number of bytes.
+	Escript	script;	///< Font to use.
+} StextRun;
+
+/// @brief Fonts to paint a text, one per script.
+typedef struct StextFonts
+{
+	StextFonts( TTF_Font *local=NULL, TTF_Font *cjk=NULL)
+	{
+		font[SCRIPT_LOCAL] =local;
+		font[SCRIPT_CJK] =cjk ? cjk:local;
+	}
+	TTF_Font *font[SCRIPT_COUNT]; ///< Font per script, never NULL when local is set.
+} StextFonts;
+
+/// @brief Split text in script runs, measure and render them.
+class CtextScript
+{
+public:
+	static Escript script( int character);
+	static void split( const std::string &text, std::vector<StextRun> &runs);
+	static bool single( const std::string &text, const StextFonts &fonts, TTF_Font **font);
+	static int size( const std::string &text, const StextFonts &fonts, int *w, int *h);
+	static SDL_Surface *render( const std::string &text, const StextFonts &fonts,
+			                    SDL_Color fg, bool blended);
+};
+
+/* SDL_TEXT_SCRIPT_H_ */
@@ -0,0 +1,94 @@
+/*============================================================================*/
+/**  @file       sdl_texture_pool.h
+ **  @ingroup    sdl2ui
+ **  @brief		 Re-use textures to upload surfaces.
+ **
+ **  Streaming textures are kept in buckets of power-of-two sizes. A surface
+ **  is copied into a free texture with SDL_UpdateTexture, instead of creating
+ **  and destroying a texture for every paint.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtexturePool
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+#pragma once
+
+/*------------- Standard includes --------------------------------------------*/
+#include <vector>
+#include <SDL_video.h>
+#ifdef USE_SDL2
+#include <SDL_surface.h>
+#include <SDL_render.h>
+#endif
+
+#define INVALID_TEXTURE_HANDLE	-1
+
+#ifdef USE_SDL2
+/// @brief One streaming texture in the pool.
+typedef struct
+{
+	SDL_Texture *texture;	///< Streaming texture, NULL when destroyed.
+	int			width;		///< Width of the bucket.
+	int			height;		///< Height of the bucket.
+	int			used_w;		///< Width of the surface inside.
+	int			used_h;		///< Height of the surface inside.
+	bool		busy;		///< Handle given to a user.
+	int			serial;		///< Part of the handle, stale handles do not match.
+	Uint32		last_used;	///< Ticks of the last upload or paint.
+} StextureSlot;
+
+/// @brief Pool of streaming textures for one renderer.
+class CtexturePool
+{
+public:
+	CtexturePool();
+	virtual ~CtexturePool();
+	void setRenderer( SDL_Renderer *renderer);
+	int upload( SDL_Surface *surface, int handle=INVALID_TEXTURE_HANDLE);
+	SDL_Texture *texture( int handle, SDL_Rect *source);
+	void release( int handle);
+	void clear();
+
+private:
+	static int bucket( int size);
+	int find( int width, int height);
+	int slotOf( int handle);
+	int handleOf( int slot);
+	void reclaim();
+	void trim();
+
+private:
+	std::vector<StextureSlot> m_slots; ///< Index is the handle.
+	SDL_Renderer *m_renderer; ///< Owner of the textures.
+	int			 m_free; ///< Slots with a texture but no user.
+	int			 m_serial; ///< Last serial given to a slot.
+};
+#endif
+
+/* TEXTURE_POOL_H_ */
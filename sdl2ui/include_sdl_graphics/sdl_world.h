@@ -48,10 +48,23 @@
 #include "sdl_world_interface.h"
 #include "sdl_dialog_list.h"
 #include "sdl_key_file.h"
+#include "sdl_damage_region.h"
 
 class Cdialog;
 class CmessageBox;
 
+/// Width of the profiler overlay in grid units of 8 pixels.
+#define PROFILE_OVERLAY_WIDTH	32
+
+/// Height of the frame histogram in pixels.
+#define PROFILE_OVERLAY_HEIGHT	64
+
+/// Usec shown by a full bar of the histogram.
+#define PROFILE_OVERLAY_RANGE	33333
+
+/// Usec for one frame at 60 frames per second.
+#define PROFILE_BUDGET			16667
+
 /// @brief Dialog on screen.
 class Cworld : public Iworld
 {
@@ -68,6 +81,9 @@ public:
 	void unregisterMessageBox(Cdialog *child);
 	void invalidateAll();
 	void notifyInvalidate();
+	void invalidateRect( const Crect &rect);
+	int nextDeadline( Cdialog *dialog);
+	void waitEvent( Cdialog *dialog);
 	void setActiveDialog( Cdialog *dialog);
 	bool onLoop();
 	void lock() { m_lock.lock(); }
@@ -77,6 +93,17 @@ public:
 	Cdialog *findDialog( const Cpoint &p);
 	void onRender();
 	void checkInMainThread();
+	bool inMainThread();
+
+private:
+	bool needsFullPaint();
+	void paintDamage();
+	void paintOverlays();
+	bool overlaysInvalidated();
+	void loopMessageBoxes();
+#ifdef USE_PROFILER
+	void paintProfiler();
+#endif
 
 public:
 	CdialogList	m_dialogs;
@@ -86,12 +113,13 @@ public:
 	static pthread_t	m_main_thread;
 	std::shared_ptr<Cgraphics> m_main_graph;
 	CmyLock m_lock;
-protected:
-	static CkeyFile		m_key_file;			///< File to repeat key pressed.
 
 private:
 	Cpoint		m_drag_point;		///< point to drag
 	bool		m_invalidate;		///< Need to repaint
+	bool		m_painting;			///< Damage is ignored while painting.
+	bool		m_frozen;			///< Screen below the message boxes is saved.
+	CdamageRegion m_damage;			///< Parts to repaint, in pixels.
 	static int 	m_init;				///< How many worlds?
 };
 
@@ -65,6 +65,8 @@ public:
 	virtual void unlock() = 0;
 	virtual void invalidateAll() = 0;
 	virtual void notifyInvalidate() = 0;
+	virtual void invalidateRect( const Crect &rect) = 0;
+	virtual void waitEvent( Cdialog *dialog) = 0;
 	virtual bool onLoop() = 0;
 	virtual void onCleanup() = 0;
 	virtual Estatus tryButton(keymode mod, keybutton sym) = 0;
@@ -72,6 +74,7 @@ public:
 	virtual void registerMessageBox(Cdialog *child) = 0;
 	virtual void unregisterMessageBox(Cdialog *child) = 0;
 	virtual void checkInMainThread() = 0;
+	virtual bool inMainThread() = 0;
 
 public:
 	std::shared_ptr<Cgraphics> m_main_graph;  ///< Main graph for this world
@@ -0,0 +1,835 @@
+/** @cond EXTERNAL */
+
+#include <json_arena.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Json {
+
+/// Deepest nesting accepted, protects the stack.
+static const int stackLimit = 1000;
+
+/// Alignment of everything taken from an arena.
+static const size_t arenaAlign = sizeof(double);
+
+// Implementation of class Arena
+// ////////////////////////////////
+
+Arena::Arena( size_t blockSize )
+   : blocks_( 0 )
+   , current_( 0 )
+   , end_( 0 )
+   , blockSize_( blockSize )
+   , blockCount_( 0 )
+   , used_( 0 )
+{
+}
+
+
+Arena::~Arena()
+{
+   while ( blocks_ )
+   {
+      Block *next = blocks_->next_;
+      free( blocks_ );
+      blocks_ = next;
+   }
+}
+
+
+void *
+Arena::allocate( size_t size )
+{
+   size = (size + arenaAlign - 1) & ~(arenaAlign - 1);
+   if ( size_t(end_ - current_) < size )
+   {
+      size_t header = (sizeof(Block) + arenaAlign - 1) & ~(arenaAlign - 1);
+      size_t blockSize = std::max( blockSize_, size + header );
+      Block *block = static_cast<Block *>( malloc( blockSize ) );
+      if ( block == 0 )
+         return 0;
+      block->next_ = blocks_;
+      block->size_ = blockSize;
+      blocks_ = block;
+      ++blockCount_;
+      current_ = reinterpret_cast<char *>( block ) + header;
+      end_ = reinterpret_cast<char *>( block ) + blockSize;
+   }
+   void *memory = current_;
+   current_ += size;
+   used_ += size;
+   return memory;
+}
+
+
+void
+Arena::clear()
+{
+   if ( blocks_ == 0 )
+      return;
+   while ( blocks_->next_ )
+   {
+      Block *next = blocks_->next_->next_;
+      free( blocks_->next_ );
+      blocks_->next_ = next;
+   }
+   size_t header = (sizeof(Block) + arenaAlign - 1) & ~(arenaAlign - 1);
+   current_ = reinterpret_cast<char *>( blocks_ ) + header;
+   end_ = reinterpret_cast<char *>( blocks_ ) + blocks_->size_;
+   used_ = 0;
+}
+
+
+// Implementation of class ArenaValue
+// ////////////////////////////////
+
+const ArenaValue ArenaValue::null;
+
+
+ArenaValue::ArenaValue()
+   : type_( nullValue )
+   , size_( 0 )
+{
+   value_.real_ = 0;
+}
+
+
+bool
+ArenaValue::isIntegral() const
+{
+   return type_ == intValue  ||  type_ == uintValue  ||  type_ == booleanValue;
+}
+
+
+bool
+ArenaValue::asBool() const
+{
+   switch ( type_ )
+   {
+   case booleanValue:
+      return value_.bool_;
+   case intValue:
+      return value_.int_ != 0;
+   case uintValue:
+      return value_.uint_ != 0;
+   case realValue:
+      return value_.real_ != 0.0;
+   case stringValue:
+   case arrayValue:
+   case objectValue:
+      return size_ != 0;
+   default:
+      return false;
+   }
+}
+
+
+ArenaValue::Int
+ArenaValue::asInt() const
+{
+   switch ( type_ )
+   {
+   case booleanValue:
+      return value_.bool_ ? 1 : 0;
+   case intValue:
+      return value_.int_;
+   case uintValue:
+      return Int( value_.uint_ );
+   case realValue:
+      return Int( value_.real_ );
+   default:
+      return 0;
+   }
+}
+
+
+ArenaValue::UInt
+ArenaValue::asUInt() const
+{
+   switch ( type_ )
+   {
+   case booleanValue:
+      return value_.bool_ ? 1 : 0;
+   case intValue:
+      return UInt( value_.int_ );
+   case uintValue:
+      return value_.uint_;
+   case realValue:
+      return UInt( value_.real_ );
+   default:
+      return 0;
+   }
+}
+
+
+double
+ArenaValue::asDouble() const
+{
+   switch ( type_ )
+   {
+   case booleanValue:
+      return value_.bool_ ? 1.0 : 0.0;
+   case intValue:
+      return value_.int_;
+   case uintValue:
+      return value_.uint_;
+   case realValue:
+      return value_.real_;
+   default:
+      return 0.0;
+   }
+}
+
+
+std::string
+ArenaValue::asString() const
+{
+   switch ( type_ )
+   {
+   case stringValue:
+      return std::string( value_.string_, size_ );
+   case booleanValue:
+      return value_.bool_ ? "true" : "false";
+   default:
+      return "";
+   }
+}
+
+
+const char *
+ArenaValue::data() const
+{
+   return type_ == stringValue ? value_.string_ : "";
+}
+
+
+unsigned
+ArenaValue::length() const
+{
+   return type_ == stringValue ? size_ : 0;
+}
+
+
+int
+ArenaValue::compare( const char *text ) const
+{
+   if ( type_ != stringValue )
+      return -1;
+   size_t length = strlen( text );
+   int result = memcmp( value_.string_, text, std::min( size_t(size_), length ) );
+   if ( result != 0 )
+      return result;
+   return size_ < length ? -1 : ( size_ > length ? 1 : 0 );
+}
+
+
+unsigned
+ArenaValue::size() const
+{
+   return ( type_ == arrayValue  ||  type_ == objectValue ) ? size_ : 0;
+}
+
+
+const ArenaValue &
+ArenaValue::operator[]( unsigned index ) const
+{
+   if ( type_ != arrayValue  ||  index >= size_ )
+      return null;
+   return value_.items_[index];
+}
+
+
+const ArenaValue &
+ArenaValue::operator[]( int index ) const
+{
+   if ( index < 0 )
+      return null;
+   return (*this)[ unsigned(index) ];
+}
+
+
+const ArenaValue &
+ArenaValue::operator[]( const char *key ) const
+{
+   const ArenaValue *value = find( key, unsigned( strlen( key ) ) );
+   return value ? *value : null;
+}
+
+
+const ArenaValue &
+ArenaValue::operator[]( const std::string &key ) const
+{
+   const ArenaValue *value = find( key.data(), unsigned( key.length() ) );
+   return value ? *value : null;
+}
+
+
+/// Order of member names: bytes first, then length.
+static int
+compareNames( const char *a, unsigned aLength, const char *b, unsigned bLength )
+{
+   int result = memcmp( a, b, std::min( aLength, bLength ) );
+   if ( result != 0 )
+      return result;
+   return aLength < bLength ? -1 : ( aLength > bLength ? 1 : 0 );
+}
+
+
+const ArenaValue *
+ArenaValue::find( const char *key, unsigned length ) const
+{
+   if ( type_ != objectValue )
+      return 0;
+   unsigned low = 0;
+   unsigned high = size_;
+   while ( low < high )
+   {
+      unsigned middle = low + (high - low) / 2;
+      const ArenaMember &member = value_.members_[middle];
+      int result = compareNames( member.name_, member.length_, key, length );
+      if ( result == 0 )
+         return &member.value_;
+      if ( result < 0 )
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   return 0;
+}
+
+
+std::string
+ArenaValue::memberName( unsigned index ) const
+{
+   if ( type_ != objectValue  ||  index >= size_ )
+      return "";
+   return std::string( value_.members_[index].name_, value_.members_[index].length_ );
+}
+
+
+const ArenaValue &
+ArenaValue::member( unsigned index ) const
+{
+   if ( type_ != objectValue  ||  index >= size_ )
+      return null;
+   return value_.members_[index].value_;
+}
+
+
+// Implementation of class ArenaReader
+// ////////////////////////////////
+
+/// Sort order for members, equal names keep their order.
+static bool
+memberLess( const ArenaMember &a, const ArenaMember &b )
+{
+   return compareNames( a.name_, a.length_, b.name_, b.length_ ) < 0;
+}
+
+
+/// Put UTF-8 of a code point at out, return the bytes written.
+static int
+codePointToUTF8( unsigned int cp, char *out )
+{
+   if ( cp <= 0x7f )
+   {
+      out[0] = char(cp);
+      return 1;
+   }
+   if ( cp <= 0x7FF )
+   {
+      out[0] = char(0xC0 | (0x1f & (cp >> 6)));
+      out[1] = char(0x80 | (0x3f & cp));
+      return 2;
+   }
+   if ( cp <= 0xFFFF )
+   {
+      out[0] = char(0xE0 | (0xf & (cp >> 12)));
+      out[1] = char(0x80 | (0x3f & (cp >> 6)));
+      out[2] = char(0x80 | (0x3f & cp));
+      return 3;
+   }
+   out[0] = char(0xF0 | (0x7 & (cp >> 18)));
+   out[1] = char(0x80 | (0x3f & (cp >> 12)));
+   out[2] = char(0x80 | (0x3f & (cp >> 6)));
+   out[3] = char(0x80 | (0x3f & cp));
+   return 4;
+}
+
+
+/// Read four hexadecimal digits.
+static bool
+decodeHex4( const char *&current, const char *end, unsigned int &unicode )
+{
+   if ( end - current < 4 )
+      return false;
+   unicode = 0;
+   for ( int index = 0; index < 4; ++index )
+   {
+      char c = *current++;
+      unicode *= 16;
+      if ( c >= '0'  &&  c <= '9' )
+         unicode += c - '0';
+      else if ( c >= 'a'  &&  c <= 'f' )
+         unicode += c - 'a' + 10;
+      else if ( c >= 'A'  &&  c <= 'F' )
+         unicode += c - 'A' + 10;
+      else
+         return false;
+   }
+   return true;
+}
+
+
+ArenaReader::ArenaReader()
+   : arena_( 0 )
+   , begin_( 0 )
+   , current_( 0 )
+   , end_( 0 )
+   , errorLocation_( 0 )
+{
+}
+
+
+bool
+ArenaReader::parse( const std::string &document, Arena &arena, ArenaValue &root )
+{
+   return parse( document.data(), document.data() + document.length(), arena, root );
+}
+
+
+bool
+ArenaReader::parse( const char *beginDoc, const char *endDoc,
+                    Arena &arena, ArenaValue &root )
+{
+   arena_ = &arena;
+   begin_ = beginDoc;
+   current_ = beginDoc;
+   end_ = endDoc;
+   error_.clear();
+   errorLocation_ = 0;
+   items_.clear();
+   members_.clear();
+   root = ArenaValue();
+   return readValue( root, 0 );
+}
+
+
+bool
+ArenaReader::addError( const std::string &message, const char *location )
+{
+   error_ = message;
+   errorLocation_ = location;
+   return false;
+}
+
+
+std::string
+ArenaReader::getFormattedErrorMessages() const
+{
+   if ( errorLocation_ == 0 )
+      return "";
+   int line = 1;
+   const char *lineStart = begin_;
+   for ( const char *current = begin_; current < errorLocation_; ++current )
+   {
+      if ( *current == '\n' )
+      {
+         ++line;
+         lineStart = current + 1;
+      }
+   }
+   char buffer[64];
+   sprintf( buffer, "* Line %d, Column %d\n", line, int(errorLocation_ - lineStart) + 1 );
+   return buffer + ( "  " + error_ + "\n" );
+}
+
+
+bool
+ArenaReader::skipSpaces()
+{
+   while ( current_ != end_ )
+   {
+      char c = *current_;
+      if ( c == ' '  ||  c == '\t'  ||  c == '\r'  ||  c == '\n' )
+      {
+         ++current_;
+      }
+      else if ( c == '/'  &&  end_ - current_ > 1  &&  current_[1] == '/' )
+      {
+         while ( current_ != end_  &&  *current_ != '\n'  &&  *current_ != '\r' )
+            ++current_;
+      }
+      else if ( c == '/'  &&  end_ - current_ > 1  &&  current_[1] == '*' )
+      {
+         const char *start = current_;
+         current_ += 2;
+         while ( end_ - current_ > 1  &&  !( current_[0] == '*'  &&  current_[1] == '/' ) )
+            ++current_;
+         if ( end_ - current_ < 2 )
+            return addError( "Comment not closed.", start );
+         current_ += 2;
+      }
+      else
+      {
+         break;
+      }
+   }
+   return true;
+}
+
+
+bool
+ArenaReader::match( const char *pattern, int patternLength )
+{
+   if ( end_ - current_ < patternLength )
+      return false;
+   if ( memcmp( current_, pattern, patternLength ) != 0 )
+      return false;
+   current_ += patternLength;
+   return true;
+}
+
+
+bool
+ArenaReader::readValue( ArenaValue &value, int depth )
+{
+   if ( depth > stackLimit )
+      return addError( "Nesting too deep.", current_ );
+   if ( !skipSpaces() )
+      return false;
+   if ( current_ == end_  ||  *current_ == 0 )
+      return addError( "Syntax error: value, object or array expected.", current_ );
+   const char *start = current_;
+   switch ( *current_ )
+   {
+   case '{':
+      ++current_;
+      return readObject( value, depth );
+   case '[':
+      ++current_;
+      return readArray( value, depth );
+   case '"':
+   case '\'':
+      value.type_ = stringValue;
+      return readString( value.value_.string_, value.size_ );
+   case 't':
+      if ( !match( "true", 4 ) )
+         return addError( "Syntax error: value, object or array expected.", start );
+      value.type_ = booleanValue;
+      value.value_.bool_ = true;
+      return true;
+   case 'f':
+      if ( !match( "false", 5 ) )
+         return addError( "Syntax error: value, object or array expected.", start );
+      value.type_ = booleanValue;
+      value.value_.bool_ = false;
+      return true;
+   case 'n':
+      if ( !match( "null", 4 ) )
+         return addError( "Syntax error: value, object or array expected.", start );
+      value = ArenaValue();
+      return true;
+   default:
+      if ( ( *current_ >= '0'  &&  *current_ <= '9' )  ||  *current_ == '-' )
+         return readNumber( value );
+      return addError( "Syntax error: value, object or array expected.", start );
+   }
+}
+
+
+bool
+ArenaReader::readObject( ArenaValue &value, int depth )
+{
+   size_t first = members_.size();
+   if ( !skipSpaces() )
+      return false;
+   bool empty = current_ != end_  &&  *current_ == '}';
+   if ( empty )  // empty object, a '}' after ',' is an error like in Reader
+      ++current_;
+   while ( !empty )
+   {
+      if ( !skipSpaces() )
+         return false;
+      if ( current_ == end_  ||  ( *current_ != '"'  &&  *current_ != '\'' ) )
+         return addError( "Missing '}' or object member name", current_ );
+      ArenaMember member;
+      if ( !readString( member.name_, member.length_ ) )
+         return false;
+      if ( !skipSpaces() )
+         return false;
+      if ( current_ == end_  ||  *current_ != ':' )
+         return addError( "Missing ':' after object member name", current_ );
+      ++current_;
+      if ( !readValue( member.value_, depth + 1 ) )
+         return false;
+      members_.push_back( member );
+      if ( !skipSpaces() )
+         return false;
+      if ( current_ != end_  &&  *current_ == ',' )
+      {
+         ++current_;
+         continue;
+      }
+      if ( current_ != end_  &&  *current_ == '}' )
+      {
+         ++current_;
+         break;
+      }
+      return addError( "Missing ',' or '}' in object declaration", current_ );
+   }
+
+   // Sort by name, a later duplicate replaces an earlier one like in Value.
+   ArenaMember *begin = members_.empty() ? 0 : &members_[0] + first;
+   ArenaMember *end = members_.empty() ? 0 : &members_[0] + members_.size();
+   if ( end - begin <= 32 )
+   {
+      for ( ArenaMember *current = begin + 1; current < end; ++current )
+      {
+         ArenaMember member = *current;
+         ArenaMember *insert = current;
+         while ( insert > begin  &&  memberLess( member, insert[-1] ) )
+         {
+            *insert = insert[-1];
+            --insert;
+         }
+         *insert = member;
+      }
+   }
+   else
+   {
+      std::stable_sort( begin, end, memberLess );
+   }
+   unsigned count = 0;
+   for ( ArenaMember *current = begin; current < end; ++current )
+   {
+      if ( current + 1 < end  &&  !memberLess( *current, current[1] ) )
+         continue;
+      begin[count++] = *current;
+   }
+
+   ArenaMember *members = 0;
+   if ( count )
+   {
+      members = static_cast<ArenaMember *>( arena_->allocate( count * sizeof(ArenaMember) ) );
+      if ( members == 0 )
+         return addError( "Out of memory.", current_ );
+      memcpy( members, begin, count * sizeof(ArenaMember) );
+   }
+   members_.resize( first );
+   value.type_ = objectValue;
+   value.size_ = count;
+   value.value_.members_ = members;
+   return true;
+}
+
+
+bool
+ArenaReader::readArray( ArenaValue &value, int depth )
+{
+   size_t first = items_.size();
+   if ( !skipSpaces() )
+      return false;
+   bool empty = current_ != end_  &&  *current_ == ']';
+   if ( empty )  // empty array, a ']' after ',' is an error like in Reader
+      ++current_;
+   while ( !empty )
+   {
+      ArenaValue item;
+      if ( !readValue( item, depth + 1 ) )
+         return false;
+      items_.push_back( item );
+      if ( !skipSpaces() )
+         return false;
+      if ( current_ != end_  &&  *current_ == ',' )
+      {
+         ++current_;
+         continue;
+      }
+      if ( current_ != end_  &&  *current_ == ']' )
+      {
+         ++current_;
+         break;
+      }
+      return addError( "Missing ',' or ']' in array declaration", current_ );
+   }
+
+   unsigned count = unsigned( items_.size() - first );
+   ArenaValue *items = 0;
+   if ( count )
+   {
+      items = static_cast<ArenaValue *>( arena_->allocate( count * sizeof(ArenaValue) ) );
+      if ( items == 0 )
+         return addError( "Out of memory.", current_ );
+      memcpy( items, &items_[first], count * sizeof(ArenaValue) );
+   }
+   items_.resize( first );
+   value.type_ = arrayValue;
+   value.size_ = count;
+   value.value_.items_ = items;
+   return true;
+}
+
+
+bool
+ArenaReader::readString( const char *&text, unsigned &length )
+{
+   const char *start = current_++; // skip the quote
+   const char *body = current_;
+   bool escaped = false;
+   while ( current_ != end_  &&  *current_ != '"'  &&  *current_ != '\'' )
+   {
+      if ( *current_ == '\\' )
+      {
+         escaped = true;
+         if ( ++current_ == end_ )
+            break;
+      }
+      ++current_;
+   }
+   if ( current_ == end_ )
+      return addError( "Missing end of string", start );
+   const char *bodyEnd = current_++;
+
+   if ( !escaped )
+   {
+      // Zero copy, the value points into the document.
+      text = body;
+      length = unsigned( bodyEnd - body );
+      return true;
+   }
+
+   // Decoded text is never longer than its escaped form.
+   char *decoded = static_cast<char *>( arena_->allocate( bodyEnd - body ) );
+   if ( decoded == 0 )
+      return addError( "Out of memory.", start );
+   char *out = decoded;
+   const char *current = body;
+   while ( current != bodyEnd )
+   {
+      char c = *current++;
+      if ( c != '\\' )
+      {
+         *out++ = c;
+         continue;
+      }
+      if ( current == bodyEnd )
+         return addError( "Empty escape sequence in string", current );
+      char escape = *current++;
+      switch ( escape )
+      {
+      case '\'': *out++ = '\''; break;
+      case '"': *out++ = '"'; break;
+      case '/': *out++ = '/'; break;
+      case '\\': *out++ = '\\'; break;
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case 'u':
+         {
+            unsigned int unicode;
+            if ( !decodeHex4( current, bodyEnd, unicode ) )
+               return addError( "Bad unicode escape sequence in string: four digits expected.", current );
+            if ( unicode >= 0xD800  &&  unicode <= 0xDBFF )
+            {
+               // surrogate pairs
+               unsigned int surrogatePair;
+               if (   bodyEnd - current < 6  ||  current[0] != '\\'  ||  current[1] != 'u' )
+                  return addError( "expecting another \\u token to begin the second half of a unicode surrogate pair", current );
+               current += 2;
+               if ( !decodeHex4( current, bodyEnd, surrogatePair ) )
+                  return addError( "Bad unicode escape sequence in string: four digits expected.", current );
+               unicode = 0x10000 + ((unicode & 0x3FF) << 10) + (surrogatePair & 0x3FF);
+            }
+            out += codePointToUTF8( unicode, out );
+         }
+         break;
+      default:
+         return addError( "Bad escape sequence in string", current );
+      }
+   }
+   text = decoded;
+   length = unsigned( out - decoded );
+   return true;
+}
+
+
+bool
+ArenaReader::readNumber( ArenaValue &value )
+{
+   const char *start = current_;
+   bool isDouble = false;
+   while ( current_ != end_ )
+   {
+      char c = *current_;
+      if ( c == '.'  ||  c == 'e'  ||  c == 'E'  ||  c == '+'  ||  ( c == '-'  &&  current_ != start ) )
+         isDouble = true;
+      else if ( !( c >= '0'  &&  c <= '9' )  &&  c != '-' )
+         break;
+      ++current_;
+   }
+
+   if ( !isDouble )
+   {
+      // Same ranges as Reader::decodeNumber.
+      const char *current = start;
+      bool isNegative = *current == '-';
+      if ( isNegative )
+         ++current;
+      UInt threshold = (isNegative ? UInt(-Value::minInt) : Value::maxUInt) / 10;
+      UInt number = 0;
+      while ( current < current_ )
+      {
+         char c = *current++;
+         if ( c < '0'  ||  c > '9' )
+            return addError( "'" + std::string( start, current_ ) + "' is not a number.", start );
+         if ( number >= threshold )
+         {
+            isDouble = true;
+            break;
+         }
+         number = number * 10 + UInt(c - '0');
+      }
+      if ( !isDouble )
+      {
+         if ( isNegative )
+         {
+            value.type_ = intValue;
+            value.value_.int_ = -Int( number );
+         }
+         else if ( number <= UInt(Value::maxInt) )
+         {
+            value.type_ = intValue;
+            value.value_.int_ = Int( number );
+         }
+         else
+         {
+            value.type_ = uintValue;
+            value.value_.uint_ = number;
+         }
+         return true;
+      }
+   }
+
+   char buffer[32];
+   size_t length = size_t( current_ - start );
+   if ( length == 0  ||  length >= sizeof(buffer) )
+      return addError( "'" + std::string( start, current_ ) + "' is not a number.", start );
+   memcpy( buffer, start, length );
+   buffer[length] = 0;
+   char *parsed;
+   double number = strtod( buffer, &parsed );
+   if ( parsed == buffer )
+      return addError( "'" + std::string( start, current_ ) + "' is not a number.", start );
+   value.type_ = realValue;
+   value.value_.real_ = number;
+   return true;
+}
+
+} // namespace Json
+
+/** @endcond */
@@ -10,6 +10,7 @@
 /*------------- Standard includes --------------------------------------------*/
 #include <sys/time.h>
 #include <assert.h>
+#include <set>
 
 /*------------- Module options / compiler switches ---------------------------*/
 
@@ -29,6 +30,9 @@
 
 /*------------- Global variables ---------------------------------------------*/
 pthread_mutex_t g_mutex =PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t g_armedMutex =PTHREAD_MUTEX_INITIALIZER;
+/// Timers waiting to expire, never destroyed because static timers may exit later.
+std::set<Ctimeout*> *g_armed =NULL;
 
 /*------------- Exported classes ---------------------------------------------*/
 
@@ -47,6 +51,69 @@ unsigned long Ctimeout::GetTickCount()
     return (unsigned long)((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
 }
 
+/*==============================================================================
+**              Ctimeout::arm
+**============================================================================*/
+///
+///  @brief		Add or remove the timer from the list of running timers.
+///
+///  @param		armed [in] true when the timer is running.
+///
+/*============================================================================*/
+void Ctimeout::arm( bool armed)
+{
+	pthread_mutex_lock( &g_armedMutex);
+	if ( g_armed ==NULL)
+	{
+		g_armed =new std::set<Ctimeout*>;
+	}
+	if ( armed)
+	{
+		g_armed->insert( this);
+	}
+	else
+	{
+		g_armed->erase( this);
+	}
+	pthread_mutex_unlock( &g_armedMutex);
+}
+
+/*==============================================================================
+**              Ctimeout::nextDeadline
+**============================================================================*/
+///
+///  @brief		Find the first running timer to expire.
+///
+///  @return    Milliseconds until it expires, -1 when no timer is running.
+///
+///  @remarks   Timers already expired are not polled yet, they are skipped
+///             so a forgotten timer never keeps the main loop awake.
+///
+/*============================================================================*/
+int Ctimeout::nextDeadline()
+{
+	int deadline =-1;
+	unsigned long now =GetTickCount();
+	pthread_mutex_lock( &g_armedMutex);
+	if ( g_armed ==NULL)
+	{
+		pthread_mutex_unlock( &g_armedMutex);
+		return -1;
+	}
+	for ( std::set<Ctimeout*>::iterator it =g_armed->begin(); it !=g_armed->end(); ++it)
+	{
+		Ctimeout *t =*it;
+		int remaining =t->m_timeout-(int)(now-t->m_startTime);
+		if ( t->m_detected || t->m_timeout<0 || remaining<0)
+		{
+			continue;
+		}
+		deadline =earliestDeadline( deadline, remaining);
+	}
+	pthread_mutex_unlock( &g_armedMutex);
+	return deadline;
+}
+
 /*==============================================================================
 **              Ctimeout::setTime
 **============================================================================*/
@@ -73,6 +140,7 @@ void Ctimeout::setTime( int timeout, int margin, int minTries)
 	m_tries      =0;
 	m_lastElapsed =0;
 	unlock();
+	arm( true);
 }
 
 /*==============================================================================
@@ -96,6 +164,7 @@ void Ctimeout::stop()
 	m_detected   =false;
 	m_tries      =0;
 	unlock();
+	arm( false);
 }
 
 int Ctimeout::elapsed()
@@ -178,6 +247,7 @@ bool Ctimeout::expired(void)
 /*============================================================================*/
 Ctimeout::~Ctimeout(void)
 {
+	arm( false);
 }
 
 /*==============================================================================
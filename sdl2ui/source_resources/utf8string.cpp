@@ -24,6 +24,10 @@
 /*------------- Standard includes --------------------------------------------*/
 #include <sstream>
 #include <assert.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "utf8string.h"
 //#include "zhongcan_defines.h"
 
@@ -65,17 +69,196 @@ zhongstring::~zhongstring()
 
 utf8string::utf8string(const std::string & s)
 : m_string(s)
+, m_length(-1)
+, m_ascii(false)
+, m_valid(-1)
 {
 }
 
 utf8string::utf8string(const char *s)
 : m_string(s)
+, m_length(-1)
+, m_ascii(false)
+, m_valid(-1)
 {
 }
 
 utf8string::~utf8string()
 {}
 
+/** @brief Find the first byte from a limit or a 0, 16 bytes at a time.
+ *  @param s [in] Bytes to scan.
+ *  @param length [in] Number of bytes.
+ *  @param limit [in] Lowest byte to find.
+ *  @return Position found or length.
+ */
+static int skipBelow( const unsigned char *s, int length, unsigned char limit)
+{
+	int a =0;
+#ifdef __SSE2__
+	__m128i vlimit =_mm_set1_epi8( (char)limit);
+	__m128i zero =_mm_setzero_si128();
+	for ( ; a+16<=length; a+=16)
+	{
+		__m128i x =_mm_loadu_si128( (const __m128i*)(s+a));
+		__m128i high =_mm_cmpeq_epi8( _mm_max_epu8( x, vlimit), x);
+		__m128i nul =_mm_cmpeq_epi8( x, zero);
+		if ( _mm_movemask_epi8( _mm_or_si128( high, nul)))
+		{
+			break;
+		}
+	}
+#endif
+	for ( ; a<length; a++)
+	{
+		if ( s[a]>=limit || s[a]==0)
+		{
+			break;
+		}
+	}
+	return a;
+}
+
+/** @brief First byte of the UTF-8 code for a character.
+ *  @param value [in] Character.
+ */
+static int leadByte( int value)
+{
+	if ( value<0x80) return value;
+	if ( value<0x800) return 0xc0 | (value>>6);
+	if ( value<0x10000) return 0xe0 | (value>>12);
+	return 0xf0 | (value>>18);
+}
+
+/** @brief Number of bytes of a UTF-8 character.
+ *  @param first [in] First byte of the character.
+ */
+static int sequenceLength( unsigned char first)
+{
+	if ( (first & 0x80) ==0) return 1;
+	if ( (first & 0xe0) ==0xc0) return 2;
+	if ( (first & 0xf0) ==0xe0) return 3;
+	if ( (first & 0xf8) ==0xf0) return 4;
+	return 1;
+}
+
+/** @brief Find length and character offsets when the text changed. Pure
+ *         ASCII text needs no offsets.
+ */
+void utf8string::analyse() const
+{
+	if ( m_length>=0)
+	{
+		return;
+	}
+	const char *s =m_string.c_str();
+	int bytes =(int)m_string.size();
+	int ascii =skipBelow( (const unsigned char*)s, bytes, 0x80);
+	m_offsets.clear();
+	m_ascii =( ascii ==bytes || s[ascii] ==0);
+	if ( m_ascii)
+	{
+		m_length =ascii;
+		return;
+	}
+	int offset;
+	for ( offset=0; s[offset]; offset +=characterLength( s+offset))
+	{
+		m_offsets.push_back( offset);
+	}
+	m_offsets.push_back( offset);
+	m_length =(int)m_offsets.size()-1;
+}
+
+/** @brief Forget length and offsets, call after every change. */
+void utf8string::changed()
+{
+	m_length =-1;
+	m_valid =-1;
+	m_offsets.clear();
+}
+
+/** @brief Check for correct UTF-8 without 0 bytes.
+ *  @return true when valid.
+ */
+bool utf8string::isValid() const
+{
+	if ( m_valid>=0)
+	{
+		return m_valid ==1;
+	}
+	const unsigned char *s =(const unsigned char*)m_string.c_str();
+	int length =(int)m_string.size();
+	int a =0;
+	m_valid =0;
+	while ( (a +=skipBelow( s+a, length-a, 0x80)) <length)
+	{
+		int c =s[a];
+		int extra, minimum, maximum;
+		if ( c ==0) return false;
+		else if ( c>=0xc2 && c<=0xdf) { extra =1; minimum =0x80; maximum =0xbf; }
+		else if ( c>=0xe0 && c<=0xef) { extra =2; minimum =(c==0xe0) ? 0xa0:0x80; maximum =(c==0xed) ? 0x9f:0xbf; }
+		else if ( c>=0xf0 && c<=0xf4) { extra =3; minimum =(c==0xf0) ? 0x90:0x80; maximum =(c==0xf4) ? 0x8f:0xbf; }
+		else return false;
+		if ( a+extra>=length+1 || s[a+1]<minimum || s[a+1]>maximum)
+		{
+			return false;
+		}
+		for ( int b=2; b<=extra; b++)
+		{
+			if ( a+b>=length || (s[a+b] & 0xc0) !=0x80)
+			{
+				return false;
+			}
+		}
+		a +=extra+1;
+	}
+	m_valid =1;
+	return true;
+}
+
+/** @brief Is there a character above a value, e.g. to find Chinese text.
+ *  Only the bytes that may start such a character are decoded.
+ *  @param value [in] Highest character that is not found.
+ *  @return true when a character>value is in the text.
+ */
+bool utf8string::containsAbove( int value) const
+{
+	if ( value>=0x10ffff)
+	{
+		return false;
+	}
+	if ( !isValid())
+	{
+		for ( const_iterator it=begin(); it!=end(); ++it)
+		{
+			if ( *it>value)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	const unsigned char *s =(const unsigned char*)m_string.c_str();
+	int length =(int)m_string.size();
+	unsigned char lead =(unsigned char)leadByte( value<0 ? 0:value+1);
+	int a =0;
+	while ( (a +=skipBelow( s+a, length-a, lead)) <length)
+	{
+		// Back to the first byte of this character.
+		while ( a>0 && (s[a] & 0xc0) ==0x80)
+		{
+			a--;
+		}
+		if ( utf8character( (const char*)s+a)>value)
+		{
+			return true;
+		}
+		a +=characterLength( (const char*)s+a);
+	}
+	return false;
+}
+
 void utf8string::set( size_t index, int nr)
 {
 	// Offset at cursor.
@@ -96,7 +279,7 @@ void utf8string::set( size_t index, int nr)
 	}
 	else if ( newLen==2)
 	{
-		m_string[pos] =static_cast<char>(0xc0+(nr>>5));
+		m_string[pos] =static_cast<char>(0xc0+(nr>>6));
 		s[0] =static_cast<char>(0x80+(nr&0x3f));
 		if ( len<2)
 		{
@@ -129,6 +312,7 @@ void utf8string::set( size_t index, int nr)
 			m_string[pos+2]=s[0];
 		}
 	}
+	changed();
 }
 
 std::string utf8string::sub( size_t left, size_t right)
@@ -254,33 +438,18 @@ int utf8string::utf8character( size_t index) const
 
 size_t utf8string::size() const
 {
-	const char *s =m_string.c_str();
-	int a;
-	for ( a=0;;++a)
-	{
-		if (*s ==0)
-		{
-			break;
-		}
-		int len =characterLength(s);
-		s +=len;
-	}
-	return a;
+	analyse();
+	return m_length;
 }
 
 int utf8string::getOffset( size_t cursor) const
 {
-	const char *s=m_string.c_str();
-	int offset =0;
-	while ( cursor--)
+	analyse();
+	if ( cursor>(size_t)m_length)
 	{
-		if ( *(s+offset)==0)
-		{
-			return offset;
-		}
-		offset +=characterLength(s+offset);
+		cursor =m_length;
 	}
-	return offset;
+	return m_ascii ? (int)cursor : m_offsets[cursor];
 }
 
 void utf8string::erase( size_t cursor)
@@ -291,6 +460,7 @@ void utf8string::erase( size_t cursor)
 	if (len)
 	{
 		m_string.erase(pos, len);
+		changed();
 	}
 }
 
@@ -299,7 +469,7 @@ void utf8string::insert( size_t cursor, const utf8string &str)
 	int pos =getOffset(cursor);
 	//int len = str.length();
 	m_string.insert( pos, str.m_string);
-
+	changed();
 }
 
 void utf8string::insert( size_t cursor, int nr)
@@ -316,7 +486,7 @@ void utf8string::insert( size_t cursor, int nr)
 	}
 	else if (nr<0x800)
 	{
-		s[0] =static_cast<char>(0xc0+(nr>>5));
+		s[0] =static_cast<char>(0xc0+(nr>>6));
 		s[1] =static_cast<char>(0x80+(nr&0x3f));
 		s[2] =0;
 	}
@@ -326,7 +496,9 @@ void utf8string::insert( size_t cursor, int nr)
 		s[1] =static_cast<char>(0x80 | ((nr&0x0FC0)>>6));
 		s[2] =static_cast<char>(0x80 | (nr&0x003F));
 		s[3] =0;
-	}	m_string.insert( pos, s);
+	}
+	m_string.insert( pos, s);
+	changed();
 }
 
 /** @brief Remove last character. */
@@ -349,13 +521,20 @@ void utf8string::pop_back()
  */
 void utf8string::push_back( int nr)
 {
+	int end =(int)m_string.size();
 	if (nr<0x80)
 	{
 		m_string.push_back( static_cast<char>(nr));
+		if ( m_length>=0 && m_ascii && nr !=0)
+		{
+			// Typing at the end keeps the length.
+			m_length++;
+			return;
+		}
 	}
 	else if (nr<0x800)
 	{
-		m_string.push_back( static_cast<char>(0xc0+(nr>>5)));
+		m_string.push_back( static_cast<char>(0xc0+(nr>>6)));
 		m_string.push_back(static_cast<char>(0x80+(nr&0x3f)));
 	}
 	else
@@ -364,6 +543,16 @@ void utf8string::push_back( int nr)
 		m_string.push_back( static_cast<char>(0x80 | ((nr&0x0FC0)>>6)));
 		m_string.push_back( static_cast<char>(0x80 | (nr&0x003F)));
 	}
+	// The old last character must be complete, else it takes the new bytes.
+	if (   m_length>0 && !m_ascii && m_offsets.back() ==end
+		&& sequenceLength( (unsigned char)m_string[ m_offsets[m_length-1]]) ==end-m_offsets[m_length-1])
+	{
+		m_offsets.push_back( (int)m_string.size());
+		m_length++;
+		m_valid =-1;
+		return;
+	}
+	changed();
 }
 
 
@@ -396,6 +585,7 @@ bool utf8string::startWith( int cursor, const std::string &compare)
 void utf8string::push_back( const std::string &s)
 {
 	m_string +=s;
+	changed();
 }
 
 void utf8string::onlyAscii()
@@ -256,26 +256,10 @@ CdialogObject * C2DswypeDialog::findObject( const Cpoint &p)
 void C2DswypeDialog::invalidateIndex( int index)
 {
 	m_repaint =true;
-	for ( int n=0; n<m_visibleBuffers; n++)
+	if ( index>=m_firstUnitPainted && index<m_lastUnitPainted)
 	{
-		CswypeObject *obj =m_swypeObjects[ n];
-		if ( obj->index ==index)
-		{
-			// ( "C2DswypeDialog::invalidate  index=%d", index);
-			m_world->graphics()->setRenderArea( obj->texture);
-			if ( m_horizontal)
-			{
-				Crect rect( 0, 0, itemBlocks(), m_rect.height());
-				onPaintUnit( index, rect);
-		  	}
-			else
-			{
-				Crect rect( 0,0, m_rect.width(), itemBlocks());
-				onPaintUnit( index, rect);
-			}
-			m_world->graphics()->setRenderArea( NULL);
-			return;
-		}
+		// ( "C2DswypeDialog::invalidate  index=%d", index);
+		paintTile( tile( index));
 	}
 }
 
@@ -322,22 +306,34 @@ bool C2DswypeDialog::scrollToIndex( int index, int time)
 	return CswypeDialog::scrollToRow( index/m_span, time);
 }
 
+/** @brief Number of tiles to cover the visible cells and the cells painted ahead.
+ *  @return Slots needed in the atlas.
+ */
+int C2DswypeDialog::tileCount()
+{
+	int extent =m_horizontal ? m_rect.width():m_rect.height();
+	int visible =m_span*(extent/gMax( 1, itemBlocks())+2);
+	return visible+2*(m_listSize/(4*gMax( 1, m_span)))+1;
+}
+
 /// @brief  Depending on the scroll offset and painted area, we calculate the drawing area.
 void C2DswypeDialog::calculateSurfacePosition()
 {
 	int size;
 	int row =(int)rows();
+	// An overscroll shows background, no extra cells.
+	double scroll =gLimit( m_scroll, 0.0, (double)scrollMax());
 	if ( m_horizontal)
 	{
 		size =m_itemRect.width()*8;
-		m_firstVisibleUnit =m_span*(int)(m_scroll/size);
-		m_lastVisibleUnit =(int)((m_scroll+m_rect.width()*8+size-1)/size);
+		m_firstVisibleUnit =m_span*(int)(scroll/size);
+		m_lastVisibleUnit =(int)((scroll+m_rect.width()*8+size-1)/size);
 	}
 	else
 	{
 		size =m_itemRect.height()*8;
-		m_firstVisibleUnit =m_span*(int)(m_scroll/size);
-		m_lastVisibleUnit =m_span*(int)((m_scroll+m_rect.height()*8+size-1)/size);
+		m_firstVisibleUnit =m_span*(int)(scroll/size);
+		m_lastVisibleUnit =m_span*(int)((scroll+m_rect.height()*8+size-1)/size);
 	}
 	if ( m_lastVisibleUnit >row*m_span)
 	{
@@ -385,42 +381,38 @@ void C2DswypeDialog::onPaint()
 	m_world->graphics()->setViewport( &rct);
 	m_world->graphics()->setColour( m_backgroundColour);
 	m_world->graphics()->bar( rct.x, rct.y, rct.x+rct.w, rct.h+rct.y);
-	int size =m_visibleBuffers;
-	if ( size >0)
+	if ( m_horizontal)
 	{
-		if ( m_horizontal)
+		int width =itemBlocks()*8;
+		int height =m_rect.height()*8;
+		// Draw horizontal items
+		rct.w =(Uint16)(m_itemRect.width()*8);
+		for ( int unit=m_firstUnitPainted; unit<m_lastUnitPainted; unit++)
 		{
-			int width =itemBlocks()*8;
-			int height =m_rect.height()*8;
-			// Draw horizontal items
-			rct.w =(Uint16)(m_swypeObjects[0]->destination.width()*8);
-			for ( int n=0; n<size; n++)
-			{
-				CswypeObject *obj =m_swypeObjects[n];
-				rct.x =(Sint16)(offx+width*(int)(obj->index/m_span)-(int)m_scroll);
-				int y =obj->index%m_span;
-				rct.y =(Sint16)(y*height/m_span);
-				rct.h =(Uint16)((y+1)*height/m_span-rct.y);
-				rct.y =(Uint16)(rct.y+offy);
-				renderCopy( m_swypeObjects[n]->texture, &rct);
-			}
+			CswypeObject *obj =tile( unit);
+			rct.x =(Sint16)(offx+width*(int)(obj->index/m_span)-(int)m_scroll);
+			int y =obj->index%m_span;
+			rct.y =(Sint16)(y*height/m_span);
+			rct.h =(Uint16)((y+1)*height/m_span-rct.y);
+			rct.y =(Uint16)(rct.y+offy);
+			renderCopy( obj, &rct);
 		}
-		else
+	}
+	else
+	{
+		int height =itemBlocks()*8;
+		int width =m_rect.width()*8;
+		// Draw vertical items
+		rct.h =(Uint16)(m_itemRect.height()*8);
+		for ( int unit=m_firstUnitPainted; unit<m_lastUnitPainted; unit++)
 		{
-			int height =itemBlocks()*8;
-			int width =m_rect.width()*8;
-			// Draw horizontal items
-			rct.h =(Uint16)(m_swypeObjects[0]->destination.height()*8);
-			for ( int n=0; n<size; n++)
-			{
-				CswypeObject *obj =m_swypeObjects[n];
-				rct.y =(Sint16)(offy+height*(int)(obj->index/m_span)-(int)m_scroll);
-				int x =obj->index%m_span;
-				rct.x =(Sint16)(x*width/m_span);
-				rct.w =(Uint16)((x+1)*width/m_span-rct.x);
-				rct.x =(Sint16)(rct.x+offx);
-				renderCopy( m_swypeObjects[n]->texture, &rct);
-			}
+			CswypeObject *obj =tile( unit);
+			rct.y =(Sint16)(offy+height*(int)(obj->index/m_span)-(int)m_scroll);
+			int x =obj->index%m_span;
+			rct.x =(Sint16)(x*width/m_span);
+			rct.w =(Uint16)((x+1)*width/m_span-rct.x);
+			rct.x =(Sint16)(rct.x+offx);
+			renderCopy( obj, &rct);
 		}
 	}
 	// Put back old viewport
@@ -431,46 +423,24 @@ void C2DswypeDialog::onPaint()
 
 void C2DswypeDialog::paintSurfaceTop()
 {
-	CswypeObject *obj =insertAtBegin();
-	// Actual painting
-	m_graphics->setRenderArea( obj->texture);
-	onPaintUnit( obj->index, m_itemRect);
-	m_graphics->setRenderArea( NULL);
+	paintTile( insertAtBegin());
 }
 
 bool C2DswypeDialog::paintSurfaceRight()
 {
 	CswypeObject *obj =insertAtEnd();
-	if ( !obj)
-	{
-		return false;
-	}
-	// Actual painting
-	graphics()->setRenderArea( obj->texture);
-	onPaintUnit( obj->index, m_itemRect);
-	graphics()->setRenderArea( NULL);
-	return true;
+	paintTile( obj);
+	return obj !=NULL;
 }
 
 bool C2DswypeDialog::paintSurfaceLeft()
 {
 	CswypeObject *obj =insertAtBegin();
-	if ( !obj)
-	{
-		return false;
-	}
-	// Actual painting
-	m_graphics->setRenderArea( obj->texture);
-	onPaintUnit( obj->index, m_itemRect);
-	m_graphics->setRenderArea( NULL);
-	return true;
+	paintTile( obj);
+	return obj !=NULL;
 }
 
 void C2DswypeDialog::paintSurfaceBottom()
 {
-	CswypeObject *obj =insertAtEnd();
-	// Actual painting
-	m_graphics->setRenderArea( obj->texture);
-	onPaintUnit( obj->index, m_itemRect);
-	m_graphics->setRenderArea( NULL);
+	paintTile( insertAtEnd());
 }
@@ -36,8 +36,10 @@
  **===========================================================================*/
 
 /*------------- Standard includes --------------------------------------------*/
-#include <sys/time.h>
+#include <time.h>
 #include "sdl_after_glow.h"
+#include "sdl_look_cache.h"
+#include "timeout.h"
 
 /// Release time for a button
 #define MAXIMUM_RELEASE_TIME 200
@@ -56,17 +58,23 @@ CafterGlowList::~CafterGlowList()
 	m_info.clear();
 }
 
+/** @brief Monotonic time, not changed by setting the clock.
+ *  @return Time in msec.
+ */
+unsigned int CafterGlowList::now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return (unsigned int)(ts.tv_sec*1000+ts.tv_nsec/1000000);
+}
+
 /** @brief Calculate how much time is elapsed between now and last-time
  *  @return Elapsed time in msec.
  */
 unsigned int CafterGlowList::elapsed()
 {
 	unsigned int elapsed =0;
-	struct timeval tv;
-    if( gettimeofday(&tv, NULL) != 0)
-            return 0;
-
-    m_time_now =(unsigned int)((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+    m_time_now =now();
     elapsed =m_time_now-m_last_time;
     if (elapsed>1000)
     {
@@ -75,7 +83,23 @@ unsigned int CafterGlowList::elapsed()
     m_last_time =m_time_now;
     return elapsed;
 }
-/** @brief Regular update of the touch list, remove keys that were pressed long ago.
+
+/** @brief Remove one glow, the last one takes its slot.
+ *  @param slot [in] Index in the list.
+ */
+void CafterGlowList::remove( int slot)
+{
+	m_info[slot].object->m_glow =-1;
+	int last =(int)m_info.size()-1;
+	if ( slot !=last)
+	{
+		m_info[slot] =m_info[last];
+		m_info[slot].object->m_glow =slot;
+	}
+	m_info.pop_back();
+}
+
+/** @brief Tick for all glows, once per frame. Removes keys released long ago.
  *  @param pressed [in] Is anything pressed
  *  @param mouse [in] Last position pressed
  *  @return true when we need to repaint the screen
@@ -85,54 +109,46 @@ bool CafterGlowList::update( bool pressed, const Cpoint &mouse)
 	bool retVal =false;
 	Cpoint q=mouse/8;
 	lock();
-	try
+	m_time_now =now();
+	for ( int n=0; n<(int)m_info.size();)
 	{
-		(void)elapsed();
-		int n=0;
-		for ( n=0; n<(int)m_info.size();)
+		StouchInfo *ti =&m_info[n];
+		if ( ti->pressed)
 		{
-			StouchInfo *ti =&m_info[n];
-			if ( ti->pressed)
+			if ( !ti->painted)
 			{
-				retVal =!ti->last_time;
-				ti->last_time =m_time_now;
-				// Check if the button is released
-				if ( !pressed || !ti->object->m_rect.inside( q))
-				{
-					ti->pressed =false;
-					ti->startTime =m_time_now;
-					retVal =true;
-				}
-				else
-				{
-					// Do nothing
-				}
-				n++;
+				ti->painted =true;
+				ti->object->invalidate();
+				retVal =true;
 			}
-			else
+			// Check if the button is released
+			if ( !pressed || !ti->object->m_rect.inside( q))
 			{
-				// See if we need to remove this from the list
-				if ( m_time_now-ti->startTime>=MAXIMUM_RELEASE_TIME)
-				{
-					m_last_time =m_time_now;
-					m_info.erase( m_info.begin()+n);
-					retVal =true;
-				}
-				else
-				{
-					if ( m_time_now-ti->last_time>33) // 33 Hz update
-					{
-						m_last_time =m_time_now;
-						retVal =true;
-					}
-					n++;
-				}
+				ti->pressed =false;
+				ti->startTime =m_time_now;
+				ti->object->invalidate();
+				retVal =true;
 			}
+			n++;
+			continue;
 		}
-	}
-	catch(...)
-	{
-		retVal =false;
+		unsigned int age =m_time_now-ti->startTime;
+		if ( age>=MAXIMUM_RELEASE_TIME)
+		{
+			ti->object->invalidate();
+			remove( n);
+			retVal =true;
+			continue;
+		}
+		int factor =TOUCH_MAXIMUM-(int)(age*TOUCH_MAXIMUM)/MAXIMUM_RELEASE_TIME;
+		// Only paint again when the painted glow changes.
+		if ( ClookCache::quantize( factor) !=ClookCache::quantize( ti->factor))
+		{
+			ti->object->invalidate();
+			retVal =true;
+		}
+		ti->factor =factor;
+		n++;
 	}
 	unlock();
 	return retVal;
@@ -140,47 +156,23 @@ bool CafterGlowList::update( bool pressed, const Cpoint &mouse)
 
 /** @brief We want to know the touch-factor for this button
  *  @param object [in] Which object we examine
- *  @param factor [out] Touch value for this one. 0=nothing, 1..99 =pressing, 100=pressed, 101..200 =releasing
+ *  @param factor [out] Touch value for this one. 0=nothing, 1..99 =releasing, 100=pressed
  *  @return true when the button was found.
  */
 bool CafterGlowList::getFactor( CdialogObject *object, int *factor)
 {
 	*factor=0;
-	bool retVal =false;
-	lock();
-	try
+	if ( object->m_glow<0)
 	{
-		for ( int n=0; n<(int)m_info.size(); n++)
-		{
-			StouchInfo *ti=&m_info[n];
-			if ( ti->object ==object)
-			{
-				retVal =true;
-				if ( ti->pressed)
-				{
-					*factor =100;
-					ti->last_time =m_last_time;
-				}
-				else
-				{
-					*factor =100-((m_time_now-ti->startTime)*100)/MAXIMUM_RELEASE_TIME;
-					if ( *factor>100)
-					{
-						*factor =100;
-					}
-					if ( *factor<0)
-					{
-						*factor =0;
-						m_info.erase( m_info.begin()+n);
-					}
-				}
-				break;
-			}
-		}
+		return false;
 	}
-	catch(...)
+	bool retVal =false;
+	lock();
+	int slot =object->m_glow;
+	if ( slot<(int)m_info.size() && m_info[slot].object ==object)
 	{
-		retVal =false;
+		*factor =m_info[slot].factor;
+		retVal =true;
 	}
 	unlock();
 	return retVal;
@@ -189,7 +181,13 @@ bool CafterGlowList::getFactor( CdialogObject *object, int *factor)
 /** @brief Forget all the buttons that are pressed or were pressed */
 void CafterGlowList::clear()
 {
+	lock();
+	for ( int n=0; n<(int)m_info.size(); n++)
+	{
+		m_info[n].object->m_glow =-1;
+	}
 	m_info.clear();
+	unlock();
 }
 
 /** @brief Tell how many buttons are pressed now
@@ -200,24 +198,69 @@ int CafterGlowList::size()
 	return (int)m_info.size();
 }
 
-/** @brief A new button is pressed, let is glow some time after we release it.
- *  @param object [in] The new button pressed
+/** @brief Find when the painted glow of a released button changes.
+ *  @param ti [in] Releasing button.
+ *  @return Time in msec.
  */
-void CafterGlowList::addObject( CdialogObject *object)
+unsigned int CafterGlowList::nextChange( const StouchInfo &ti)
+{
+	int level =ClookCache::quantize( ti.factor);
+	int factor =ti.factor;
+	while ( factor>0 && ClookCache::quantize( factor) ==level)
+	{
+		factor--;
+	}
+	// First time with a factor of at most this value.
+	unsigned int age =( (TOUCH_MAXIMUM-factor)*MAXIMUM_RELEASE_TIME+TOUCH_MAXIMUM-1)/TOUCH_MAXIMUM;
+	return ti.startTime+age;
+}
+
+/** @brief Tell when update() should be called again.
+ *  @return Milliseconds, -1 when only input changes the list.
+ */
+int CafterGlowList::nextDeadline()
 {
+	int deadline =-1;
 	lock();
+	unsigned int time =now();
 	for ( int n=0; n<(int)m_info.size(); n++)
 	{
-		if (m_info[n].object ==object)
+		StouchInfo *ti =&m_info[n];
+		if ( ti->pressed)
 		{
-			return;
+			// Paint the first press, the release comes with input.
+			if ( !ti->painted)
+			{
+				deadline =0;
+			}
+			continue;
 		}
+		int wait =(int)(nextChange( *ti)-time);
+		deadline =earliestDeadline( deadline, ( wait<0) ? 0:wait);
+	}
+	unlock();
+	return deadline;
+}
+
+/** @brief A new button is pressed, let is glow some time after we release it.
+ *  @param object [in] The new button pressed
+ */
+void CafterGlowList::addObject( CdialogObject *object)
+{
+	lock();
+	int slot =object->m_glow;
+	if ( slot>=0 && slot<(int)m_info.size() && m_info[slot].object ==object)
+	{
+		unlock();
+		return;
 	}
 	StouchInfo ti;
 	ti.object =object;
 	ti.pressed =true;
-	ti.last_time =0; //m_time_now; // 100%
-	ti.startTime =m_last_time;
+	ti.painted =false;
+	ti.startTime =now();
+	ti.factor =TOUCH_MAXIMUM;
+	object->m_glow =(int)m_info.size();
 	m_info.push_back( ti);
 	unlock();
 }
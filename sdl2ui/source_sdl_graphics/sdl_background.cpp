@@ -120,6 +120,14 @@ void Cbackground::onPaint( int touch)
 
 	colour col1 =touch ? m_graphics.get()->brighter(m_col1, -touch/4):m_col1;
 	colour col2 =touch ? m_graphics.get()->brighter(m_col2, -touch/4):m_col2;
+	if ( Cgraphics::m_defaults.raster_fill && onPaintRaster( col1, col2))
+	{
+		if ( m_key!=KEY_UNDEFINED)
+		{
+			m_graphics->setCode( Crect( 0, 0, m_graphics->width(),m_graphics->height()), m_key);
+		}
+		return;
+	}
 	switch (m_pattern)
 	{
 	case FILL_NONE:
@@ -246,6 +254,54 @@ void Cbackground::onPaint( int touch)
 	}
 }
 
+/** @brief Fill the background in a pixel buffer and paint it at once.
+ *  @param col1 [in] First colour, after touch.
+ *  @param col2 [in] Second colour, after touch.
+ *  @return false when this fill is painted line by line.
+ */
+bool Cbackground::onPaintRaster( colour col1, colour col2)
+{
+	int xx =(m_rect.left() << 3) +m_borderWidth;
+	int yy =(m_rect.top() << 3)+m_borderWidth;
+	int width =(m_rect.width() << 3)-2*m_borderWidth;
+	int height =(m_rect.height() << 3)-2*m_borderWidth;
+
+	switch (m_pattern)
+	{
+	case FILL_2COLOURS:
+	case FILL_GRADIENT:
+	case FILL_PYRAMID:
+		{
+			m_B1 =(col1 & 0x0000FF);
+			m_G1 =(col1 & 0x00FF00) >> 8;
+			m_R1 =(col1 & 0xFF0000) >> 16;
+			m_B2 =(col2 & 0x0000FF);
+			m_G2 =(col2 & 0x00FF00) >> 8;
+			m_R2 =(col2 & 0xFF0000) >> 16;
+			m_raster.setSize( width, height, m_radius);
+			std::vector<Uint32> rows( height);
+			for ( int y=0; y<height; y++)
+			{
+				rows[y] =(Uint32)calcColour( col1, col2, y/(double)height);
+			}
+			m_raster.fillRows( rows);
+			break;
+		}
+	case FILL_CIRCULAR:
+		m_raster.setSize( width, height, m_radius);
+		m_raster.fillCircular( col1, width/2.2);
+		break;
+	case FILL_PIE:
+		// Same scale as pieColour().
+		m_raster.setSize( width, height, m_radius);
+		m_raster.fillPie( col1, col2, m_pieCorner*6.2928/360.0);
+		break;
+	default:
+		return false;
+	}
+	return m_raster.paint( m_graphics.get(), xx, yy);
+}
+
 /** @brief Set colours for the background.
  *  @param col1 [in] First colour
  *  @param col2 [in] Second colour
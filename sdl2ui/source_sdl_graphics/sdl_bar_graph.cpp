@@ -244,17 +244,20 @@ void CbarGraph::onPaint( const Crect &rect, int touch)
 void CbarGraph::rotate()
 {
 	m_rotate =true;
+	invalidate();
 }
 
 void CbarGraph::setRange( double minimum, double maximum)
 {
 	m_minimum =minimum;
 	m_maximum =maximum;
+	invalidate();
 }
 
 void CbarGraph::setColourHelpLines( colour n)
 {
 	m_helpLines =n;
+	invalidate();
 }
 
 void CbarGraph::setColours( int n, colour background)
@@ -264,4 +267,5 @@ void CbarGraph::setColours( int n, colour background)
 		m_colour.push_back(0);
 	}
 	m_colour[n] =background;
+	invalidate();
 }
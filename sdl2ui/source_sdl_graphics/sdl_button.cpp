@@ -762,10 +762,8 @@ void Cbutton::onPaint( const std::string &text, int touch)
 	{
 		return;
 	}
-	// Draw background fill.
-	paintBackground( touch);
-	// Draw button edge.
-	paintBorder( m_border, m_spacing, m_background.getRadius(), touch);
+	// Draw background fill and button edge.
+	paintLook( touch);
 	// Draw button image.
 	paintImage();
 	// Draw button text.
@@ -773,7 +771,64 @@ void Cbutton::onPaint( const std::string &text, int touch)
 	// Draw label.
 	paintLabel();
 	// Set mouse touch.
-	m_graphics->setCode( m_rect, m_code);
+	setTouchKey();
+}
+
+/*============================================================================*/
+///
+/// @brief Paint background and border, from the look cache when possible.
+///
+/// @param touch [in] Touch level from the after-glow.
+///
+/*============================================================================*/
+void Cbutton::paintLook( int touch)
+{
+#ifdef USE_SDL2
+	EfillType fill =m_background.getFillStyle();
+	// Images may still be decoding, a circular fill is half transparent.
+	if (   Cgraphics::m_defaults.look_cache_size>0 && m_graphics !=NULL
+		&& ( m_noBackground || ( fill !=FILL_IMAGE && fill !=FILL_CIRCULAR)))
+	{
+		bool shadow =( m_border ==BORDER_THIN_BUTTON_SHADOW);
+		SlookKey key;
+		key.renderer =m_graphics->getRenderer();
+		key.width =m_rect.width()*8;
+		key.height =( m_rect.height()+( shadow ? 1:0))*8;
+		key.fill =fill;
+		key.radius =m_background.getRadius();
+		key.fill1 =m_background.getColour();
+		key.fill2 =m_background.getColour2();
+		key.corner =m_background.getCorner();
+		key.border =m_border;
+		key.border1 =m_border1;
+		key.border2 =m_border2;
+		key.shadow =m_button_shadow;
+		key.spacing =m_spacing;
+		key.background =!m_noBackground;
+		key.touch =ClookCache::quantize( touch);
+
+		ClookCache *cache =ClookCache::Instance();
+		if ( cache->paint( key, m_graphics.get(), left()*8, top()*8))
+		{
+			return;
+		}
+		if ( cache->begin( key, m_graphics.get()))
+		{
+			Crect rect =m_rect;
+			m_rect =Crect( 0,0, rect.width(), rect.height());
+			paintBackground( key.touch);
+			paintBorder( m_border, m_spacing, m_background.getRadius(), key.touch);
+			m_rect =rect;
+			cache->end( key, m_graphics.get());
+			if ( cache->paint( key, m_graphics.get(), left()*8, top()*8))
+			{
+				return;
+			}
+		}
+	}
+#endif
+	paintBackground( touch);
+	paintBorder( m_border, m_spacing, m_background.getRadius(), touch);
 }
 
 /*============================================================================*/
@@ -999,6 +1054,7 @@ void Cbutton::setText( const std::string &text)
 {
 	m_text =text;
 	m_useText =true;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -1012,6 +1068,7 @@ void Cbutton::setText( textId text)
 {
 	m_textId =text;
 	m_useText =false;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -1049,6 +1106,7 @@ void Cbutton::setImage( const std::string &image, Egravity horizontal)
 	}
 	m_imageGravity =horizontal;
 	m_image.setImage( image, horizontal, m_imageSize);
+	invalidate();
 }
 
 /*============================================================================*/
@@ -1068,6 +1126,7 @@ void Cbutton::setColours( colour text, colour background1, colour background2)
 	m_textColour =text;
 	m_background.setColours( background1, background2);
 	m_noBackground =false;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -1087,6 +1146,7 @@ void Cbutton::setBorderColours( colour b1, colour b2)
 	}
 	m_border1 =b1;
 	m_border2 =b2;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -1101,6 +1161,7 @@ void Cbutton::setBackgroundColour( colour background1, colour background2)
 {
 	m_background.setColours( background1, background2);
 	m_noBackground =false;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -1117,12 +1178,14 @@ void Cbutton::setBorder( EborderType border, int radius)
 	{
 		m_background.setRadius( radius);
 	}
+	invalidate();
 }
 
 /// @brief Set style to fill.
 void Cbutton::setFillType( EfillType fill)
 {
 	m_background.setFillStyle( fill);
+	invalidate();
 }
 
 /*============================================================================*/
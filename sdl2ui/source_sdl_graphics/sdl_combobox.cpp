@@ -225,6 +225,7 @@ void Ccombobox::setValue( const std::string &value)
 	}
 	m_values.push_back(value);
 	m_index=(int)m_values.size();
+	invalidate();
 }
 
 int Ccombobox::getChoice()
@@ -235,6 +236,7 @@ int Ccombobox::getChoice()
 void Ccombobox::setChoice( int x)
 {
 	m_index =x;
+	invalidate();
 }
 
 void Ccombobox::next()
@@ -248,4 +250,5 @@ void Ccombobox::next()
 	{
 		m_index=0;
 	}
+	invalidate();
 }
@@ -0,0 +1,182 @@
+/*============================================================================*/
+/**  @file       sdl_damage_region.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Keep the parts of the screen that must be painted again.
+ **
+ **  Merge invalidated rectangles.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CdamageRegion
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include "sdl_damage_region.h"
+#include "sdl_graphics.h"
+
+/** @brief Constructor, nothing damaged. */
+CdamageRegion::CdamageRegion()
+: m_bounds( 0, 0, 0, 0)
+, m_full( false)
+{
+}
+
+/** @brief Destructor. */
+CdamageRegion::~CdamageRegion()
+{
+	m_rects.clear();
+}
+
+/** @brief Set the size of the screen.
+ *  @param bounds [in] Everything outside is never painted.
+ */
+void CdamageRegion::setBounds( const Crect &bounds)
+{
+	m_bounds =bounds;
+}
+
+/** @brief Smallest rectangle around two rectangles.
+ *  @param a [in] First rectangle.
+ *  @param b [in] Second rectangle.
+ *  @return Rectangle around both.
+ */
+Crect CdamageRegion::join( const Crect &a, const Crect &b)
+{
+	int left =gMin( a.left(), b.left());
+	int top =gMin( a.top(), b.top());
+	int right =gMax( a.right(), b.right());
+	int bottom =gMax( a.bottom(), b.bottom());
+	return Crect( left, top, right-left, bottom-top);
+}
+
+/** @brief Add a damaged rectangle.
+ *         Rectangles that overlap or touch are merged when the merged area
+ *         does not paint much more than both parts.
+ *  @param rect [in] Rectangle in pixels.
+ */
+void CdamageRegion::add( const Crect &rect)
+{
+	if ( m_full)
+	{
+		return;
+	}
+	Crect r( rect);
+	if ( m_bounds.width()>0 && m_bounds.height()>0)
+	{
+		// Clip to the screen.
+		int left =gMax( r.left(), m_bounds.left());
+		int top =gMax( r.top(), m_bounds.top());
+		int right =gMin( r.right(), m_bounds.right());
+		int bottom =gMin( r.bottom(), m_bounds.bottom());
+		r =Crect( left, top, right-left, bottom-top);
+	}
+	if ( r.width()<=0 || r.height()<=0)
+	{
+		return;
+	}
+	bool merged =true;
+	while ( merged)
+	{
+		merged =false;
+		for ( int a=0; a<(int)m_rects.size(); a++)
+		{
+			Crect total =join( m_rects[a], r);
+			if (   m_rects[a].collision( r)
+				|| area( total)<=area( m_rects[a])+area( r))
+			{
+				// Remove and try again with the bigger one.
+				r =total;
+				m_rects.erase( m_rects.begin()+a);
+				merged =true;
+				break;
+			}
+		}
+	}
+	m_rects.push_back( r);
+	if ( (int)m_rects.size()>MAXIMUM_DAMAGE_RECTS)
+	{
+		Crect total( m_rects[0]);
+		for ( int a=1; a<(int)m_rects.size(); a++)
+		{
+			total =join( total, m_rects[a]);
+		}
+		m_rects.clear();
+		m_rects.push_back( total);
+	}
+}
+
+/** @brief Everything must be painted again. */
+void CdamageRegion::addAll()
+{
+	m_full =true;
+	m_rects.clear();
+}
+
+/** @brief Nothing to paint. */
+void CdamageRegion::clear()
+{
+	m_full =false;
+	m_rects.clear();
+}
+
+/** @brief Check if an object must be painted.
+ *  @param rect [in] Object rectangle in pixels.
+ *  @return true when any part is damaged.
+ */
+bool CdamageRegion::overlap( const Crect &rect) const
+{
+	if ( m_full)
+	{
+		return true;
+	}
+	for ( int a=0; a<(int)m_rects.size(); a++)
+	{
+		if ( m_rects[a].overlap( rect))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief Tell how many pixels are damaged.
+ *  @return Pixels to paint.
+ */
+int CdamageRegion::area() const
+{
+	if ( m_full)
+	{
+		return m_bounds.width()*m_bounds.height();
+	}
+	int total =0;
+	for ( int a=0; a<(int)m_rects.size(); a++)
+	{
+		total +=area( m_rects[a]);
+	}
+	return total;
+}
@@ -44,6 +44,7 @@
 #include "sdl_dialog_event.h"
 #include "sdl_dialog_list.h"
 #include "sdl_label.h"
+#include "sdl_profiler.h"
 
 
 pthread_mutex_t Cdialog::m_objectMutex;
@@ -104,6 +105,7 @@ Cdialog::Cdialog( Cdialog *parent, const std::string &name, const Crect &rect, I
 		m_full_screen =true;
 	}
 
+	m_hitGrid.setSize( Csize( m_squares_width, m_squares_height));
 	m_world->lock();
 	m_name =name;
 	m_current_thread =pthread_self();
@@ -153,6 +155,7 @@ void Cdialog::unregisterObject(CdialogObject *child)
 		if (*i==child)
 		{
 			m_objects.erase(i);
+			m_hitGrid.remove( child);
 			//Log.write("Cdialog::unregisterObject:%s now has lost child object %s", m_name.c_str(), child->m_name.c_str());
 			break;
 		}
@@ -190,6 +193,7 @@ void Cdialog::registerObject(CdialogObject *child)
 	if (!found)
 	{
 		m_objects.push_back(child);
+		m_hitGrid.add( child);
 	}
 	//Log.write("Cdialog::registerObject:%s now has child object %s", m_name.c_str(), child->m_name.c_str());
 	objectUnlock(); // Object list should not change end.
@@ -209,6 +213,51 @@ void Cdialog::invalidate( bool needs_repaint)
 	m_world->unlock();
 }
 
+/*============================================================================*/
+///
+/// @brief 		Tell when the dialog needs the main loop again without input.
+///
+/// @return     Milliseconds, -1 when only input changes the dialog.
+///
+/*============================================================================*/
+int Cdialog::nextDeadline()
+{
+	int deadline =m_touchList.nextDeadline();
+	for ( auto a : m_children)
+	{
+		Cdialog *t=dynamic_cast<Cdialog*>(a);
+		if ( t)
+		{
+			deadline =earliestDeadline( deadline, t->nextDeadline());
+		}
+	}
+	return deadline;
+}
+
+/*============================================================================*/
+///
+/// @brief 		Invalidate part of the GUI. Only this part is re-painted.
+///
+/// @param      rect [in] Damaged rectangle in pixels.
+///
+/*============================================================================*/
+void Cdialog::invalidateRect( const Crect &rect)
+{
+	if ( m_world ==NULL)
+	{
+		return;
+	}
+	if ( m_full_screen)
+	{
+		m_world->invalidateRect( rect);
+	}
+	else
+	{
+		// Private graphics are composed as one.
+		invalidate();
+	}
+}
+
 /*============================================================================*/
 ///
 /// @brief 		Invalidate GUI. This will be re-painted.
@@ -265,6 +314,25 @@ bool Cdialog::onInit()
 	return true;
 }
 
+/*============================================================================*/
+///
+/// @brief 		Start decoding images before the first paint.
+///
+/// @param      images [in] File names, normally called from onInit.
+///
+/*============================================================================*/
+void Cdialog::prefetch( const std::vector<std::string> &images)
+{
+	if ( !m_graphics)
+	{
+		return;
+	}
+	for ( int a=0; a<(int)images.size(); a++)
+	{
+		m_graphics->prefetchImage( images[a]);
+	}
+}
+
 /*============================================================================*/
 ///
 /// @brief 		Loop for the dialog.
@@ -359,13 +427,16 @@ int Cdialog::onExecute( Cdialog *parent)
 			break;
 		}
 		m_world->unlock();
-		if ( m_touchList.update( CdialogEvent::Instance()->pressMouse(), CdialogEvent::Instance()->lastMouse()))
+		if (   m_touchList.update( CdialogEvent::Instance()->pressMouse(), CdialogEvent::Instance()->lastMouse())
+			&& !Cgraphics::m_defaults.damage_tracking)
 		{
+			// Otherwise the glowing objects invalidate themselves.
 			invalidate();
 		}
 		if (no_action==true)
 		{
-			delay(10);
+			// Sleep until input or the next animation step.
+			m_world->waitEvent( this);
 		}
 	}
 	if (started)
@@ -443,6 +514,28 @@ void Cdialog::onClearScreen()
 #endif
 }
 
+/*============================================================================*/
+///
+/// @brief Paint a damaged rectangle with the background.
+///
+/// @param rect [in] Rectangle in pixels, clipping is set by the caller.
+///
+/*============================================================================*/
+void Cdialog::onClearScreen( const Crect &rect)
+{
+    bool fullscreen = ( m_rect.width()==Cgraphics::m_defaults.width/8 &&
+			 m_rect.height()==Cgraphics::m_defaults.height/8);
+
+	m_world->graphics()->setColour( m_backgroundColour );
+	m_world->graphics()->bar( rect.left(), rect.top(), rect.right(), rect.bottom(),0);
+	if ( fullscreen)
+	{
+ 		m_world->graphics()->image( Cgraphics::m_defaults.full_screen_image_background,
+				           m_rect.left()*8, m_rect.top()*8,
+			               m_rect.width()*8, m_rect.height()*8);
+	}
+}
+
 /*============================================================================*/
 ///
 ///  @brief 	Paint the dialog once. Use invalidate() to re-paint soon.
@@ -454,14 +547,45 @@ void Cdialog::onClearScreen()
 /*============================================================================*/
 void Cdialog::onPaintButtons()
 {
+	PROFILE_SCOPE( "Cdialog::onPaintButtons");
 	objectLock(); // Object list should not change.
 
 	for (dialogObjectIterator a=m_objects.begin(); a!=m_objects.end(); ++a)
 	{
 		CdialogObject *b=*a;
 
+		m_hitGrid.update( b);
+		int level;
+		m_touchList.getFactor( b, &level);
+		PROFILE_OBJECT( b);
+		b->onPaint( level);
+	}
+	objectUnlock(); // Object list should not change end.
+}
+
+/*============================================================================*/
+///
+///  @brief 	Paint the objects inside a damaged rectangle.
+///
+///  @param     rect [in] Damaged rectangle in pixels.
+///
+/*============================================================================*/
+void Cdialog::onPaintButtons( const Crect &rect)
+{
+	PROFILE_SCOPE( "Cdialog::onPaintButtons");
+	objectLock(); // Object list should not change.
+
+	for (dialogObjectIterator a=m_objects.begin(); a!=m_objects.end(); ++a)
+	{
+		CdialogObject *b=*a;
+		m_hitGrid.update( b);
+		if ( !rect.overlap( b->m_rect*8))
+		{
+			continue;
+		}
 		int level;
 		m_touchList.getFactor( b, &level);
+		PROFILE_OBJECT( b);
 		b->onPaint( level);
 	}
 	objectUnlock(); // Object list should not change end.
@@ -959,22 +1083,7 @@ CdialogObject * Cdialog::findObject( const Cpoint &p)
 	{
 		return dialog->findObject( p);
 	}
-	CdialogObject *retVal =NULL;
-
-	objectLock(); // Object list should not change.
-
-	for (dialogObjectReverseIterator di=m_objects.rbegin();
-			di!=m_objects.rend(); ++di)
-	{
-		CdialogObject *cd =*di;
-		if ( cd->m_visible ==true && cd->m_rect.inside( p2))
-		{
-			retVal =cd;
-			break;
-		}
-	}
-	objectUnlock(); // Object list should not change.
-	return retVal;
+	return m_hitGrid.findObject( p2);
 }
 
 
@@ -1092,7 +1201,11 @@ keybutton Cdialog::findButton( const Cpoint &p)
 		CswypeDialog *scroll =dynamic_cast<CswypeDialog*>(dialog);
 		if ( !scroll)
 		{
-			key =m_graphics->m_touch.getKey( q);
+			// Buttons are in the grid, backgrounds are painted in the touch area.
+			if ( !dialog->m_hitGrid.findKey( q, key))
+			{
+				key =m_graphics->m_touch.getKey( q);
+			}
 		}
 		else
 		{
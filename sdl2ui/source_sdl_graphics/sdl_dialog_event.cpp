@@ -36,9 +36,11 @@
  **===========================================================================*/
 
 /*------------- Standard includes --------------------------------------------*/
+#include <sys/time.h>
 #include "sdl_dialog_event.h"
 #include "sdl_dialog_object.h"
 #include "sdl_keybutton.h"
+#include "sdl_profiler.h"
 #define RANDOM(x)		(int) ((x) * (rand() / (RAND_MAX + 1.0)))
 
 /*============================================================================*/
@@ -65,6 +67,7 @@ CdialogEvent::CdialogEvent()
 , m_press(0,0)
 , m_isPressed(false)
 , m_longDebounced(false)
+, m_wakeUp(false)
 , m_idiot(false)
 , m_debugPosition(0,0)
 {
@@ -77,11 +80,10 @@ CdialogEvent::CdialogEvent()
 	m_debounceTime =Cgraphics::m_defaults.touch_debounce_time;
 	m_debounceDist =Cgraphics::m_defaults.touch_debounce_distance;
 
-	while ( m_events.size()>0)
-	{
-		m_events.pop_front();
-	}
+	m_events.clear();
 	m_keyFile.init();
+	pthread_mutex_init( &m_waitMutex, NULL);
+	pthread_cond_init( &m_eventAdded, NULL);
 #ifdef ZHONGCAN_MULTI_THREAD
 	start();
 #endif
@@ -98,6 +100,8 @@ CdialogEvent::~CdialogEvent()
 	stop();
 #endif
 	m_keyFile.close();
+	pthread_cond_destroy( &m_eventAdded);
+	pthread_mutex_destroy( &m_waitMutex);
 }
 
 /** THREAD Do button repeats if a button is pressed longer, this should be done faster and faster.
@@ -109,6 +113,7 @@ CdialogEvent::~CdialogEvent()
  */
 void CdialogEvent::work()
 {
+	PROFILE_SCOPE( "CdialogEvent::work");
 	SDL_Event event;
 	bool found =false;
 
@@ -215,10 +220,135 @@ void CdialogEvent::work()
 			break;
 		}
 	}
+#ifdef ZHONGCAN_MULTI_THREAD
+	signalEvents();
 	if ( found ==false)
 	{
 		delay(5);
 	}
+#else
+	(void)found;
+#endif
+}
+
+/** THREAD Wake the main loop when events are queued. */
+void CdialogEvent::signalEvents()
+{
+	if ( m_events.empty())
+	{
+		return;
+	}
+	// Taking the mutex after the push means the waiter either sees the
+	// event or is already waiting for the signal.
+	pthread_mutex_lock( &m_waitMutex);
+	pthread_cond_signal( &m_eventAdded);
+	pthread_mutex_unlock( &m_waitMutex);
+}
+
+/** @brief Sleep until an input event arrives, the main loop waits here.
+ *  With ZHONGCAN_MULTI_THREAD only the input thread reads SDL, the main
+ *  thread waits until that thread queues an event.
+ *  @param timeout [in] Maximum time to wait in msec.
+ *  @return true when an event arrived.
+ */
+bool CdialogEvent::waitEvent( int timeout)
+{
+#ifdef ZHONGCAN_MULTI_THREAD
+	pthread_mutex_lock( &m_waitMutex);
+	if ( m_events.empty() && !m_wakeUp)
+	{
+		struct timeval now;
+		struct timespec until;
+		gettimeofday( &now, NULL);
+		long usec =now.tv_usec+timeout*1000L;
+		until.tv_sec =now.tv_sec+usec/1000000L;
+		until.tv_nsec =(usec%1000000L)*1000L;
+		pthread_cond_timedwait( &m_eventAdded, &m_waitMutex, &until);
+	}
+	bool found =!m_events.empty();
+	m_wakeUp =false;
+	pthread_mutex_unlock( &m_waitMutex);
+	return found;
+#elif defined(USE_SDL2)
+	SDL_Event event;
+	event.type=0;
+	if ( SDL_WaitEventTimeout( &event, timeout)!=1)
+	{
+		return false;
+	}
+	if ( event.type ==SDL_USEREVENT)
+	{
+		// From wakeUp(), no input.
+		return false;
+	}
+	if (event.type ==EVENT_INVALID)
+	{
+		return true;
+	}
+	Cevent c(&event, m_interface ? m_interface->spaceIsLanguage():true, false);
+	handleEvent(c);
+	return true;
+#else
+	// SDL1 cannot wait with a timeout.
+	delay( gMin( timeout, 10));
+	return false;
+#endif
+}
+
+/** @brief THREAD Let waitEvent() return now, e.g. when an image is decoded. */
+void CdialogEvent::wakeUp()
+{
+#ifdef ZHONGCAN_MULTI_THREAD
+	pthread_mutex_lock( &m_waitMutex);
+	m_wakeUp =true;
+	pthread_cond_signal( &m_eventAdded);
+	pthread_mutex_unlock( &m_waitMutex);
+#elif defined(USE_SDL2)
+	SDL_Event event;
+	SDL_zero( event);
+	event.type =SDL_USEREVENT;
+	SDL_PushEvent( &event);
+#endif
+}
+
+/** @brief Tell when work() must run again without new input.
+ *  @return Milliseconds until a debounce, long press or drag starts, -1 for none.
+ */
+int CdialogEvent::nextDeadline()
+{
+	int deadline =-1;
+	if ( !m_events.empty() || !m_batch.empty() || m_idiot)
+	{
+		return 0;
+	}
+	lock();
+	switch (m_inputStat)
+	{
+	case MOUSE_PRESS:
+		if ( m_longDebounced==false)
+		{
+			int wait =Cgraphics::m_defaults.touch_debounce_long_time-m_mouseLongDebounce.elapsed()+1;
+			deadline =earliestDeadline( deadline, gMax( wait, 0));
+		}
+		break;
+	case MOUSE_RELEASE_DEBOUNCE:
+	case MOUSE_PRESS_DEBOUNCE:
+		deadline =earliestDeadline( deadline, gMax( m_debounceTime-m_mouseDebounce.elapsed()+1, 0));
+		break;
+	default:
+		break;
+	}
+	switch (m_mouseStat)
+	{
+	case MOUSE_START_DRAG:
+	case MOUSE_START_SCROLL_OR_DRAG:
+		deadline =earliestDeadline( deadline, gMax( m_minimumDragTime-m_mousePress.elapsed()+1, 0));
+		break;
+	default:
+		break;
+	}
+	unlock();
+	return deadline;
 }
 
 /** @brief Convert an input event to a string.
@@ -985,7 +1115,12 @@ EpollStatus CdialogEvent::pollEvent( CeventInterface *callback)
 	default:
 		break;
 	}
-	if ( m_events.empty() ==true)
+	if ( m_batch.empty())
+	{
+		// Take all waiting events at once, the writer is not disturbed per event.
+		m_events.drain( m_batch);
+	}
+	if ( m_batch.empty() ==true)
 	{
 		SDL_Event event;
 		if ( Cgraphics::m_defaults.get_test_event &&
@@ -998,10 +1133,10 @@ EpollStatus CdialogEvent::pollEvent( CeventInterface *callback)
 		}
 		return retVal;
 	}
-	Cevent event =m_events.front();
+	Cevent event =m_batch.front();
 	//Cgraphics::m_defaults.log("poll event %s", event.toString().c_str());
 
-	m_events.pop_front();
+	m_batch.pop_front();
 	m_keyFile.onEvent( event);
 	handleEvent( callback, event);
 	return event.status;
@@ -1159,44 +1294,128 @@ void CdialogEvent::registerActiveDialog( CeventInterface *interface) //{ m_inter
 	unlock();
 }
 
+/// Slot is empty.
+#define SLOT_FREE		0
+/// Slot has an event to read.
+#define SLOT_PUBLISHED	1
+/// Reader copies the event.
+#define SLOT_READING	2
+/// Writer merges a mouse move into the event.
+#define SLOT_MERGING	3
+
 /// @brief Queue for events.
 CeventQueue::CeventQueue()
-: m_size(0)
+: m_head(0)
+, m_tail(0)
+, m_overflows(0)
+, m_merged(0)
 {}
 
 /** @brief Destructor */
 CeventQueue::~CeventQueue()
 {}
 
-/** @brief Add event to the event queue.
+/** @brief Merge a mouse move with the last move, when it is not read yet.
+ *         Called by the writer only.
+ *  @param event [in] New mouse move.
+ *  @return true when merged.
+ */
+bool CeventQueue::merge( const Cevent &event)
+{
+	unsigned int tail =m_tail.load( std::memory_order_relaxed);
+	unsigned int head =m_head.load( std::memory_order_acquire);
+	if ( tail ==head)
+	{
+		return false;
+	}
+	SeventSlot &slot =m_slots[(tail-1)&(EVENT_QUEUE_SIZE-1)];
+	if ( slot.event.type !=EVENT_TOUCH_MOVE || slot.event.status !=event.status)
+	{
+		return false;
+	}
+	int expected =SLOT_PUBLISHED;
+	if ( !slot.state.compare_exchange_strong( expected, SLOT_MERGING, std::memory_order_acquire))
+	{
+		// Reader has it already.
+		return false;
+	}
+	slot.event.point =event.point;
+	slot.event.which =event.which;
+	slot.state.store( SLOT_PUBLISHED, std::memory_order_release);
+	m_merged++;
+	return true;
+}
+
+/** @brief Add event to the event queue, called by the writer only.
  *  @param event [in] New event.
  */
 void CeventQueue::push_back( const Cevent &event)
 {
-	m_lock.lock();
-	m_eventList.push( event);
-	m_size++;
-	m_lock.unlock();
+	if ( event.type ==EVENT_TOUCH_MOVE && merge( event))
+	{
+		return;
+	}
+	unsigned int tail =m_tail.load( std::memory_order_relaxed);
+	unsigned int head =m_head.load( std::memory_order_acquire);
+	if ( tail-head>=EVENT_QUEUE_SIZE)
+	{
+		m_overflows++;
+		return;
+	}
+	SeventSlot &slot =m_slots[tail&(EVENT_QUEUE_SIZE-1)];
+	slot.event =event;
+	slot.state.store( SLOT_PUBLISHED, std::memory_order_release);
+	m_tail.store( tail+1, std::memory_order_release);
+}
+
+/** @brief Take the first event from the queue, called by the reader only.
+ *  @param event [out] First event.
+ *  @return false when the queue is empty.
+ */
+bool CeventQueue::pop( Cevent &event)
+{
+	unsigned int head =m_head.load( std::memory_order_relaxed);
+	if ( head ==m_tail.load( std::memory_order_acquire))
+	{
+		return false;
+	}
+	SeventSlot &slot =m_slots[head&(EVENT_QUEUE_SIZE-1)];
+	int expected =SLOT_PUBLISHED;
+	while ( !slot.state.compare_exchange_weak( expected, SLOT_READING, std::memory_order_acquire))
+	{
+		// Writer is merging a mouse move, this takes a few instructions.
+		expected =SLOT_PUBLISHED;
+	}
+	event =slot.event;
+	slot.state.store( SLOT_FREE, std::memory_order_release);
+	m_head.store( head+1, std::memory_order_release);
+	return true;
 }
 
-/** @brief Get the first event from the queue.
- *  @return First event from stack.
+/** @brief Take many events at once, called by the reader only.
+ *  @param events [out] Events are added at the end.
+ *  @param maximum [in] Maximum events to take.
+ *  @return Number of events taken.
  */
-Cevent CeventQueue::front()
+int CeventQueue::drain( std::deque<Cevent> &events, int maximum)
 {
-	m_lock.lock();
-	Cevent evt =m_eventList.front();
-	m_lock.unlock();
-	return evt;
+	int n=0;
+	Cevent event( EVENT_INVALID, Cpoint(0,0), false);
+	while ( n<maximum && pop( event))
+	{
+		events.push_back( event);
+		n++;
+	}
+	return n;
 }
 
-/** @brief Remove first element from event stack. */
-void CeventQueue::pop_front()
+/** @brief Remove all events, called by the reader only. */
+void CeventQueue::clear()
 {
-	m_lock.lock();
-	m_eventList.pop();
-	m_size--;
-	m_lock.unlock();
+	Cevent event( EVENT_INVALID, Cpoint(0,0), false);
+	while ( pop( event))
+	{
+	}
 }
 
 /** @brief Find how many items in the queue.
@@ -1204,10 +1423,8 @@ void CeventQueue::pop_front()
  */
 int CeventQueue::size()
 {
-	m_lock.lock();
-	int n =m_eventList.size();
-	m_lock.unlock();
-	return n;
+	unsigned int head =m_head.load( std::memory_order_acquire);
+	return (int)(m_tail.load( std::memory_order_acquire)-head);
 }
 
 /** @brief Check if the event queue is empty.
@@ -1215,8 +1432,5 @@ int CeventQueue::size()
  */
 bool CeventQueue::empty()
 {
-	m_lock.lock();
-	bool b =m_eventList.empty();
-	m_lock.unlock();
-	return b;
+	return size() ==0;
 }
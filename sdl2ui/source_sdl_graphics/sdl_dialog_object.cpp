@@ -53,6 +53,7 @@ CdialogObject::CdialogObject( Cdialog *parent, const Crect &rect, keybutton code
 , m_visible( true)
 , m_graphics( NULL)
 , m_parent( parent)
+, m_glow( -1)
 {
 	if ( parent !=NULL && parent->m_graphics !=NULL)
 	{
@@ -87,6 +88,65 @@ void CdialogObject::onUpdate()
 	m_graphics->update(m_rect*8);
 }
 
+/** @brief Paint me again in the next frame, only this rectangle is damaged. */
+void CdialogObject::invalidate()
+{
+	invalidate( m_rect);
+}
+
+/** @brief Damage a part painted by this object, e.g. a text next to it.
+ *  @param rect [in] Rectangle in touch squares.
+ */
+void CdialogObject::invalidate( const Crect &rect)
+{
+	if ( m_parent)
+	{
+		m_parent->invalidateRect( rect*8);
+	}
+	else if ( Cdialog::g_defaultWorld)
+	{
+		Cdialog::g_defaultWorld->invalidateRect( rect*8);
+	}
+}
+
+/** @brief Move the object, the parent finds it on the new place.
+ *  @param rect [in] New position and size in touch squares.
+ */
+void CdialogObject::setRect( const Crect &rect)
+{
+	m_rect =rect;
+	if ( m_parent)
+	{
+		m_parent->m_hitGrid.update( this);
+	}
+}
+
+/** @brief Move the object horizontally.
+ *  @param left [in] New left side in touch squares.
+ */
+void CdialogObject::setLeft( int left)
+{
+	m_rect.setLeft( left);
+	if ( m_parent)
+	{
+		m_parent->m_hitGrid.update( this);
+	}
+}
+
+/** @brief Touch on this object gives its key code. Call when painted. */
+void CdialogObject::setTouchKey()
+{
+	if ( m_graphics ==NULL || m_graphics->keycodesLocked())
+	{
+		return;
+	}
+	// Objects outside a dialog still use the touch area of the screen.
+	if ( m_parent ==NULL || !m_parent->m_hitGrid.setKeyed( this))
+	{
+		m_graphics->setCode( m_rect, m_code);
+	}
+}
+
 /** @brief Destructor. */
 CdialogObject::~CdialogObject()
 {
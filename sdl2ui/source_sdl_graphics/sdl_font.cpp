@@ -36,41 +36,118 @@
  **===========================================================================*/
 
 /*------------- Standard includes --------------------------------------------*/
+#include <stdio.h>
 #include "sdl_font.h"
 #include "sdl_graphics.h"
+#include "sdl_text_cache.h"
+#include "sdl_text_layout.h"
 
 /// @brief List of all fonts.
-std::vector<SsingleFont> CtextFont::m_fonts;
+std::unordered_map<SfontKey, SsingleFont, SfontKeyHash> CtextFont::m_fonts;
+std::unordered_map<TTF_Font*, SfontKey> CtextFont::m_keys;
+CmyLock CtextFont::m_lock;
 
 SsingleFont emptyFont =
 		{ "", 0, NULL };
 
-/// @brief Find a single font.
-SsingleFont CtextFont::findFont( const std::string &fontName, int pixels)
+/// @brief Find a single font, open it the first time.
+SsingleFont CtextFont::findFont( const std::string &fontName, int pixels, int style)
 {
-	for ( int a=0; a<(int)m_fonts.size(); a++)
+	SfontKey key;
+	key.name =fontName;
+	key.pixels =pixels;
+	key.style =style;
+	m_lock.lock();
+	std::unordered_map<SfontKey, SsingleFont, SfontKeyHash>::iterator it =m_fonts.find( key);
+	if ( it !=m_fonts.end())
 	{
-		if ( m_fonts[a].pixels ==pixels && m_fonts[a].name ==fontName)
-		{
-			return m_fonts[a];
-		}
+		SsingleFont sf =it->second;
+		m_lock.unlock();
+		return sf;
 	}
 	std::string s=Cgraphics::m_defaults.font_path + fontName;
     if (!TTF_WasInit()) TTF_Init(); // Initilize SDL_ttf
 	TTF_Font *font =TTF_OpenFont( s.c_str(), pixels);
 	if (!font)
 	{
-		const char *err = TTF_GetError();
+		m_lock.unlock();
         return emptyFont;
 	}
+	// Every style has its own font, nobody changes the style while painting.
+	TTF_SetFontStyle( font, style);
 	SsingleFont sf;
 	sf.font =font;
 	sf.name =fontName;
 	sf.pixels =pixels;
-	m_fonts.push_back( sf);
+	m_fonts[key] =sf;
+	m_keys[font] =key;
+	m_lock.unlock();
+	CtextLayout::Instance()->prepare( font);
 	return sf;
 }
 
+/** @brief Same font file and size in another style.
+ *  @param font [in] Opened font.
+ *  @param style [in] TTF style, e.g. TTF_STYLE_BOLD.
+ *  @return Font with that style, the same font when it already has it.
+ */
+TTF_Font *CtextFont::styled( TTF_Font *font, int style)
+{
+	if ( !font)
+	{
+		return NULL;
+	}
+	m_lock.lock();
+	std::unordered_map<TTF_Font*, SfontKey>::iterator it =m_keys.find( font);
+	if ( it ==m_keys.end() || it->second.style ==style)
+	{
+		m_lock.unlock();
+		return font;
+	}
+	SfontKey key =it->second;
+	m_lock.unlock();
+	TTF_Font *result =findFont( key.name, key.pixels, style).font;
+	return result ? result:font;
+}
+
+/** @brief Open all fonts from a manifest before the first dialog is shown.
+ *  Each line has a file name, pixels and optional styles, e.g.
+ *  "Ubuntu-M.ttf 16 bold". Empty lines and lines with # are skipped.
+ *  @param manifest [in] Full path of the manifest.
+ *  @return Number of opened fonts.
+ */
+int CtextFont::preload( const std::string &manifest)
+{
+	FILE *fp =fopen( manifest.c_str(), "r");
+	if ( !fp)
+	{
+		return 0;
+	}
+	int opened =0;
+	char line[256];
+	while ( fgets( line, sizeof(line), fp))
+	{
+		char name[200];
+		int pixels =0;
+		int used =0;
+		if ( line[0] =='#' || sscanf( line, "%199s %d%n", name, &pixels, &used)<2 || pixels<=0)
+		{
+			continue;
+		}
+		int style =TTF_STYLE_NORMAL;
+		std::string styles( line+used);
+		if ( styles.find( "bold") !=std::string::npos) style |=TTF_STYLE_BOLD;
+		if ( styles.find( "italic") !=std::string::npos) style |=TTF_STYLE_ITALIC;
+		if ( styles.find( "underline") !=std::string::npos) style |=TTF_STYLE_UNDERLINE;
+		if ( findFont( name, pixels, style).font)
+		{
+			opened++;
+		}
+	}
+	fclose( fp);
+	return opened;
+}
+
 /// @brief Construct a font.
 CtextFont::CtextFont( std::string localFontName, int localPixels,
 					  std::string chineseFontName, int chinesePixels)
@@ -129,14 +206,17 @@ CtextFont::CtextFont( const char *fname, bool relative_to_screen)
 void CtextFont::closeFonts()
 {
 	//Log.write( "CtextFont::closeFonts  Closing.");
-	for ( int a=0; a<(int)m_fonts.size(); a++)
+	// Cached text keys refer to the fonts.
+	CtextCache::Instance()->clear();
+	CtextLayout::Instance()->clear();
+	m_lock.lock();
+	for ( std::unordered_map<SfontKey, SsingleFont, SfontKeyHash>::iterator it =m_fonts.begin(); it !=m_fonts.end(); ++it)
 	{
-		TTF_CloseFont( m_fonts[a].font);
-		m_fonts[a].name ="";
-		m_fonts[a].pixels =0;
-		m_fonts[a].font =NULL;
+		TTF_CloseFont( it->second.font);
 	}
 	m_fonts.clear();
+	m_keys.clear();
+	m_lock.unlock();
 	if (TTF_WasInit()) TTF_Quit(); // Deinitilize SDL_ttf
 }
 
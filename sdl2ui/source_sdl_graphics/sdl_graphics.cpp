@@ -43,6 +43,10 @@
 #include <math.h>
 #include <SDL_image.h>
 #include "SDL_ttf.h"
+#include "sdl_text_cache.h"
+#include "sdl_look_cache.h"
+#include "sdl_image_loader.h"
+#include "sdl_profiler.h"
 
 #define SWAP(A,B,TYPE) {TYPE temp=A; A=B; B=temp;}
 
@@ -120,6 +124,18 @@ Sdefaults Cgraphics::m_defaults =
 	8, // touch_debounce_distance
 	0, // display coordinates
 	3000, // debounce long press
+	4*1024*1024, // text_cache_size
+	0, // text_cache_hits
+	0, // text_cache_misses
+	64*1024*1024, // image_cache_size
+	2, // image_decode_threads
+	1, // damage_tracking
+	0, // painted_pixels
+	100, // maximum_idle_time
+	1, // raster_fill
+	8*1024*1024, // look_cache_size
+	"", // font_manifest
+	0, // debug_profiler
 	NULL, // get_translation
 	NULL, // next_language
 	NULL, // get_test_event
@@ -135,16 +151,22 @@ Sdefaults Cgraphics::m_defaults =
  *  @param width [in] Width of graphics.
  *  @param height [in] Height of graphics.
  *  @param mainScreen [in] boolean, true for the main screen.
+ *  @param backend [in] Paint in a window or on a memory surface.
  * */
-Cgraphics::Cgraphics( const Csize &size, bool mainScreen):
+Cgraphics::Cgraphics( const Csize &size, bool mainScreen, EgraphicsBackend backend):
 #ifdef USE_SDL2
 	m_window(NULL),
 	m_renderer(NULL),
 	m_texture(NULL),
+	m_screen(NULL),
 #else
 	m_allocatedSurface(NULL),
 	m_renderSurface(NULL),
 #endif
+    m_imageBytes(0),
+    m_imageClock(0),
+    m_imageOwner( CimageLoader::newOwner()),
+    m_decoding(0),
     m_colour(0),
     m_topLayer(0),
 	m_cx(0),
@@ -160,6 +182,7 @@ Cgraphics::Cgraphics( const Csize &size, bool mainScreen):
 	m_lock_keycode(false),
 	m_bits(32),
     m_option(0),
+	m_backend( backend),
 	m_pixels(NULL)
 {
 	m_touch.setSize( Csize(size.width()/8, size.height()/8));
@@ -174,6 +197,18 @@ Cgraphics::~Cgraphics()
 void Cgraphics::close()
 {
 #ifdef USE_SDL2
+	if ( m_mainScreen && m_renderer)
+	{
+		// Cached text and looks belong to this renderer.
+		CtextCache::Instance()->clear();
+		ClookCache::Instance()->clear();
+	}
+	m_pool.clear();
+	for ( SDL_Texture *layer : m_layers)
+	{
+		SDL_DestroyTexture( layer);
+	}
+	m_layers.clear();
 	if ( m_texture)
 	{
 		SDL_DestroyTexture( m_texture);
@@ -189,6 +224,11 @@ void Cgraphics::close()
         SDL_DestroyWindow(m_window);
         m_window = NULL;
     }
+    if (m_screen)
+    {
+        SDL_FreeSurface(m_screen);
+        m_screen = NULL;
+    }
 
 	if ( m_mainScreen)
 	{
@@ -234,23 +274,49 @@ bool Cgraphics::init( const std::string &caption, int pixels, int colour)
     (void)pixels;
     if ( m_mainScreen)
     {
-		if(SDL_Init( SDL_INIT_TIMER | SDL_INIT_AUDIO | SDL_INIT_VIDEO
-				   | SDL_INIT_EVENTS | SDL_INIT_HAPTIC
-				   | SDL_INIT_GAMECONTROLLER) < 0)
+		if ( m_backend ==GRAPHICS_HEADLESS)
+		{
+			// No display, audio or GPU needed, e.g. SDL_VIDEODRIVER=dummy on a build server.
+			if ( SDL_Init( SDL_INIT_TIMER | SDL_INIT_EVENTS) < 0)
+			{
+				return false;
+			}
+			m_screen = SDL_CreateRGBSurfaceWithFormat( 0, m_size.width(), m_size.height(),
+			                                           32, SDL_PIXELFORMAT_ARGB8888);
+			if ( m_screen ==NULL)
+			{
+				return false;
+			}
+			m_renderer = SDL_CreateSoftwareRenderer( m_screen);
+		}
+		else
+		{
+			if(SDL_Init( SDL_INIT_TIMER | SDL_INIT_AUDIO | SDL_INIT_VIDEO
+					   | SDL_INIT_EVENTS | SDL_INIT_HAPTIC
+					   | SDL_INIT_GAMECONTROLLER) < 0)
+			{
+				return false;
+			}
+			m_window = SDL_CreateWindow( caption.c_str(),
+			                          SDL_WINDOWPOS_UNDEFINED,
+			                          SDL_WINDOWPOS_UNDEFINED,
+			                          m_size.width(), m_size.height(),
+			                          (m_option ==1) ?
+			                        		  SDL_WINDOW_FULLSCREEN|SDL_WINDOW_SHOWN:SDL_WINDOW_BORDERLESS|SDL_WINDOW_SHOWN
+			                          //SDL_WINDOW_FULLSCREEN | SDL_WINDOW_OPENGL:SDL_WINDOW_OPENGL
+			                          );
+			m_renderer = SDL_CreateRenderer( m_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC); //SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC );
+		}
+		if ( m_renderer ==NULL)
 		{
 			return false;
 		}
-		m_window = SDL_CreateWindow( caption.c_str(),
-		                          SDL_WINDOWPOS_UNDEFINED,
-		                          SDL_WINDOWPOS_UNDEFINED,
-		                          m_size.width(), m_size.height(),
-		                          (m_option ==1) ?
-		                        		  SDL_WINDOW_FULLSCREEN|SDL_WINDOW_SHOWN:SDL_WINDOW_BORDERLESS|SDL_WINDOW_SHOWN
-		                          //SDL_WINDOW_FULLSCREEN | SDL_WINDOW_OPENGL:SDL_WINDOW_OPENGL
-		                          );
-		m_renderer = SDL_CreateRenderer( m_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC); //SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC );
+		m_pool.setRenderer( m_renderer);
 		//m_windowRenderer =m_renderer;
-		SDL_SetRelativeMouseMode(SDL_FALSE);
+		if ( m_window)
+		{
+			SDL_SetRelativeMouseMode(SDL_FALSE);
+		}
 
 #if 0
 		const SDL_VideoInfo *info =SDL_GetVideoInfo();
@@ -416,7 +482,10 @@ void Cgraphics::update( SDL_Texture *texture, SDL_Rect *destination)
 	{
 		SDL_RenderCopy( m_renderer, m_texture, NULL, destination);
 	}
-	SDL_RenderPresent( m_renderer);
+	{
+		PROFILE_SCOPE( "SDL_RenderPresent");
+		SDL_RenderPresent( m_renderer);
+	}
 	SDL_SetRenderTarget( m_renderer, m_texture);
 }
 #endif
@@ -448,12 +517,15 @@ bool Cgraphics::insertTexture( SDL_Texture *texture, int left, int top, int w, i
 void Cgraphics::update()
 {
 	//Log.write("Cgraphics::update");
-	if (m_init && m_option<2)
+	if (m_init && (m_option<2 || m_screen))
 	{
 #ifdef USE_SDL2
 		SDL_SetRenderTarget( m_renderer, NULL);
 		SDL_RenderCopy(m_renderer, m_texture, NULL, NULL);
-		SDL_RenderPresent( m_renderer);
+		{
+			PROFILE_SCOPE( "SDL_RenderPresent");
+			SDL_RenderPresent( m_renderer);
+		}
 		SDL_SetRenderTarget( m_renderer, m_texture);
 #else
 		SDL_UpdateRect( m_renderSurface,0,0,0,0);
@@ -469,7 +541,7 @@ void Cgraphics::update()
  */
 void Cgraphics::update( const Crect &rect)
 {
-	if (m_init && m_option<2)
+	if (m_init && (m_option<2 || m_screen))
 	{
 #ifdef USE_SDL2
 		if (m_texture)
@@ -482,7 +554,10 @@ void Cgraphics::update( const Crect &rect)
 			SDL_SetRenderTarget( m_renderer, NULL);
 			SDL_RenderCopy(m_renderer, m_texture, &rct, &rct);
 		}
-		SDL_RenderPresent( m_renderer);
+		{
+			PROFILE_SCOPE( "SDL_RenderPresent");
+			SDL_RenderPresent( m_renderer);
+		}
 		SDL_SetRenderTarget( m_renderer, m_texture);
 #else
 		SDL_UpdateRect( m_renderSurface,rect.left(),rect.top(),rect.width(),rect.height());
@@ -696,59 +771,317 @@ sdlTexture *Cgraphics::findImage( const std::string &fname)
 	{
 		return NULL;
 	}
-	for ( int a=0; a<(int)m_images.size(); a++)
+	return findImage( findImageId( fname));
+}
+
+/** @brief Find the identifier of an image, without loading it.
+ *  @param fname [in] File to search.
+ *  @return Identifier, stays valid while this graphics exists.
+ */
+imageId Cgraphics::findImageId( const std::string &fname)
+{
+	if ( fname.size()==0)
+	{
+		return INVALID_IMAGE_ID;
+	}
+	std::unordered_map<std::string, imageId>::iterator it =m_imageIds.find( fname);
+	if ( it !=m_imageIds.end())
 	{
-		if ( fname==m_images[a].name)
+		return it->second;
+	}
+	SimageSurface c;
+	c.image =NULL;
+	c.name =fname;
+	c.bytes =0;
+	c.users =0;
+	c.last_used =0;
+	c.missing =false;
+	c.decoding =false;
+	imageId id =(imageId)m_images.size();
+	m_images.push_back( c);
+	m_imageIds[fname] =id;
+	return id;
+}
+
+/** @brief Get an image by identifier, load it when needed.
+ *  @param id [in] Result of findImageId().
+ *  @return Surface to the picture.
+ */
+sdlTexture *Cgraphics::findImage( imageId id)
+{
+	if ( id<0 || id>=(int)m_images.size())
+	{
+		return NULL;
+	}
+	if ( m_decoding>0)
+	{
+		collectImages();
+	}
+	SimageSurface &c =m_images[id];
+	c.last_used =++m_imageClock;
+	if ( c.decoding)
+	{
+		return NULL;
+	}
+	if ( c.image ==NULL && !c.missing)
+	{
+		if ( Cgraphics::m_defaults.image_decode_threads>0)
+		{
+			// Paint a placeholder until the decoder is ready.
+			decodeImage( id);
+		}
+		else if ( loadImage( c))
 		{
-			if ( m_images[a].image ==NULL)
+			evictImages( id);
+		}
+		else
+		{
+			printf("Image not found %s!!\n", c.name.c_str());
+		}
+	}
+	return c.image;
+}
+
+/** @brief Keep an image in memory until releaseImage().
+ *  @param fname [in] File to use.
+ *  @return Identifier to paint with.
+ */
+imageId Cgraphics::acquireImage( const std::string &fname)
+{
+	imageId id =findImageId( fname);
+	if ( id !=INVALID_IMAGE_ID)
+	{
+		m_images[id].users++;
+	}
+	return id;
+}
+
+/** @brief Image no longer needed by a user, it may be evicted now.
+ *  @param id [in] Result of acquireImage().
+ */
+void Cgraphics::releaseImage( imageId id)
+{
+	if ( id<0 || id>=(int)m_images.size() || m_images[id].users<=0)
+	{
+		return;
+	}
+	m_images[id].users--;
+	if ( m_images[id].users ==0)
+	{
+		evictImages( INVALID_IMAGE_ID);
+	}
+}
+
+/** @brief Start loading an image on a decoder thread.
+ *  @param fname [in] File to load, e.g. during onInit of a dialog.
+ */
+void Cgraphics::prefetchImage( const std::string &fname)
+{
+	imageId id =findImageId( fname);
+	if ( id ==INVALID_IMAGE_ID)
+	{
+		return;
+	}
+	SimageSurface &c =m_images[id];
+	if ( c.image ==NULL && !c.missing && !c.decoding)
+	{
+		if ( Cgraphics::m_defaults.image_decode_threads>0)
+		{
+			decodeImage( id);
+		}
+		else
+		{
+			findImage( id);
+		}
+	}
+}
+
+/** @brief Check if an image is still loaded in the background.
+ *  @param id [in] Result of findImageId().
+ *  @return true when the decoder is not ready.
+ */
+bool Cgraphics::isDecoding( imageId id)
+{
+	if ( id<0 || id>=(int)m_images.size())
+	{
+		return false;
+	}
+	return m_images[id].decoding;
+}
+
+/** @brief Send an image to the decoder threads.
+ *  @param id [in] Image to load.
+ */
+void Cgraphics::decodeImage( imageId id)
+{
+	SimageSurface &c =m_images[id];
+	std::string s =c.name;
+	if ( c.name.find( "/")==std::string::npos)
+	{
+		s=Cgraphics::m_defaults.image_path + c.name;
+	}
+	c.decoding =true;
+	m_decoding++;
+	CimageLoader::Instance()->request( m_imageOwner, id, s);
+}
+
+/** @brief Take the decoded images and make them ready to paint.
+ *         Called from the main thread only, textures belong to the renderer.
+ *  @return true when any image arrived, so the screen should be painted.
+ */
+bool Cgraphics::collectImages()
+{
+	if ( m_decoding ==0)
+	{
+		return false;
+	}
+	std::vector<SimageJob> done;
+	if ( CimageLoader::Instance()->collect( m_imageOwner, done) ==false)
+	{
+		return false;
+	}
+	for ( int a=0; a<(int)done.size(); a++)
+	{
+		SimageJob &job =done[a];
+		m_decoding--;
+		if ( job.id<0 || job.id>=(int)m_images.size() || !m_images[job.id].decoding)
+		{
+			if ( job.surface)
 			{
-				printf("Image not found %s!!\n", m_images[a].name.c_str());
+				SDL_FreeSurface( job.surface);
 			}
-			return m_images[a].image;
+			continue;
+		}
+		SimageSurface &c =m_images[job.id];
+		c.decoding =false;
+		if ( job.surface ==NULL)
+		{
+			c.missing =true;
+			printf("Image not found %s!!\n", c.name.c_str());
+			continue;
+		}
+		destroyImage( c);
+#ifdef USE_SDL2
+		c.image =SDL_CreateTextureFromSurface( m_renderer, job.surface);
+		SDL_FreeSurface( job.surface);
+		if ( c.image ==NULL)
+		{
+			c.missing =true;
+			continue;
 		}
+		c.bytes =textureSize( c.image).area()*4;
+#else
+		c.image =job.surface;
+		c.bytes =c.image->pitch*c.image->h;
+#endif
+		m_imageBytes +=c.bytes;
+		evictImages( job.id);
 	}
-	SimageSurface c;
+	return true;
+}
+
+/** @brief Load an image from hard disk.
+ *  @param c [in] Image to load.
+ *  @return true on success.
+ */
+bool Cgraphics::loadImage( SimageSurface &c)
+{
 	try
 	{
-		c.name =fname;
+		std::string s =c.name;
 		if ( c.name.find( "/")==std::string::npos)
 		{
-			std::string s=Cgraphics::m_defaults.image_path + c.name;
+			s=Cgraphics::m_defaults.image_path + c.name;
+		}
 #ifdef USE_SDL2
-			c.image = IMG_LoadTexture( m_renderer, s.c_str());
+		c.image = IMG_LoadTexture( m_renderer, s.c_str());
 #else
-			c.image = IMG_Load( s.c_str() );
+		c.image = IMG_Load( s.c_str() );
 #endif
-		}
-		else
-		{
+	}
+	catch (...)
+	{
+		c.image =NULL;
+	}
+	if ( c.image ==NULL)
+	{
+		c.missing =true;
+		return false;
+	}
 #ifdef USE_SDL2
-			c.image = IMG_LoadTexture( m_renderer, c.name.c_str());
+	c.bytes =textureSize( c.image).area()*4;
 #else
-			c.image = IMG_Load( c.name.c_str() );
+	c.bytes =c.image->pitch*c.image->h;
 #endif
-		}
+	m_imageBytes +=c.bytes;
+	return true;
+}
+
+/** @brief Release the memory of an image, the identifier stays valid.
+ *  @param c [in] Image to destroy.
+ */
+void Cgraphics::destroyImage( SimageSurface &c)
+{
+	if ( c.image)
+	{
+#ifdef USE_SDL2
+		SDL_DestroyTexture( c.image);
+#else
+		SDL_FreeSurface( c.image);
+#endif
+		c.image =NULL;
 	}
-	catch (...)
+	m_imageBytes -=c.bytes;
+	c.bytes =0;
+}
+
+/** @brief Remove least recently used images without users, until the
+ *         memory is below image_cache_size.
+ *  @param keep [in] Image just loaded, never removed.
+ */
+void Cgraphics::evictImages( imageId keep)
+{
+	int budget =Cgraphics::m_defaults.image_cache_size;
+	while ( budget>0 && m_imageBytes>budget)
 	{
-		return NULL;
+		imageId oldest =INVALID_IMAGE_ID;
+		for ( int a=0; a<(int)m_images.size(); a++)
+		{
+			SimageSurface &c =m_images[a];
+			if ( a ==keep || c.image ==NULL || c.users>0)
+			{
+				continue;
+			}
+			if ( oldest ==INVALID_IMAGE_ID || c.last_used <m_images[oldest].last_used)
+			{
+				oldest =a;
+			}
+		}
+		if ( oldest ==INVALID_IMAGE_ID)
+		{
+			break;
+		}
+		destroyImage( m_images[oldest]);
 	}
-	m_images.push_back( c);
-	return c.image;
 }
 
 /** @brief Clean the surface to black. */
 void Cgraphics::clean()
 {
+	if ( m_decoding>0)
+	{
+		// Identifiers are gone, results of the decoders are useless.
+		CimageLoader::Instance()->cancel( m_imageOwner);
+		m_imageOwner =CimageLoader::newOwner();
+		m_decoding =0;
+	}
 	for ( int a=0; a<(int)m_images.size(); a++)
 	{
-#ifdef USE_SDL2
-		SDL_DestroyTexture( m_images[a].image);
-#else
-		SDL_FreeSurface(m_images[a].image);
-#endif
+		destroyImage( m_images[a]);
 	}
 	m_images.clear();
+	m_imageIds.clear();
+	m_imageBytes =0;
 }
 
 /** @brief Free image used by the graphics layer.
@@ -756,18 +1089,12 @@ void Cgraphics::clean()
  */
 void Cgraphics::freeImage( const std::string &image)
 {
-	for ( int a=0; a<(int)m_images.size(); a++)
+	std::unordered_map<std::string, imageId>::iterator it =m_imageIds.find( image);
+	if ( it !=m_imageIds.end())
 	{
-		if ( image ==m_images[a].name)
-		{
-#ifdef USE_SDL2
-			SDL_DestroyTexture( m_images[a].image);
-#else
-			SDL_FreeSurface(m_images[a].image);
-#endif
-			m_images.erase( m_images.begin()+a);
-			break;
-		}
+		// Identifier stays valid, the image is loaded again when used.
+		destroyImage( m_images[it->second]);
+		m_images[it->second].missing =false;
 	}
 }
 
@@ -937,9 +1264,18 @@ bool Cgraphics::imageInverse( const std::string &fname, int x1, int y1, int x2,
  *  @return true on success.
  */
 bool Cgraphics::image(const std::string &fname, int x1, int y1, int x2, int y2)
+{
+	return image( findImageId( fname), x1, y1, x2, y2);
+}
+
+/** @brief Set an image on screen.
+ *  @param id [in] Identifier of the image.
+ *  @return true on success.
+ */
+bool Cgraphics::image( imageId id, int x1, int y1, int x2, int y2)
 {
 #ifdef USE_SDL2
-	SDL_Texture *bitmap =findImage( fname);
+	SDL_Texture *bitmap =findImage( id);
 	if ( bitmap ==NULL || m_renderer ==NULL)
 	{
 		return false;
@@ -951,7 +1287,7 @@ bool Cgraphics::image(const std::string &fname, int x1, int y1, int x2, int y2)
 	dst.h =y2-y1;
 	SDL_RenderCopy( m_renderer, bitmap, NULL, &dst);
 #else
-	sdlTexture *bitmap =findImage( fname);
+	sdlTexture *bitmap =findImage( id);
 	int w=x2-x1;
 	int h=y2-y1;
 	if ( bitmap ==NULL || m_renderSurface ==NULL)
@@ -1087,6 +1423,51 @@ bool Cgraphics::renderTexture( SDL_Texture *texture, int x1, int y1, int w, int
 }
 #endif
 
+#ifdef USE_SDL2
+/** @brief Copy a surface to a pooled texture, for painting it more often.
+ *  @param surface [in] What to upload.
+ *  @param handle [in] Previous handle of the surface, when its content changed.
+ *  @return Handle, valid until releaseHandle() or until the surface changes.
+ */
+int Cgraphics::uploadSurface( SDL_Surface *surface, int handle)
+{
+	return m_pool.upload( surface, handle);
+}
+
+/** @brief Paint an uploaded surface.
+ *  @param handle [in] Result of uploadSurface().
+ *  @param x [in] Left position.
+ *  @param y [in] Top position.
+ *  @param w [in] Width, -1 for the surface width.
+ *  @param h [in] Height, -1 for the surface height.
+ *  @return true on success.
+ */
+bool Cgraphics::renderHandle( int handle, int x, int y, int w, int h)
+{
+	SDL_Rect src;
+	SDL_Texture *texture =m_pool.texture( handle, &src);
+	if ( texture ==NULL)
+	{
+		return false;
+	}
+	SDL_Rect rect;
+	rect.x =x;
+	rect.y =y;
+	rect.w =( w<0) ? src.w:w;
+	rect.h =( h<0) ? src.h:h;
+	SDL_RenderCopy( m_renderer, texture, &src, &rect);
+	return true;
+}
+
+/** @brief Give an uploaded surface back to the pool.
+ *  @param handle [in] Result of uploadSurface().
+ */
+void Cgraphics::releaseHandle( int handle)
+{
+	m_pool.release( handle);
+}
+#endif
+
 /** @brief Insert a surface on our image.
  *  @param surface [in] What to insert.
  *  @param
@@ -1094,19 +1475,10 @@ bool Cgraphics::renderTexture( SDL_Texture *texture, int x1, int y1, int w, int
 bool Cgraphics::renderSurface( SDL_Surface *surface, int x1, int y1)
 {
 #ifdef USE_SDL2
-	SDL_Texture *texture =SDL_CreateTextureFromSurface( m_renderer, surface);
-	if ( texture)
-	{
-		SDL_Rect rect;
-		rect.h =surface->h;
-		rect.w =surface->w;
-		rect.x=x1;
-		rect.y=y1;
-		SDL_RenderCopy( m_renderer, texture, NULL, &rect);
-		SDL_DestroyTexture( texture);
-		return true;
-	}
-	return false;
+	int handle =m_pool.upload( surface);
+	bool retVal =renderHandle( handle, x1, y1);
+	m_pool.release( handle);
+	return retVal;
 #else
 	if ( surface ==NULL)
 	{
@@ -1132,19 +1504,10 @@ bool Cgraphics::renderSurface( SDL_Surface *surface, int x1, int y1)
 bool Cgraphics::renderSurface( SDL_Surface *surface, int x, int y, int w, int h)
 {
 #ifdef USE_SDL2
-	SDL_Texture *texture =SDL_CreateTextureFromSurface( m_renderer, surface);
-	if ( texture)
-	{
-		SDL_Rect rect;
-		rect.h =h;
-		rect.w =w;
-		rect.x=(Sint16)(x+m_pixelOffset.x);
-		rect.y=(Sint16)(y+m_pixelOffset.y);
-		SDL_RenderCopy( m_renderer, texture, NULL, &rect);
-		SDL_DestroyTexture( texture);
-		return true;
-	}
-	return false;
+	int handle =m_pool.upload( surface);
+	bool retVal =renderHandle( handle, x+m_pixelOffset.x, y+m_pixelOffset.y, w, h);
+	m_pool.release( handle);
+	return retVal;
 #else
 	if ( surface ==NULL)
 	{
@@ -1160,6 +1523,121 @@ bool Cgraphics::renderSurface( SDL_Surface *surface, int x, int y, int w, int h)
 	return true;
 }
 
+/** @brief Copy a part of a texture, e.g. one tile out of an atlas.
+ *  @param texture [in] Texture or surface to copy from.
+ *  @param source [in] Area inside the texture.
+ *  @param destination [in] Where to paint it on the render area.
+ *  @return true on success.
+ */
+bool Cgraphics::renderPart( sdlTexture *texture, const SDL_Rect &source, const SDL_Rect &destination)
+{
+	if ( texture ==NULL)
+	{
+		return false;
+	}
+	SDL_Rect src =source;
+	SDL_Rect dst =destination;
+#ifdef USE_SDL2
+	SDL_RenderCopy( m_renderer, texture, &src, &dst);
+#else
+	SDL_BlitSurface( texture, &src, m_renderSurface, &dst);
+#endif
+	return true;
+}
+
+#ifdef USE_SDL2
+/** @brief Copy the painted screen to memory, works for every backend.
+ *  @return New ARGB8888 surface, free it with SDL_FreeSurface. NULL on failure.
+ */
+SDL_Surface *Cgraphics::readPixels()
+{
+	if ( m_renderer ==NULL || m_texture ==NULL)
+	{
+		return NULL;
+	}
+	SDL_Surface *surface =SDL_CreateRGBSurfaceWithFormat( 0, m_size.width(), m_size.height(),
+	                                                      32, SDL_PIXELFORMAT_ARGB8888);
+	if ( surface ==NULL)
+	{
+		return NULL;
+	}
+	SDL_Texture *target =SDL_GetRenderTarget( m_renderer);
+	SDL_SetRenderTarget( m_renderer, m_texture);
+	int result =SDL_RenderReadPixels( m_renderer, NULL, SDL_PIXELFORMAT_ARGB8888,
+	                                  surface->pixels, surface->pitch);
+	SDL_SetRenderTarget( m_renderer, target);
+	if ( result !=0)
+	{
+		SDL_FreeSurface( surface);
+		return NULL;
+	}
+	return surface;
+}
+
+/** @brief Save the painted screen.
+ *  @param fname [in] PNG file to write.
+ *  @return true on success.
+ */
+bool Cgraphics::savePng( const std::string &fname)
+{
+	SDL_Surface *surface =readPixels();
+	if ( surface ==NULL)
+	{
+		return false;
+	}
+	bool retVal =( IMG_SavePNG( surface, fname.c_str()) ==0);
+	SDL_FreeSurface( surface);
+	return retVal;
+}
+
+/** @brief Compare the painted screen byte by byte with a saved one.
+ *  @param fname [in] PNG file written by savePng.
+ *  @return Number of different pixels, -1 when the file is missing or has another size.
+ */
+int Cgraphics::compareGolden( const std::string &fname)
+{
+	SDL_Surface *loaded =IMG_Load( fname.c_str());
+	if ( loaded ==NULL)
+	{
+		return -1;
+	}
+	SDL_Surface *golden =SDL_ConvertSurfaceFormat( loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+	SDL_FreeSurface( loaded);
+	SDL_Surface *screen =readPixels();
+	int differences =-1;
+	if (   golden && screen
+		&& golden->w ==screen->w && golden->h ==screen->h)
+	{
+		differences =0;
+		for ( int y=0; y<screen->h; y++)
+		{
+			const Uint32 *a =(const Uint32*)((const Uint8*)screen->pixels+y*screen->pitch);
+			const Uint32 *b =(const Uint32*)((const Uint8*)golden->pixels+y*golden->pitch);
+			if ( memcmp( a, b, screen->w*sizeof(Uint32)) ==0)
+			{
+				continue;
+			}
+			for ( int x=0; x<screen->w; x++)
+			{
+				if ( a[x] !=b[x])
+				{
+					differences++;
+				}
+			}
+		}
+	}
+	if ( golden)
+	{
+		SDL_FreeSurface( golden);
+	}
+	if ( screen)
+	{
+		SDL_FreeSurface( screen);
+	}
+	return differences;
+}
+#endif
+
 void Cgraphics::settings( Sdefaults *settings)
 {
 	m_defaults.width =settings->width;	// in pixels.
@@ -1237,6 +1715,15 @@ void Cgraphics::settings( Sdefaults *settings)
 	m_defaults.touch_debounce_time =settings->touch_debounce_time;
 	m_defaults.touch_debounce_distance =settings->touch_debounce_distance;
 	m_defaults.debug_coordinates =settings->debug_coordinates;
+	m_defaults.text_cache_size =settings->text_cache_size;
+	m_defaults.image_cache_size =settings->image_cache_size;
+	m_defaults.image_decode_threads =settings->image_decode_threads;
+	m_defaults.damage_tracking =settings->damage_tracking;
+	m_defaults.maximum_idle_time =settings->maximum_idle_time;
+	m_defaults.raster_fill =settings->raster_fill;
+	m_defaults.look_cache_size =settings->look_cache_size;
+	m_defaults.font_manifest =settings->font_manifest;
+	m_defaults.debug_profiler =settings->debug_profiler;
 
 	// functions
 	m_defaults.get_translation =settings->get_translation;
@@ -1413,33 +1900,25 @@ void Cgraphics::setViewport( SDL_Rect *rect)
 void Cgraphics::darken( int x1, int y1, int x2, int y2)
 {
 #ifdef USE_SDL2
-	SDL_Texture *texture =SDL_CreateTexture( m_renderer,
-                                   SDL_PIXELFORMAT_ARGB8888,
-                                   SDL_TEXTUREACCESS_TARGET,
-                                   1, 1);
-	if ( !texture)
+	if ( x2==0 && y2==0)
 	{
 		x2 =Cgraphics::m_defaults.width;
 		y2 =Cgraphics::m_defaults.height;
 	}
-	assert(0);
-//	if ( this!=m_mainGraph)
-//	{
-//		m_mainGraph->darken( x1,y1,x2,y2);
-//		return;
-//	}
-	SDL_SetRenderTarget( m_renderer, texture);
-	SDL_SetRenderDrawColor( m_renderer, 0x10, 0x10, 0x10, 0x30);
-	SDL_RenderDrawPoint( m_renderer, 0,0);
-	//SDL_SetTextureAlphaMod( texture, 0x80);
-	SDL_SetRenderTarget( m_renderer, m_texture);
+	Uint8 r,g,b,a;
+	SDL_BlendMode mode;
+	SDL_GetRenderDrawColor( m_renderer, &r, &g, &b, &a);
+	SDL_GetRenderDrawBlendMode( m_renderer, &mode);
 	SDL_Rect rect;
 	rect.x =x1;
 	rect.y =y1;
 	rect.w =x2-x1;
 	rect.h =y2-y1;
-	SDL_RenderCopy( m_renderer, texture, NULL, &rect);
-	SDL_DestroyTexture( texture);
+	SDL_SetRenderDrawBlendMode( m_renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor( m_renderer, 0x10, 0x10, 0x10, 0x30);
+	SDL_RenderFillRect( m_renderer, &rect);
+	SDL_SetRenderDrawColor( m_renderer, r, g, b, a);
+	SDL_SetRenderDrawBlendMode( m_renderer, mode);
 #else
 	if ( x2==0 && y2==0)
 	{
@@ -1464,7 +1943,24 @@ void Cgraphics::darken( int x1, int y1, int x2, int y2)
 bool Cgraphics::push_back()
 {
 #ifdef USE_SDL2
-	assert(0);
+	if ( m_renderer ==NULL || m_texture ==NULL)
+	{
+		return false;
+	}
+	SDL_Texture *layer =SDL_CreateTexture( m_renderer, SDL_PIXELFORMAT_ARGB8888,
+	                                       SDL_TEXTUREACCESS_TARGET,
+	                                       m_size.width(), m_size.height());
+	if ( !layer)
+	{
+		return false;
+	}
+	// Copy the pixels as they are, not blended with the old layer content.
+	SDL_SetTextureBlendMode( m_texture, SDL_BLENDMODE_NONE);
+	SDL_SetRenderTarget( m_renderer, layer);
+	SDL_RenderCopy( m_renderer, m_texture, NULL, NULL);
+	SDL_SetRenderTarget( m_renderer, m_texture);
+	SDL_SetTextureBlendMode( m_texture, SDL_BLENDMODE_BLEND);
+	m_layers.push_back( layer);
 #else
 	Uint32 *background =new Uint32[ m_size.area()];
 	if (!background)
@@ -1480,12 +1976,18 @@ bool Cgraphics::push_back()
 	return true;
 }
 
-/** @brief Pop a graphic plane from stack (not used now).
+/** @brief Pop a graphic plane from stack and show it again.
  */
 bool Cgraphics::pop_back()
 {
 #ifdef USE_SDL2
-	assert(0);
+	if ( !front())
+	{
+		return false;
+	}
+	SDL_DestroyTexture( m_layers.back());
+	m_layers.pop_back();
+	update();
 #else
 	if ( m_background.empty() )
 	{
@@ -1507,11 +2009,20 @@ bool Cgraphics::pop_back()
 	return true;
 }
 
-/// @brief Get front screen without remove it from stack.
+/** @brief Copy the top of the stack back, without removing it.
+ *  The screen is not updated, paint on top first.
+ */
 bool Cgraphics::front()
 {
 #ifdef USE_SDL2
-	assert(0);
+	if ( m_layers.empty())
+	{
+		return false;
+	}
+	SDL_Texture *layer =m_layers.back();
+	SDL_SetTextureBlendMode( layer, SDL_BLENDMODE_NONE);
+	SDL_SetRenderTarget( m_renderer, m_texture);
+	SDL_RenderCopy( m_renderer, layer, NULL, NULL);
 #else
 	if ( m_background.empty() )
 	{
@@ -1526,7 +2037,6 @@ bool Cgraphics::front()
  	Uint32 *pixels =(Uint32 *) m_renderSurface->pixels;
  	memcpy( pixels, background, m_size.area()*sizeof(Uint32));
 	unlock();
-	update();
 #endif
 	return true;
 }
@@ -1634,9 +2144,17 @@ void Cgraphics::line(int x1, int y1, int x2, int y2)
  *  @param y2 [in] Bottom position.
  */
 void Cgraphics::imageLine( const std::string &image, int x1, int y1, int x2, int y2)
+{
+	imageLine( findImageId( image), x1, y1, x2, y2);
+}
+
+/** @brief Paint part of an image at the same position.
+ *  @param id [in] Identifier of the image.
+ */
+void Cgraphics::imageLine( imageId id, int x1, int y1, int x2, int y2)
 {
 #ifdef USE_SDL2
-	sdlTexture *bitmap =findImage( image);
+	sdlTexture *bitmap =findImage( id);
 	if ( bitmap ==NULL || m_renderer ==NULL)
 	{
 		return;
@@ -1654,7 +2172,7 @@ void Cgraphics::imageLine( const std::string &image, int x1, int y1, int x2, int
 	src.h = (Uint16)(y2 - y1);
 	SDL_RenderCopy( m_renderer, bitmap, &src, &dst);
 #else
-	SDL_Surface *bitmap =findImage( image);
+	SDL_Surface *bitmap =findImage( id);
 	if ( bitmap ==NULL || m_renderSurface ==NULL)
 	{
 		return;
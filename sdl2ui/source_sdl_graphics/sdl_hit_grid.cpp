@@ -0,0 +1,279 @@
+/*============================================================================*/
+/**  @file       sdl_hit_grid.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Find the object or key under a touch position.
+ **
+ **  Objects are kept in the cells they overlap and moved when their
+ **  rectangle changes, so a search never walks all objects.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              ChitGrid
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include "sdl_hit_grid.h"
+#include "sdl_dialog_object.h"
+
+/** @brief Constructor, empty grid. */
+ChitGrid::ChitGrid()
+: m_columns(0)
+, m_rows(0)
+, m_order(0)
+{
+}
+
+/** @brief Destructor. */
+ChitGrid::~ChitGrid()
+{
+	clear();
+}
+
+/** @brief Set the area to divide.
+ *  @param size [in] Screen size in touch squares.
+ */
+void ChitGrid::setSize( const Csize &size)
+{
+	m_lock.lock();
+	m_columns =(size.width()+HIT_GRID_CELL-1)/HIT_GRID_CELL;
+	m_rows =(size.height()+HIT_GRID_CELL-1)/HIT_GRID_CELL;
+	m_cells.clear();
+	m_cells.resize( m_columns*m_rows);
+	for ( std::map<CdialogObject*, ShitEntry*>::iterator it =m_entries.begin(); it !=m_entries.end(); ++it)
+	{
+		insertCells( it->second);
+	}
+	m_lock.unlock();
+}
+
+/** @brief Add an object on top of all others.
+ *  @param object [in] Object to add.
+ */
+void ChitGrid::add( CdialogObject *object)
+{
+	m_lock.lock();
+	if ( m_entries.find( object) ==m_entries.end())
+	{
+		ShitEntry *entry =new ShitEntry( object, object->m_rect, m_order++);
+		m_entries[object] =entry;
+		insertCells( entry);
+	}
+	m_lock.unlock();
+}
+
+/** @brief Remove an object.
+ *  @param object [in] Object to remove.
+ */
+void ChitGrid::remove( CdialogObject *object)
+{
+	m_lock.lock();
+	std::map<CdialogObject*, ShitEntry*>::iterator it =m_entries.find( object);
+	if ( it !=m_entries.end())
+	{
+		removeCells( it->second);
+		delete it->second;
+		m_entries.erase( it);
+	}
+	m_lock.unlock();
+}
+
+/** @brief Move an object to other cells when the rectangle changed.
+ *  @param object [in] Object to check.
+ */
+void ChitGrid::update( CdialogObject *object)
+{
+	m_lock.lock();
+	std::map<CdialogObject*, ShitEntry*>::iterator it =m_entries.find( object);
+	if ( it !=m_entries.end())
+	{
+		ShitEntry *entry =it->second;
+		const Crect &rect =object->m_rect;
+		if (   rect.left() !=entry->rect.left() || rect.top() !=entry->rect.top()
+			|| rect.width() !=entry->rect.width() || rect.height() !=entry->rect.height())
+		{
+			removeCells( entry);
+			entry->rect =rect;
+			insertCells( entry);
+		}
+	}
+	m_lock.unlock();
+}
+
+/** @brief Object painted and takes the key codes of its rectangle.
+ *  @param object [in] Object painted.
+ *  @return false when the object is not in the grid.
+ */
+bool ChitGrid::setKeyed( CdialogObject *object)
+{
+	bool found =false;
+	m_lock.lock();
+	std::map<CdialogObject*, ShitEntry*>::iterator it =m_entries.find( object);
+	if ( it !=m_entries.end())
+	{
+		it->second->keyed =true;
+		found =true;
+	}
+	m_lock.unlock();
+	return found;
+}
+
+/** @brief Find the visible object on top.
+ *  @param p [in] Position in touch squares.
+ *  @return Object or NULL.
+ */
+CdialogObject *ChitGrid::findObject( const Cpoint &p)
+{
+	m_lock.lock();
+	ShitEntry *entry =topMost( p, false);
+	CdialogObject *object =entry ? entry->object:NULL;
+	m_lock.unlock();
+	return object;
+}
+
+/** @brief Find the key code of the visible object on top.
+ *  @param p [in] Position in touch squares.
+ *  @param key [out] Key code found.
+ *  @return false when no object has a key here.
+ */
+bool ChitGrid::findKey( const Cpoint &p, keybutton &key)
+{
+	m_lock.lock();
+	ShitEntry *entry =topMost( p, true);
+	if ( entry)
+	{
+		key =entry->object->m_code;
+	}
+	m_lock.unlock();
+	return entry !=NULL;
+}
+
+/** @brief Remove all objects. */
+void ChitGrid::clear()
+{
+	m_lock.lock();
+	for ( std::map<CdialogObject*, ShitEntry*>::iterator it =m_entries.begin(); it !=m_entries.end(); ++it)
+	{
+		delete it->second;
+	}
+	m_entries.clear();
+	for ( size_t a=0; a<m_cells.size(); a++)
+	{
+		m_cells[a].clear();
+	}
+	m_order =0;
+	m_lock.unlock();
+}
+
+/** @brief Which cells does a rectangle touch?
+ *  @param rect [in] Rectangle in touch squares.
+ *  @return false when outside the grid.
+ */
+bool ChitGrid::cellRange( const Crect &rect, int &c1, int &r1, int &c2, int &r2)
+{
+	if ( rect.width()<=0 || rect.height()<=0 || rect.right()<=0 || rect.bottom()<=0)
+	{
+		return false;
+	}
+	c1 =gMax( rect.left(), 0)/HIT_GRID_CELL;
+	r1 =gMax( rect.top(), 0)/HIT_GRID_CELL;
+	c2 =gMin( (rect.right()-1)/HIT_GRID_CELL, m_columns-1);
+	r2 =gMin( (rect.bottom()-1)/HIT_GRID_CELL, m_rows-1);
+	return c1<=c2 && r1<=r2;
+}
+
+/** @brief Put an object in all cells it overlaps.
+ *  @param entry [in] Object to add.
+ */
+void ChitGrid::insertCells( ShitEntry *entry)
+{
+	int c1,r1,c2,r2;
+	if ( !cellRange( entry->rect, c1,r1,c2,r2))
+	{
+		return;
+	}
+	for ( int row=r1; row<=r2; row++)
+	{
+		for ( int column=c1; column<=c2; column++)
+		{
+			m_cells[row*m_columns+column].push_back( entry);
+		}
+	}
+}
+
+/** @brief Remove an object from all cells it overlaps.
+ *  @param entry [in] Object to remove.
+ */
+void ChitGrid::removeCells( ShitEntry *entry)
+{
+	int c1,r1,c2,r2;
+	if ( !cellRange( entry->rect, c1,r1,c2,r2))
+	{
+		return;
+	}
+	for ( int row=r1; row<=r2; row++)
+	{
+		for ( int column=c1; column<=c2; column++)
+		{
+			std::vector<ShitEntry*> &cell =m_cells[row*m_columns+column];
+			for ( size_t a=0; a<cell.size(); a++)
+			{
+				if ( cell[a] ==entry)
+				{
+					cell.erase( cell.begin()+a);
+					break;
+				}
+			}
+		}
+	}
+}
+
+/** @brief Find the top object at a position, call locked.
+ *  @param p [in] Position in touch squares.
+ *  @param keyed [in] Only objects that paint a key code.
+ *  @return Entry or NULL.
+ */
+ShitEntry *ChitGrid::topMost( const Cpoint &p, bool keyed)
+{
+	if ( p.x<0 || p.y<0 || p.x>=m_columns*HIT_GRID_CELL || p.y>=m_rows*HIT_GRID_CELL)
+	{
+		return NULL;
+	}
+	std::vector<ShitEntry*> &cell =m_cells[(p.y/HIT_GRID_CELL)*m_columns+p.x/HIT_GRID_CELL];
+	ShitEntry *found =NULL;
+	for ( size_t a=0; a<cell.size(); a++)
+	{
+		ShitEntry *entry =cell[a];
+		if (   (found ==NULL || entry->order>found->order)
+			&& entry->object->m_visible && entry->rect.inside( p)
+			&& (!keyed || (entry->keyed && entry->object->m_code !=KEY_NOCHANGE)))
+		{
+			found =entry;
+		}
+	}
+	return found;
+}
@@ -56,6 +56,7 @@ Cimage::Cimage( Cdialog *parent, const Crect &rect, keybutton code,
 		        const std::string &icon, EborderType border, int margin, const std::string &label)
 : CdialogObject( parent, rect, code)
 , m_imageAlign( GRAVITY_LEFT)
+, m_imageId( INVALID_IMAGE_ID)
 , m_parent(NULL)
 , m_noBackground(false)
 , m_border(border)
@@ -98,6 +99,7 @@ Cimage::Cimage( Cdialog *parent, const Crect &rect, keybutton code,
 		m_image.insert( pos, s);
 	}
 	m_path =Cgraphics::m_defaults.image_path;
+	m_imageId =m_graphics->acquireImage( m_image);
 }
 
 /*============================================================================*/
@@ -108,6 +110,7 @@ Cimage::Cimage( Cdialog *parent, const Crect &rect, keybutton code,
 Cimage::~Cimage()
 {
 	close();
+	m_graphics->releaseImage( m_imageId);
 }
 
 void Cimage::setLabel( const std::string &label)
@@ -294,9 +297,15 @@ void Cimage::paintImage( int touch)
 	y2 -=m_margin;
 	Csize sz(0,0);
 
-	sdlTexture *bitmap = m_surface ? m_surface:m_graphics->findImage( m_image);
+	sdlTexture *bitmap = m_surface ? m_surface:m_graphics->findImage( m_imageId);
 	if ( bitmap == NULL)
 	{
+		if ( m_surface ==NULL && m_graphics->isDecoding( m_imageId))
+		{
+			// Placeholder until the decoder thread is ready.
+			m_graphics->setColour( Cgraphics::m_defaults.line_bright);
+			m_graphics->bar( x1, y1, x2, y2, 4);
+		}
 		return;
 	}
 	switch ( m_imageAlign)
@@ -412,7 +421,7 @@ void Cimage::onPaint( int touch)
 	// Draw label
 	m_label.onPaint( touch);
 	// Set mouse touch.
-	m_graphics->setCode( m_rect, m_code);
+	setTouchKey();
 }
 
 /*============================================================================*/
@@ -448,6 +457,10 @@ void Cimage::setImage( const std::string &image, Egravity horizontal, int variab
 		m_image.erase( pos, 1);
 		m_image.insert( pos, s);
 	}
+	imageId id =m_graphics->acquireImage( m_image);
+	m_graphics->releaseImage( m_imageId);
+	m_imageId =id;
+	invalidate();
 }
 
 
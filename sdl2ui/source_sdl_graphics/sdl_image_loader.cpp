@@ -0,0 +1,257 @@
+/*============================================================================*/
+/**  @file       sdl_image_loader.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Decode images in the background.
+ **
+ **  Worker threads load image files into surfaces.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CimageLoader, CimageDecoder
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include <sys/time.h>
+#include <errno.h>
+#include "sdl_image_loader.h"
+#include "sdl_graphics.h"
+#include "sdl_dialog_event.h"
+
+int CimageLoader::m_lastOwner =0;
+
+/** @brief Constructor worker.
+ *  @param loader [in] Queue to take the jobs from.
+ */
+CimageDecoder::CimageDecoder( CimageLoader *loader)
+: m_loader( loader)
+{
+}
+
+/** @brief Destructor worker. */
+CimageDecoder::~CimageDecoder()
+{
+	stop();
+}
+
+/** @brief Decode one image, or wait a while for a job. */
+void CimageDecoder::work()
+{
+	SimageJob job;
+	if ( m_loader->next( job, 100))
+	{
+		job.surface =IMG_Load( job.path.c_str());
+		m_loader->finished( job);
+	}
+}
+
+/** @brief Constructor, threads are started at the first request. */
+CimageLoader::CimageLoader()
+{
+	pthread_mutex_init( &m_mutex, NULL);
+	pthread_cond_init( &m_wakeup, NULL);
+}
+
+/** @brief Destructor, stop all threads and free unused results. */
+CimageLoader::~CimageLoader()
+{
+	for ( int a=0; a<(int)m_decoders.size(); a++)
+	{
+		m_decoders[a]->stop();
+		delete m_decoders[a];
+	}
+	m_decoders.clear();
+	for ( int a=0; a<(int)m_done.size(); a++)
+	{
+		if ( m_done[a].surface)
+		{
+			SDL_FreeSurface( m_done[a].surface);
+		}
+	}
+	m_done.clear();
+	m_jobs.clear();
+	pthread_cond_destroy( &m_wakeup);
+	pthread_mutex_destroy( &m_mutex);
+}
+
+/** @brief Get a unique number for a graphics layer.
+ *  @return Number, never used before.
+ */
+int CimageLoader::newOwner()
+{
+	return __sync_add_and_fetch( &m_lastOwner, 1);
+}
+
+/** @brief Start the decoders when not running yet. Mutex is locked. */
+void CimageLoader::startThreads()
+{
+	int threads =Cgraphics::m_defaults.image_decode_threads;
+	while ( (int)m_decoders.size()<threads)
+	{
+		CimageDecoder *decoder =new CimageDecoder( this);
+		m_decoders.push_back( decoder);
+		decoder->start();
+	}
+}
+
+/** @brief Ask to decode an image.
+ *  @param owner [in] Result of newOwner().
+ *  @param id [in] Identifier for the owner.
+ *  @param path [in] Full file name.
+ */
+void CimageLoader::request( int owner, int id, const std::string &path)
+{
+	SimageJob job;
+	job.owner =owner;
+	job.id =id;
+	job.path =path;
+	job.surface =NULL;
+	pthread_mutex_lock( &m_mutex);
+	startThreads();
+	m_owners.insert( owner);
+	m_jobs.push_back( job);
+	pthread_cond_signal( &m_wakeup);
+	pthread_mutex_unlock( &m_mutex);
+}
+
+/** @brief Take the next job, called by a decoder.
+ *  @param job [out] What to decode.
+ *  @param timeout [in] Milliseconds to wait for a job.
+ *  @return true when a job is found.
+ */
+bool CimageLoader::next( SimageJob &job, int timeout)
+{
+	pthread_mutex_lock( &m_mutex);
+	if ( m_jobs.empty())
+	{
+		struct timeval now;
+		struct timespec until;
+		gettimeofday( &now, NULL);
+		long usec =now.tv_usec+timeout*1000L;
+		until.tv_sec =now.tv_sec+usec/1000000L;
+		until.tv_nsec =(usec%1000000L)*1000L;
+		pthread_cond_timedwait( &m_wakeup, &m_mutex, &until);
+	}
+	if ( m_jobs.empty())
+	{
+		pthread_mutex_unlock( &m_mutex);
+		return false;
+	}
+	job =m_jobs.front();
+	m_jobs.pop_front();
+	pthread_mutex_unlock( &m_mutex);
+	return true;
+}
+
+/** @brief Decoder is ready with a job.
+ *  @param job [in] Job with surface.
+ */
+void CimageLoader::finished( SimageJob &job)
+{
+	bool wake =false;
+	pthread_mutex_lock( &m_mutex);
+	if ( m_owners.find( job.owner) ==m_owners.end())
+	{
+		// Graphics is gone.
+		if ( job.surface)
+		{
+			SDL_FreeSurface( job.surface);
+		}
+	}
+	else
+	{
+		m_done.push_back( job);
+		wake =true;
+	}
+	pthread_mutex_unlock( &m_mutex);
+	if ( wake)
+	{
+		// The main loop may sleep until the next input, the image is ready now.
+		CdialogEvent::Instance()->wakeUp();
+	}
+}
+
+/** @brief Get all finished images for one graphics.
+ *  @param owner [in] Result of newOwner().
+ *  @param done [out] Finished jobs, the surfaces are for the caller.
+ *  @return true when any image is finished.
+ */
+bool CimageLoader::collect( int owner, std::vector<SimageJob> &done)
+{
+	done.clear();
+	pthread_mutex_lock( &m_mutex);
+	for ( int a=0; a<(int)m_done.size(); )
+	{
+		if ( m_done[a].owner ==owner)
+		{
+			done.push_back( m_done[a]);
+			m_done.erase( m_done.begin()+a);
+		}
+		else
+		{
+			a++;
+		}
+	}
+	pthread_mutex_unlock( &m_mutex);
+	return !done.empty();
+}
+
+/** @brief Forget all jobs of a graphics.
+ *  @param owner [in] Result of newOwner().
+ */
+void CimageLoader::cancel( int owner)
+{
+	pthread_mutex_lock( &m_mutex);
+	m_owners.erase( owner);
+	for ( int a=0; a<(int)m_jobs.size(); )
+	{
+		if ( m_jobs[a].owner ==owner)
+		{
+			m_jobs.erase( m_jobs.begin()+a);
+		}
+		else
+		{
+			a++;
+		}
+	}
+	for ( int a=0; a<(int)m_done.size(); )
+	{
+		if ( m_done[a].owner ==owner)
+		{
+			if ( m_done[a].surface)
+			{
+				SDL_FreeSurface( m_done[a].surface);
+			}
+			m_done.erase( m_done.begin()+a);
+		}
+		else
+		{
+			a++;
+		}
+	}
+	pthread_mutex_unlock( &m_mutex);
+}
@@ -85,6 +85,7 @@ void CinfoButton::onPaint( int touch)
 void CinfoButton::setText( const std::string &text)
 {
 	m_data.setText( text);
+	invalidate();
 }
 
 std::string CinfoButton::getText()
@@ -104,6 +105,7 @@ void CinfoButton::setDataColours( colour infoText,
 			            colour background1, colour background2)
 {
 	m_data.setColours( infoText, background1, background2);
+	invalidate();
 }
 
 void CinfoButton::setTitleWidth( int width)
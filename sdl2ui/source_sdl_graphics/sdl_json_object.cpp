@@ -39,8 +39,33 @@
 
 /*------------- Standard includes --------------------------------------------*/
 #include <ctype.h>
+#include <stdio.h>
 #include <string>
 #include "sdl_json_object.h"
+#include "sdl_background.h"
+#include "sdl_text.h"
+
+/** @brief Read an entire text file.
+ *  @param fname [in] File to read.
+ *  @param text [out] Contents.
+ *  @return false when the file cannot be opened.
+ */
+static bool readText( const std::string &fname, std::string &text)
+{
+	FILE *f =fopen( fname.c_str(), "rb");
+	if ( f ==NULL)
+	{
+		return false;
+	}
+	char buffer[4096];
+	size_t length;
+	while ( (length =fread( buffer, 1, sizeof(buffer), f)) >0)
+	{
+		text.append( buffer, length);
+	}
+	fclose( f);
+	return true;
+}
 
 /** @brief constructor. CdialogObject just for the paint function.
  *  @param parent [in] Dialog to use this object
@@ -56,30 +81,8 @@
  */
 CjsonObject::CjsonObject( Cdialog *parent, const std::string &description)
 : CdialogObject( parent, Crect(0,0,0,0), KEY_NONE)
-, m_reader( m_features)
 , m_index(0)
-, m_lastName("search48.png")
-, m_lastCode(KEY_NONE)
-, m_lastRect(0,0,6,6)
-, m_buttonBorder( BORDER_THIN)
-, m_lastBorder(BORDER_NONE)
-, m_lastGravity(GRAVITY_CENTER)
-, m_buttonGravity(GRAVITY_CENTER)
-, m_imageGravity(GRAVITY_CENTER)
-, m_lastMargin(0)
-, m_lastLabel("")
-, m_lastType("image")
-, m_lastColour1(0)
-, m_lastColour2(0)
-, m_lastRadius(0)
-, m_lastFill( FILL_GRADIENT)
-, m_lastButtonFill( FILL_GRADIENT)
-, m_lastBorderWidth( 0)
-, m_lastBackgroundRadius( 0)
-, m_lastBackgroundBorderWidth( 2)
-, m_lastButtonRadius( 4)
 {
-	m_lastFont =CtextFont("calculator");
 	add( description);
 }
 
@@ -89,594 +92,181 @@ CjsonObject::CjsonObject( Cdialog *parent, const std::string &description)
  */
 void CjsonObject::add( const std::string &description)
 {
-	bool parsingSuccessful = m_reader.parse( description, m_root);
-	if ( !parsingSuccessful )
+	if ( m_compiler.compile( description) ==false)
 	{
-		// "Failed to parse %s", m_reader.getFormatedErrorMessages().c_str() );
 		return;
-    }
-	if ( m_root.isArray())
-	{
-		for ( int n=0; n<(int)m_root.size(); n++)
-		{
-			decode( m_parent, m_root[n]);
-		}
 	}
-	else
+	for ( int n=0; n<m_compiler.size(); n++)
 	{
-		decode( m_parent, m_root);
+		create( m_compiler.record( n), m_compiler.strings());
 	}
 }
 
-/** @brief Decode the object
- *  @param parent [in] Dialog to use it
- *  @param value [out] Initial value
+/** @brief Add objects from a layout file.
+ *  The compiled layout is used when it is not older than the JSON file,
+ *  otherwise the JSON file is parsed. Both start with default values.
+ *  @param fname [in] JSON file, the compiled one has LAYOUT_EXTENSION added.
+ *  @return false when neither can be read.
  */
-void CjsonObject::decode( Cdialog *parent, const Json::Value &value)
+bool CjsonObject::load( const std::string &fname)
 {
-	Json::Value v=value["type"];
-	if ( v.isString())
-	{
-		m_lastType =v.asString();
-	}
-	if ( m_lastType.compare("image")==0)
-	{
-		decodeImage( parent, value);
-	}
-	else if ( m_lastType.compare("button")==0)
-	{
-		decodeButton( parent, value);
-	}
-	else if ( m_lastType.compare("bottombutton")==0)
-	{
-		decodeBottomButton( parent, value);
-	}
-	else if ( m_lastType.compare("calculatorbutton")==0)
-	{
-		decodeCalculatorButton( value);
-	}
-	else if ( m_lastType.compare("header")==0)
-	{
-		decodeHeaderButton( value);
-	}
-	else if ( m_lastType.compare("headerbutton")==0)
-	{
-		decodeHeaderButton( value);
-	}
-	else if ( m_lastType.compare("background")==0)
-	{
-		decodeBackground( parent, value);
-	}
-	else if ( m_lastType.compare("text")==0)
+	std::string compiled =ClayoutCompiler::compiledName( fname);
+	ClayoutFile layout;
+	if ( ClayoutFile::isUpToDate( compiled, fname) && layout.open( compiled))
 	{
-		decodeText( parent, value);
-	}
-	//else "CjsonObject::CjsonObject Wrong type!!");
-}
-
-void CjsonObject::decodeImage( Cdialog *parent, const Json::Value &root)
-{
-	Crect rect =decodeRect( root);
-	keybutton code =decodeKeybutton( root);
-	std::string icon =decodeIcon( root);
-	EborderType border =decodeBorder( root, m_lastBorder);
-	int margin =decodeMargin( root);
-	m_lastLabel ="";
-	std::string label =decodeLabel( root);
-	Cimage *img =new Cimage( parent, rect, code, icon, border, margin, label);
-	Json::Value v=root["gravity"];
-	if ( v.isString())
-	{
-		m_imageGravity =decodeGravity( root, m_imageGravity);
-	}
-	img->setGravity( m_imageGravity);
-	m_object.push_back( img);
-}
-
-int CjsonObject::decodeBorderWidth( const Json::Value &root, int &borderwidth)
-{
-	Json::Value v=root["border"];
-	if ( v.isInt())
-	{
-		borderwidth =v.asInt();
-	}
-	return borderwidth;
-}
-
-std::string CjsonObject::decodeIcon( const Json::Value &root)
-{
-	std::string icon ="";
-	Json::Value v=root["icon"];
-	if ( v.isString())
-	{
-		icon =v.asString();
-	}
-	else
-	{
-		v=root["image"];
-		if ( v.isString())
+		for ( int n=0; n<layout.size(); n++)
 		{
-			icon =v.asString();
+			create( layout.record( n), layout.strings());
 		}
+		return true;
 	}
-	return icon;
-}
-
-int CjsonObject::decodeMargin( const Json::Value &root)
-{
-	int margin =m_lastMargin;
-	Json::Value v=root["margin"];
-	if ( v.isIntegral())
+	std::string description;
+	ClayoutCompiler compiler;
+	if ( readText( fname, description) ==false || compiler.compile( description) ==false)
 	{
-		margin =v.asInt();
-		m_lastMargin =margin;
+		return false;
 	}
-	return m_lastMargin;
-}
-
-std::string CjsonObject::decodeLabel( const Json::Value &root)
-{
-	std::string label =m_lastLabel;
-	Json::Value v=root["label"];
-	if ( v.isString())
+	for ( int n=0; n<compiler.size(); n++)
 	{
-		label =v.asString();
-		m_lastLabel =label;
+		create( compiler.record( n), compiler.strings());
 	}
-	return m_lastLabel;
+	return true;
 }
 
-/** @brief Decode the button for the object
- *  @param root [in] What root
+/** @brief Compile a JSON layout file, e.g. at build time.
+ *  @param fname [in] JSON file.
+ *  @param output [in] Compiled file, empty for the name load() looks for.
+ *  @return true on success.
  */
-keybutton CjsonObject::decodeKeybutton( const Json::Value &root)
+bool CjsonObject::compile( const std::string &fname, const std::string &output)
 {
-	Json::Value v=root["code"];
-	if ( v.isString())
+	std::string description;
+	ClayoutCompiler compiler;
+	if ( readText( fname, description) ==false || compiler.compile( description) ==false)
 	{
-		m_lastCode =Ckeybutton(v.asString());
-	}
-	else
-	{
-		if ( m_lastCode !=KEY_NONE)
-		{
-			m_lastCode++;
-		}
+		return false;
 	}
-	return (keybutton)m_lastCode;
+	return compiler.save( output.empty() ? ClayoutCompiler::compiledName( fname):output);
 }
 
-Crect CjsonObject::decodeRect( const Json::Value &root)
+/** @brief Find the text id of a record, only when it has one.
+ *  @param record [in] Resolved object.
+ *  @param strings [in] String table.
+ *  @return Text id or INVALID_TEXT_ID.
+ */
+textId CjsonObject::findTextId( const SlayoutRecord &record, const char *strings)
 {
-	Json::Value v=root["rect"];
-	if ( v.isArray() && v.size()==4)
+	if ( (record.flags & LAYOUT_HAS_ID) ==0)
 	{
-		int left =v[(unsigned int)0].asInt();
-		int top =v[1].asInt();
-		int width =v[2].asInt();
-		int height =v[3].asInt();
-//		std::string _left =v[(unsigned int)0].asString();
-//		std::string _top =v[1].asString();
-//		std::string _width =v[2].asString();
-//		std::string _height =v[3].asString();
-//		if ( _left.find("%",0)!=std::string::npos)
-//		{
-//			left =Cgraphics::m_defaults.width*left/800;
-//		}
-
-		m_lastRect =Crect( left, top, width, height);
+		return INVALID_TEXT_ID;
 	}
-	else
-	{
-		m_lastRect.setLeft( m_lastRect.right());
-	}
-	return m_lastRect;
+	return Cgraphics::m_defaults.find_text_id( strings+record.id);
 }
 
-colour CjsonObject::decodeColour1( const Json::Value &root)
+/** @brief Create the object for one record.
+ *  @param record [in] Resolved object.
+ *  @param strings [in] String table of the record.
+ */
+void CjsonObject::create( const SlayoutRecord &record, const char *strings)
 {
-	Json::Value v=root["colour"];
-	if ( !v.isString())
-	{
-		v =root["colour1"];
-	}
-	if ( v.isString())
-	{
-		std::string s =v.asString();
-		if (s.size()>1 && toupper(s[1]) =='X')
-		{
-			m_lastColour1 =strtol(s.c_str()+2, NULL, 16);
-		}
-		else
-		{
-			m_lastColour1 =atoi( s.c_str());
-		}
-	}
-	return m_lastColour1;
-}
+	Crect rect( record.left, record.top, record.width, record.height);
+	keybutton code =(keybutton)record.code;
+	std::string text =strings+record.text;
+	textId id;
 
-colour CjsonObject::decodeColour2( const Json::Value &root)
-{
-	Json::Value v=root["colour2"];
-	if ( v.isString())
+	switch ( record.type)
 	{
-		std::string s =v.asString();
-		if (s.size()>1 && toupper(s[1]) =='X')
-		{
-			m_lastColour2 =strtol(s.c_str()+2, NULL, 16);
-		}
-		else
-		{
-			m_lastColour2 =atoi( s.c_str());
-		}
-	}
-
-	return m_lastColour2;
-}
-
-int CjsonObject::decodeRadius( const Json::Value &root, int &lastValue)
-{
-	Json::Value v=root["radius"];
-	if ( v.isInt())
+	case LAYOUT_IMAGE:
 	{
-		lastValue =v.asInt();
+		Cimage *img =new Cimage( m_parent, rect, code, strings+record.icon,
+				                 (EborderType)record.border, record.margin, strings+record.label);
+		img->setGravity( (Egravity)record.gravity);
+		m_object.push_back( img);
+		break;
 	}
-	return lastValue;
-}
-
-EfillType CjsonObject::decodeFillType( const Json::Value &root, EfillType &fill)
-{
-	Json::Value v=root["fill"];
-	if ( v.isString())
+	case LAYOUT_BUTTON:
 	{
-		std::string s=v.asString();
-		if ( s.compare("none")==0)
-		{
-			fill =FILL_NONE;
-		}
-		else if ( s.compare("solid")==0)
-		{
-			fill =FILL_UNICOLOURED;
-		}
-		else if ( s.compare("2colours")==0)
+		Sfont font =(Sfont)CtextFont( strings+record.font);
+		Cbutton *btn;
+		id =findTextId( record, strings);
+		if ( id !=INVALID_TEXT_ID && id>=0)
 		{
-			fill =FILL_2COLOURS;
+			btn =new Cbutton( m_parent, rect, code, font, id, (EborderType)record.border,
+					          (Egravity)record.gravity, record.radius, (EfillType)record.fill);
 		}
-		else if ( s.compare("gradient")==0)
-		{
-			fill =FILL_GRADIENT;
-		}
-		else if ( s.compare("pyramid")==0)
+		else
 		{
-			fill =FILL_PYRAMID;
+			btn =new Cbutton( m_parent, rect, code, font, text, (EborderType)record.border,
+					          (Egravity)record.gravity, record.radius, (EfillType)record.fill);
 		}
-		else if ( s.compare("image")==0)
+		if ( record.flags & LAYOUT_HAS_LABEL)
 		{
-			fill =FILL_IMAGE;
+			btn->setLabel( strings+record.label);
 		}
+		m_object.push_back( btn);
+		break;
 	}
-	return fill;
-}
-
-EborderType CjsonObject::decodeBorder( const Json::Value &root, EborderType &border)
-{
-	Json::Value v=root["border"];
-	if ( v.isString())
-	{
-		std::string  border =v.asString();
-		if ( v.compare( "none")==0)
-		{
-			border =BORDER_NONE;
-		}
-		else if ( v.compare( "thin"))
+	case LAYOUT_BOTTOM_BUTTON:
+		id =findTextId( record, strings);
+		if ( id !=INVALID_TEXT_ID && id>=0)
 		{
-			border =BORDER_THIN;
+			m_object.push_back( new CbottomButton( m_parent, rect, code, id, strings+record.icon));
 		}
-		else if ( v.compare( "thin_shadow"))
-		{
-			border =BORDER_THIN_SHADOW;
-		}
-		else if ( v.compare( "thin_selected"))
-		{
-			border =BORDER_THIN_SELECTED;
-		}
-		else if ( v.compare( "thin_button_shadow"))
-		{
-			border =BORDER_THIN_BUTTON_SHADOW;
-		}
-		else if ( v.compare( "thin"))
-		{
-			border =BORDER_THIN;
-		}
-		else if ( v.compare( "thin"))
-		{
-			border =BORDER_THIN;
-		}
-		else if ( v.compare( "thin"))
+		else
 		{
-			border =BORDER_THIN;
+			m_object.push_back( new CbottomButton( m_parent, rect, code, text, strings+record.icon));
 		}
-		else if ( v.compare( "thin"))
+		break;
+	case LAYOUT_CALCULATOR_BUTTON:
+		m_object.push_back( new CcalculatorButton( rect, text, code));
+		break;
+	case LAYOUT_HEADER_BUTTON:
+		id =findTextId( record, strings);
+		if ( id !=INVALID_TEXT_ID && id>=0)
 		{
-			border =BORDER_THIN;
+			m_object.push_back( new CheaderButton( rect, id, code));
 		}
-		else if ( v.compare( "thin"))
+		else
 		{
-			border =BORDER_THIN;
+			m_object.push_back( new CheaderButton( rect, text, code));
 		}
-	}
-	return border;
-}
-
-void CjsonObject::decodeText( Cdialog *parent, const Json::Value &root)
-{
-	Crect rect =decodeRect( root);
-	keybutton code =decodeKeybutton( root);
-	Json::Value v;
-	Sfont font =decodeFont( root, "button");
-
-	std::string fontName ="button";
-	v =root["font"];
-	if ( v.isString())
-	{
-		fontName =v.asString();
-	}
-
-	std::string txt;
-	v =root["text"];
-	if ( v.isString())
-	{
-		txt =v.asString();
-	}
-
-	colour colour;
-	v =root["text_colour"];
-	if ( v.isString())
+		break;
+	case LAYOUT_BACKGROUND:
 	{
-		std::string sc =v.asString();
-		colour =Cgraphics::m_defaults.find_colour(sc);
-	}
-	else
-	{
-		 colour =Cgraphics::m_defaults.item_text;
-	}
-	Egravity gravity =decodeGravity( root, m_buttonGravity);
-	int cursor =-1;
-	int cursorColour =0;
-	Ctext *txtObj =new Ctext( parent, rect, code, (Sfont)CtextFont(fontName.c_str()),
-			                  txt, colour, gravity, cursor, cursorColour);
-	m_object.push_back( txtObj);
-}
-
-/** @brief Find font in the string
- *  @param root [in] Where to look
- *  @param name [in] Default value
- *  @return Font definition
- */
-Sfont CjsonObject::decodeFont( const Json::Value &root, const std::string &name)
-{
-	std::string fontName =name;
-	Json::Value v =root["font"];
-	if ( v.isString())
-	{
-		fontName =v.asString();
-	}
-	return (Sfont)CtextFont( fontName.c_str());
-}
-
-/** @brief Find gravity in the string
- *  @param value [in] Where to look
- *  @param gravity [in] Default value
- *  @return Gravity found or default value
- */
-Egravity CjsonObject::decodeGravity( const Json::Value &value, Egravity &gravity)
-{
-	Json::Value v=value["gravity"];
-	if ( v.isString())
-	{
-		std::string s=v.asString();
-		if ( s.compare("left")==0)
-		{
-			gravity =GRAVITY_LEFT_CENTER;
-		}
-		else if ( s.compare("left_top")==0)
-		{
-			gravity =GRAVITY_LEFT;
-		}
-		else if ( s.compare("top_center")==0)
-		{
-			gravity =GRAVITY_TOP_CENTER;
-		}
-		else if ( s.compare("right_center")==0)
-		{
-			gravity =GRAVITY_RIGHT_CENTER;
-		}
-		else if ( s.compare("right_bottom")==0)
-		{
-			gravity =GRAVITY_RIGHT_BOTTOM;
-		}
-		else if ( s.compare("right_top")==0)
-		{
-			gravity =GRAVITY_RIGHT;
-		}
-		else if ( s.compare("center")==0)
+		Cbackground *back =new Cbackground( m_parent, rect, code, record.colour1, record.radius,
+				                            (EfillType)record.fill, record.colour2);
+		if ( record.fill ==FILL_IMAGE)
 		{
-			gravity =GRAVITY_CENTER;
+			back->setBackground( strings+record.icon);
 		}
-		else if ( s.compare("resize"))
+		if ( record.borderWidth !=0)
 		{
-			gravity =GRAVITY_RESIZE;
+			back->setBorderWidth( record.borderWidth);
 		}
-		// "CjsonObject::decodeGravity wrong %s!!", s.c_str());
+		m_object.push_back( back);
+		break;
 	}
-	return gravity;
-}
-
-void CjsonObject::decodeButton( Cdialog *parent, const Json::Value &root)
-{
-	Crect rect =decodeRect( root);
-	keybutton code =decodeKeybutton( root);
-
-	EborderType border =decodeBorder( root, m_buttonBorder); // default =BORDER_THIN
- 	Sfont font =decodeFont( root, "button");
-
-	Egravity gravity=decodeGravity( root, m_buttonGravity);
-	textId id=decodeTextId( root);
-
-	int radius =decodeRadius( root, m_lastButtonRadius); // default =6
-
-	EfillType fill =decodeFillType( root, m_lastButtonFill); // default =FILL_UNICOLOURED
-
-	Cbutton *btn;
-	if ( id !=INVALID_TEXT_ID && id>=0)
-	{
-		btn =new Cbutton( parent, rect, code, font, id, border, gravity, radius, fill);
-	}
-	else
+	case LAYOUT_TEXT:
 	{
-		std::string txt;
-		Json::Value v =root["text"];
-		if ( v.isString())
+		colour colour;
+		if ( record.flags & LAYOUT_HAS_TEXT_COLOUR)
 		{
-			txt =v.asString();
+			colour =Cgraphics::m_defaults.find_colour( strings+record.textColour);
 		}
-		btn =new Cbutton( parent, rect, code, font, txt, border, gravity, radius, fill);
-	}
-	Json::Value v =root["label"];
-	if ( v.isString())
-	{
-		std::string sc =v.asString();
-		btn->setLabel( sc);
-	}
-
-	m_object.push_back( btn);
-}
-
-/**
- *  @brief Decode a header button on top of the screen
- *  @param root [in] Text input
- */
-void CjsonObject::decodeHeaderButton( const Json::Value &root)
-{
-	Crect rect =decodeRect( root);
-	keybutton code =decodeKeybutton( root);
-
-	//Egravity gravity=decodeGravity( root, m_buttonGravity);
-	textId id=decodeTextId( root);
-
-	CheaderButton *btn;
-	if ( id !=INVALID_TEXT_ID && id>=0)
-	{
-		btn =new CheaderButton( rect, id, code);
-	}
-	else
-	{
-		std::string txt;
-		Json::Value v =root["text"];
-		if ( v.isString())
-		{
-			txt =v.asString();
-		}
-		btn =new CheaderButton( rect, txt, code);
-	}
-	m_object.push_back( btn);
-}
-
-void CjsonObject::decodeBottomButton( Cdialog *parent, const Json::Value &root)
-{
-	Crect rect =decodeRect( root);
-	keybutton code =decodeKeybutton( root);
-
-	CbottomButton *btn;
-	textId id=decodeTextId( root);
-	std::string icon =decodeIcon( root);
-
-	if ( id !=INVALID_TEXT_ID && id>=0)
-	{
-		btn =new CbottomButton( parent, rect, code, id, icon);
-	}
-	else
-	{
-		std::string txt;
-		Json::Value v =root["text"];
-		if ( v.isString())
+		else
 		{
-			txt =v.asString();
+			 colour =Cgraphics::m_defaults.item_text;
 		}
-		btn =new CbottomButton( parent, rect, code, txt, icon);
-	}
-	if ( btn !=NULL)
-	{
-		m_object.push_back( btn);
-	}
-}
-
-/** @brief Decode the background object
- *
- * @param  value
- * @return
- */
-textId CjsonObject::decodeTextId( const Json::Value &value)
-{
-	textId retVal =INVALID_TEXT_ID;
-	Json::Value v=value["id"];
-	if ( v.isString())
-	{
-		std::string s=v.asString();
-		retVal =Cgraphics::m_defaults.find_text_id(s); // findTextId( s);
-	}
-	return retVal;
-}
-
-/** @brief Decode the background object
- *
- *  @param root [in] Json object to decode
- */
-void CjsonObject::decodeCalculatorButton( const Json::Value &root)
-{
-	Crect rect =decodeRect( root);
-	keybutton code =decodeKeybutton( root);
-
-	CcalculatorButton *btn;
-	std::string txt;
-	Json::Value v =root["text"];
-	if ( v.isString())
-	{
-		txt =v.asString();
+		int cursor =-1;
+		int cursorColour =0;
+		Ctext *txtObj =new Ctext( m_parent, rect, code, (Sfont)CtextFont( strings+record.font),
+				                  text, colour, (Egravity)record.gravity, cursor, cursorColour);
+		m_object.push_back( txtObj);
+		break;
 	}
-
-	btn =new CcalculatorButton( rect, txt, code);
-	if ( btn !=NULL)
-	{
-		m_object.push_back( btn);
-	}
-}
-
-/** @brief Decode the background object
- *
- *  @param parent [in] What dialog
- *  @param root [in] Json object to decode
- */
-void CjsonObject::decodeBackground( Cdialog *parent, const Json::Value &root)
-{
-	Crect rect =decodeRect( root);
-	keybutton code =decodeKeybutton( root);
-	colour colour1 =decodeColour1( root);
-	colour colour2 =decodeColour2( root);
-	int radius =decodeRadius( root, m_lastBackgroundRadius);
-	EfillType fill =decodeFillType( root, m_lastBackgroundFill);
-	Cbackground *back =new Cbackground( parent, rect, code, colour1, radius, fill, colour2);
-	if ( fill ==FILL_IMAGE)
-	{
-		std::string image =decodeIcon( root);
-		back->setBackground( image);
-	}
-	int border =decodeBorderWidth( root, m_lastBackgroundBorderWidth);
-	if ( border!=0)
-	{
-		back->setBorderWidth( border);
+	default:
+		break;
 	}
-	m_object.push_back( back);
 }
 
 CjsonObject::~CjsonObject()
@@ -9,6 +9,7 @@
  **
  **  @par Classes:
  **              CkeyFile
+ **              CkeyReplay
  */
 /*------------------------------------------------------------------------------
  ** Copyright (C) 2011, 2014, 2015
@@ -36,15 +37,32 @@
  **===========================================================================*/
 
 /*------------- Standard includes --------------------------------------------*/
+#include <time.h>
+#include <string.h>
 #include "sdl_key_file.h"
 #include "sdl_graphics.h"
 #include "sdl_dialog_event.h"
+#include "timeout.h"
 
-#define ZHONGCAN_KEYFILE "keys.txt"
+#define ZHONGCAN_KEYFILE "keys.bin"
+
+/** @brief Monotonic time, not disturbed by clock changes.
+ *  @return Time in msec.
+ */
+static unsigned int keyFileNow()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return (unsigned int)(ts.tv_sec*1000+ts.tv_nsec/1000000);
+}
 
 CkeyFile::CkeyFile()
 : m_file(NULL)
 , m_mouseDown(false)
+, m_start(0)
+, m_head(0)
+, m_count(0)
+, m_lost(0)
 {
 }
 
@@ -53,15 +71,19 @@ CkeyFile::~CkeyFile()
 	close();
 }
 
+/** @brief Stop the writer and write what is left. */
 void CkeyFile::close()
 {
+	stop();
 	if (m_file)
 	{
+		flush();
 		fclose( m_file);
 		m_file =NULL;
 	}
 }
 
+/** @brief Open the journal and start the writer. */
 void CkeyFile::init()
 {
 	int enable =Cgraphics::m_defaults.enable_record_keyfile;
@@ -72,61 +94,111 @@ void CkeyFile::init()
 	close();
 	bool append =(enable==2);
 	std::string s=Cgraphics::m_defaults.data_path + ZHONGCAN_KEYFILE;
-	m_file =fopen( s.c_str(), append ? "at" : "wt");
+	m_file =fopen( s.c_str(), append ? "ab" : "wb");
+	if ( m_file ==NULL)
+	{
+		return;
+	}
+	fseek( m_file, 0, SEEK_END);
+	if ( ftell( m_file) ==0)
+	{
+		uint32_t header[2] ={ KEY_FILE_MAGIC, sizeof(SkeyRecord) };
+		fwrite( header, sizeof(header), 1, m_file);
+	}
+	m_ring.resize( KEY_FILE_RING);
+	m_write.reserve( KEY_FILE_RING);
+	m_head =0;
+	m_count =0;
+	m_lost =0;
+	m_mouseDown =false;
+	m_start =keyFileNow();
+	start();
+}
+
+/** @brief Write all waiting events, called by the writer thread. */
+void CkeyFile::flush()
+{
+	lock();
+	m_write.clear();
+	for ( int n=0; n<m_count; n++)
+	{
+		m_write.push_back( m_ring[(m_head+n)%KEY_FILE_RING]);
+	}
+	m_head =(m_head+m_count)%KEY_FILE_RING;
+	m_count =0;
+	unlock();
 
+	if ( m_write.empty() ==false)
+	{
+		fwrite( &m_write[0], sizeof(SkeyRecord), m_write.size(), m_file);
+		fflush( m_file);
+	}
+}
+
+/** @brief Writer thread, empty the ring now and then. */
+void CkeyFile::work()
+{
+	delay( KEY_FILE_FLUSH_TIME);
+	flush();
 }
 
-/// @brief Add button to file.
-void CkeyFile::addEvent( const std::string &event, int value1, int value2, const std::string &comment)
+/** @brief Add event to the ring, the disk is not touched.
+ *  @param type [in] What happened.
+ *  @param value1 [in] Key or x-position.
+ *  @param value2 [in] Y-position.
+ *  @param mod [in] Key modifiers.
+ */
+void CkeyFile::addEvent( EkeyRecord type, int value1, int value2, int mod)
 {
-	char t[128];
 	if ( m_file ==NULL)
 	{
 		return;
 	}
+	SkeyRecord r;
+	r.time =keyFileNow()-m_start;
+	r.type =(uint16_t)type;
+	r.mod =(uint16_t)mod;
+	r.value1 =value1;
+	r.value2 =value2;
 
-	sprintf( t, "  \"%s:%d:%d:%s\",\n", event.c_str(), value1, value2, comment.c_str());
-	fputs( t, m_file);
-	fflush( m_file);
+	lock();
+	if ( m_count ==KEY_FILE_RING)
+	{
+		m_lost++;
+	}
+	else
+	{
+		m_ring[(m_head+m_count)%KEY_FILE_RING] =r;
+		m_count++;
+	}
+	unlock();
 }
 
 /// @brief Add event to the file.
 /// @param event [in] What to save.
 void CkeyFile::onEvent(const SDL_Event *event)
 {
-	std::string str;
-
 	switch (event->type)
 	{
 	case SDL_KEYDOWN:
-		str=(std::string)Ckeybutton( (keybutton)(event->key.keysym.sym));
-		if ( !strcmp( str.c_str(), "\"" ))
-		{
-			str="\\\"";
-		}
-		addEvent( "KEYDOWN", event->key.keysym.mod, event->key.keysym.sym, str);
+		addEvent( KEY_RECORD_KEYDOWN, event->key.keysym.sym, 0, event->key.keysym.mod);
 		break;
 
 	case SDL_KEYUP:
-		str=(std::string)Ckeybutton( (keybutton)(event->key.keysym.sym));
-		if ( !strcmp( str.c_str(), "\"" ))
-		{
-			str="\\\"";
-		}
-		addEvent( "KEYUP", event->key.keysym.mod, event->key.keysym.sym, str);
+		addEvent( KEY_RECORD_KEYUP, event->key.keysym.sym, 0, event->key.keysym.mod);
 		break;
 
 	case SDL_MOUSEMOTION:
 		if ( m_mouseDown)
 		{
-			addEvent( "MOUSEMOTION", event->motion.x, event->motion.y, "");
+			addEvent( KEY_RECORD_MOTION, event->motion.x, event->motion.y);
 		}
 		break;
 	case SDL_MOUSEBUTTONUP:
 		switch (event->button.button)
 		{
 		case SDL_BUTTON_LEFT:
-			addEvent( "BUTTON_UP", event->motion.x, event->motion.y, "");
+			addEvent( KEY_RECORD_BUTTON_UP, event->button.x, event->button.y);
 			m_mouseDown =false;
 			break;
 		default:
@@ -138,22 +210,27 @@ void CkeyFile::onEvent(const SDL_Event *event)
 		switch (event->button.button)
 		{
 		case SDL_BUTTON_LEFT:
-			addEvent( "BUTTON_DOWN", event->button.x, event->button.y, "");
+			addEvent( KEY_RECORD_BUTTON_DOWN, event->button.x, event->button.y);
 			m_mouseDown =true;
 			break;
 #ifdef USE_SDL2
 #else
 		case SDL_BUTTON_WHEELUP:
-			addEvent( "WHEELUP", event->button.x, event->button.y, "");
+			addEvent( KEY_RECORD_WHEELUP, event->button.x, event->button.y);
 			break;
 		case SDL_BUTTON_WHEELDOWN:
-			addEvent( "WHEELDOWN", event->button.x, event->button.y, "");
+			addEvent( KEY_RECORD_WHEELDOWN, event->button.x, event->button.y);
 			break;
 #endif
 		default:
 			break;
 		}
 		break;
+
+	case SDL_JOYBUTTONDOWN:
+		addEvent( KEY_RECORD_TOUCH_LONG, event->button.x, event->button.y);
+		break;
+
 	default:
 		break;
 	}
@@ -163,57 +240,169 @@ void CkeyFile::onEvent(const SDL_Event *event)
 /// @param event [in] What to save.
 void CkeyFile::onEvent(const Cevent &event)
 {
-	std::string str;
-
 	switch (event.type)
 	{
 	case EVENT_KEY_PRESS:
-		str=(std::string)Ckeybutton(event.button);
-		if ( !strcmp( str.c_str(), "\"" ))
-		{
-			str="\\\"";
-		}
-		addEvent( "KEYDOWN", event.mod, event.button, str);
+		addEvent( KEY_RECORD_KEYDOWN, event.button, 0, event.mod);
 		break;
 
 	case EVENT_KEY_RELEASE:
-		str=(std::string)Ckeybutton(event.button);
-		if ( !strcmp( str.c_str(), "\"" ))
-		{
-			str="\\\"";
-		}
-		addEvent( "KEYUP", event.mod, event.button, str);
+		addEvent( KEY_RECORD_KEYUP, event.button, 0, event.mod);
 		break;
 
+	case EVENT_TOUCH_MOVE:
 	case EVENT_MOUSE_MOVE:
 		if ( m_mouseDown)
 		{
-			addEvent( "MOUSEMOTION", event.point.x, event.point.y, "");
+			addEvent( KEY_RECORD_MOTION, event.point.x, event.point.y);
 		}
 		break;
 
 	case EVENT_TOUCH_RELEASE:
-		addEvent( "BUTTON_UP", event.point.x, event.point.y, "");
+		addEvent( KEY_RECORD_BUTTON_UP, event.point.x, event.point.y);
 		m_mouseDown =false;
 		break;
 
 	case EVENT_TOUCH_LONG:
-		addEvent( "TOUCH_LONG", event.point.x, event.point.y, "");
+		addEvent( KEY_RECORD_TOUCH_LONG, event.point.x, event.point.y);
 		break;
 
 	case EVENT_TOUCH_PRESS:
-		addEvent( "BUTTON_DOWN", event.point.x, event.point.y, "");
+		addEvent( KEY_RECORD_BUTTON_DOWN, event.point.x, event.point.y);
+		m_mouseDown =true;
 		break;
 
 	case EVENT_WHEEL_UP:
-		addEvent( "WHEELUP", event.point.x, event.point.y, "");
+		addEvent( KEY_RECORD_WHEELUP, event.point.x, event.point.y);
 		break;
 
 	case EVENT_WHEEL_DOWN:
-		addEvent( "WHEELDOWN", event.point.x, event.point.y, "");
+		addEvent( KEY_RECORD_WHEELDOWN, event.point.x, event.point.y);
 		break;
 
 	default:
 		break;
 	}
 }
+
+/** @brief Constructor, nothing to play. */
+CkeyReplay::CkeyReplay()
+: m_next(0)
+, m_speed(1.0)
+, m_start(0)
+{
+}
+
+/** @brief Destructor. */
+CkeyReplay::~CkeyReplay()
+{
+}
+
+/** @brief Read an entire journal, the clock starts now.
+ *  @param fname [in] Journal written by CkeyFile.
+ *  @param speed [in] 1.0 original timing, 2.0 twice as fast, 0 without waiting.
+ *  @return True when the journal is read.
+ */
+bool CkeyReplay::open( const std::string &fname, double speed)
+{
+	close();
+	FILE *f =fopen( fname.c_str(), "rb");
+	if ( f ==NULL)
+	{
+		return false;
+	}
+	uint32_t header[2];
+	if (   fread( header, sizeof(header), 1, f) !=1
+		|| header[0] !=KEY_FILE_MAGIC
+		|| header[1] !=sizeof(SkeyRecord))
+	{
+		fclose( f);
+		return false;
+	}
+	SkeyRecord r;
+	uint32_t last =0;
+	uint32_t offset =0;
+	while ( fread( &r, sizeof(r), 1, f) ==1)
+	{
+		// An appended session starts at zero again, play it right after the previous one.
+		if ( r.time+offset <last)
+		{
+			offset =last-r.time;
+		}
+		r.time +=offset;
+		last =r.time;
+		m_records.push_back( r);
+	}
+	fclose( f);
+	m_speed =speed;
+	m_start =keyFileNow();
+	return true;
+}
+
+/** @brief Forget the journal. */
+void CkeyReplay::close()
+{
+	m_records.clear();
+	m_next =0;
+}
+
+/** @brief Build the next event when its time has come.
+ *  @param event [out] Event like SDL would give it.
+ *  @return True when an event is given.
+ */
+bool CkeyReplay::nextEvent( SDL_Event &event)
+{
+	while ( isFinished() ==false)
+	{
+		const SkeyRecord &r =m_records[m_next];
+		if ( m_speed >0 && (double)r.time > (double)(keyFileNow()-m_start)*m_speed)
+		{
+			return false;
+		}
+		m_next++;
+		memset( &event, 0, sizeof(event));
+		switch ( (EkeyRecord)r.type)
+		{
+		case KEY_RECORD_KEYDOWN:
+		case KEY_RECORD_KEYUP:
+			event.type =(r.type ==KEY_RECORD_KEYDOWN) ? SDL_KEYDOWN:SDL_KEYUP;
+			event.key.keysym.sym =r.value1;
+			event.key.keysym.mod =r.mod;
+			return true;
+
+		case KEY_RECORD_MOTION:
+			event.type =SDL_MOUSEMOTION;
+			event.motion.x =r.value1;
+			event.motion.y =r.value2;
+			return true;
+
+		case KEY_RECORD_BUTTON_DOWN:
+		case KEY_RECORD_BUTTON_UP:
+			event.type =(r.type ==KEY_RECORD_BUTTON_DOWN) ? SDL_MOUSEBUTTONDOWN:SDL_MOUSEBUTTONUP;
+			event.button.button =SDL_BUTTON_LEFT;
+			event.button.x =r.value1;
+			event.button.y =r.value2;
+			return true;
+
+		case KEY_RECORD_TOUCH_LONG:
+			event.type =SDL_JOYBUTTONDOWN;
+			event.button.x =r.value1;
+			event.button.y =r.value2;
+			return true;
+
+		default:
+			// Wheel events have no SDL2 input yet, skip them.
+			break;
+		}
+	}
+	return false;
+}
+
+/** @brief Use as Sdefaults::get_test_event to play the journal.
+ *  @param event [out] Next event.
+ *  @return True when an event is given.
+ */
+bool CkeyReplay::getTestEvent( SDL_Event &event)
+{
+	return Instance()->nextEvent( event);
+}
@@ -18,15 +18,26 @@
  **  Unauthorized duplication and disclosure to third parties is forbidden.
  **===========================================================================*/
 
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
 #include "sdl_keybutton.h"
 
+/// Both lookup tables have 2^KEY_SLOT_BITS slots.
+#define KEY_SLOT_BITS	12
+#define KEY_SLOTS		(1<<KEY_SLOT_BITS)
+/// When a static_assert below fails after changing keys[], try another seed.
+#define KEY_NAME_SEED	0x811ca3c3u
+#define KEY_CODE_SEED	0x9e3779b1u
+
 typedef struct
 {
 	keybutton key;
-	std::string txt;
+	const char *txt;
 } Skey;
 
-const Skey keys[]=
+/// Names of the keys. For a key or a name used twice, the first one counts.
+constexpr Skey keys[]=
 {
 	{ 	KEY_ESCAPE		, "ESC" },
 	{   KEY_UP    		, "UP" },
@@ -304,84 +315,243 @@ const Skey keys[]=
 	{	KEY_SLIDER		, "SLIDER" },
 	{ 	KEY_ESCAPE		, "ESCAPE" },
 	{ 	KEY_ESCAPE		, "ESC" },
-	{	KEY_UNDEFINED	, "UNDEFINED" },
-    {   KEY_UNDEFINED   , "" }
 };
 
+/// Number of names, also marks an empty slot.
+#define KEY_NAMES		(sizeof(keys)/sizeof(keys[0]))
+
+/*------------- Hash tables, built by the compiler ---------------------------*/
+
+/** @brief FNV-1a hash of a name which is not zero terminated. */
+constexpr uint32_t nameHash( const char *s, size_t length, uint32_t hash)
+{
+	return length==0 ? hash:nameHash( s+1, length-1, (hash^(uint8_t)*s)*16777619u);
+}
+
+constexpr size_t nameLength( const char *s)
+{
+	return *s ? 1+nameLength( s+1):0;
+}
+
+constexpr bool sameName( const char *a, const char *b)
+{
+	return *a==*b && ( *a==0 || sameName( a+1, b+1));
+}
+
+constexpr unsigned nameSlot( const char *s, size_t length)
+{
+	return nameHash( s, length, KEY_NAME_SEED) & (KEY_SLOTS-1);
+}
+
+/** @brief Multiplicative hash, SDL2 key codes have bit 30 set. */
+constexpr unsigned keySlot( keybutton key)
+{
+	return ((uint32_t)key*KEY_CODE_SEED) >> (32-KEY_SLOT_BITS);
+}
+
+/// List 0..N-1, split in halves to keep the templates shallow.
+template<unsigned... I> struct SkeyIndices {};
+
+template<class A, class B> struct SkeyJoin;
+template<unsigned... A, unsigned... B>
+struct SkeyJoin< SkeyIndices<A...>, SkeyIndices<B...> >
+{
+	typedef SkeyIndices< A..., (sizeof...(A)+B)... > type;
+};
+
+template<unsigned N> struct SkeyRange
+{
+	typedef typename SkeyJoin< typename SkeyRange<N/2>::type,
+	                           typename SkeyRange<N-N/2>::type >::type type;
+};
+template<> struct SkeyRange<0> { typedef SkeyIndices<> type; };
+template<> struct SkeyRange<1> { typedef SkeyIndices<0> type; };
+
+/// Slot of every entry in keys[].
+typedef struct
+{
+	unsigned short slot[KEY_NAMES];
+} SkeyHashes;
+
+template<unsigned... I>
+constexpr SkeyHashes nameHashes( SkeyIndices<I...>)
+{
+	return SkeyHashes{ { (unsigned short)nameSlot( keys[I].txt, nameLength( keys[I].txt))... } };
+}
+
+template<unsigned... I>
+constexpr SkeyHashes keyHashes( SkeyIndices<I...>)
+{
+	return SkeyHashes{ { (unsigned short)keySlot( keys[I].key)... } };
+}
+
+constexpr SkeyHashes nameSlotOf =nameHashes( SkeyRange<KEY_NAMES>::type());
+constexpr SkeyHashes keySlotOf =keyHashes( SkeyRange<KEY_NAMES>::type());
+
+/** @brief First entry in a slot from p on, KEY_NAMES when none.
+ *  Eight entries per call, that keeps compiling fast.
+ */
+constexpr unsigned short findSlot( const SkeyHashes &h, unsigned slot, unsigned p)
+{
+	return p>=KEY_NAMES ? KEY_NAMES
+	     : h.slot[p]==slot ? p
+	     : p+1<KEY_NAMES && h.slot[p+1]==slot ? p+1
+	     : p+2<KEY_NAMES && h.slot[p+2]==slot ? p+2
+	     : p+3<KEY_NAMES && h.slot[p+3]==slot ? p+3
+	     : p+4<KEY_NAMES && h.slot[p+4]==slot ? p+4
+	     : p+5<KEY_NAMES && h.slot[p+5]==slot ? p+5
+	     : p+6<KEY_NAMES && h.slot[p+6]==slot ? p+6
+	     : p+7<KEY_NAMES && h.slot[p+7]==slot ? p+7
+	     : findSlot( h, slot, p+8);
+}
+
+/// Index in keys[] for every slot.
+typedef struct
+{
+	unsigned short entry[KEY_SLOTS];
+} SkeySlots;
+
+template<unsigned... I>
+constexpr SkeySlots firstEntries( const SkeyHashes &h, SkeyIndices<I...>)
+{
+	return SkeySlots{ { findSlot( h, I, 0)... } };
+}
+
+constexpr SkeySlots nameTable =firstEntries( nameSlotOf, SkeyRange<KEY_SLOTS>::type());
+constexpr SkeySlots keyTable =firstEntries( keySlotOf, SkeyRange<KEY_SLOTS>::type());
+
+/** @brief Check that each name finds its first entry, no other name. */
+constexpr bool perfectNames( unsigned p)
+{
+	return p==KEY_NAMES
+	    || (   sameName( keys[ nameTable.entry[ nameSlotOf.slot[p]]].txt, keys[p].txt)
+	        && perfectNames( p+1));
+}
+
+/** @brief Check that each key finds its first entry, no other key. */
+constexpr bool perfectKeys( unsigned p)
+{
+	return p==KEY_NAMES
+	    || (   keys[ keyTable.entry[ keySlotOf.slot[p]]].key ==keys[p].key
+	        && perfectKeys( p+1));
+}
+
+static_assert( perfectNames( 0), "Two key names share a slot, change KEY_NAME_SEED");
+static_assert( perfectKeys( 0), "Two keys share a slot, change KEY_CODE_SEED");
+
+/*------------- Numbered families --------------------------------------------*/
+
+/** @brief Name for a key in a numbered family, e.g. KEY_FOUND12.
+ *  @param prefix [in] Name without number.
+ *  @param number [in] Number, starting at 1.
+ */
+static std::string rangeName( const char *prefix, int number)
+{
+	char s[32];
+	char digits[12];
+	size_t n =strlen( prefix);
+	int d =0;
+	memcpy( s, prefix, n);
+	do
+	{
+		digits[d++] =(char)('0'+number%10);
+		number /=10;
+	} while ( number>0);
+	while ( d>0)
+	{
+		s[n++] =digits[--d];
+	}
+	return std::string( s, n);
+}
+
+/** @brief Check if a name starts with a family prefix. */
+static bool hasPrefix( const char *s, size_t length, const char *prefix, size_t prefixLength)
+{
+	return length>=prefixLength && memcmp( s, prefix, prefixLength)==0;
+}
+
+/** @brief Number after a family prefix, read like atoi() does.
+ *  @param s [in] Text after the prefix.
+ *  @param length [in] Characters left.
+ */
+static int rangeNumber( const char *s, size_t length)
+{
+	size_t n =0;
+	int sign =1;
+	int number =0;
+	while ( n<length && isspace( (unsigned char)s[n]))
+	{
+		n++;
+	}
+	if ( n<length && ( s[n]=='-' || s[n]=='+'))
+	{
+		sign =( s[n]=='-') ? -1:1;
+		n++;
+	}
+	while ( n<length && s[n]>='0' && s[n]<='9')
+	{
+		number =number*10+(s[n]-'0');
+		n++;
+	}
+	return sign*number;
+}
+
+/*------------- Conversion ---------------------------------------------------*/
+
 std::string key2string( keybutton key)
 {
-	for ( int p=0;;p++)
+	unsigned short p =keyTable.entry[ keySlot( key)];
+	if ( p<KEY_NAMES && keys[p].key ==key)
 	{
-		if ( keys[p].key ==KEY_UNDEFINED)
-		{
-			break;
-		}
-		if ( keys[p].key ==key)
-		{
-			// Found key.
-			return keys[p].txt;
-		}
+		// Found key.
+		return keys[p].txt;
 	}
 	if ( key>=KEY_RADICAL1 && key<=KEY_RADICAL189)
 	{
-		char s[32];
-		sprintf( s, "KEY_RADICAL%d", key-KEY_RADICAL1+1);
-		return s;
+		return rangeName( "KEY_RADICAL", key-KEY_RADICAL1+1);
 	}
 	if ( key>=KEY_FOUND1 && key<=KEY_FOUND142)
 	{
-		char s[32];
-		sprintf( s, "KEY_FOUND%d", key-KEY_FOUND1+1);
-		return s;
+		return rangeName( "KEY_FOUND", key-KEY_FOUND1+1);
 	}
 	if ( key>=KEY_COLOUR_1 && key<=KEY_COLOUR_48)
 	{
-		char s[32];
-		sprintf( s, "KEY_COLOUR_%d", key-KEY_COLOUR_1+1);
-		return s;
+		return rangeName( "KEY_COLOUR_", key-KEY_COLOUR_1+1);
 	}
 	if ( key>=KEY_MAP_ITEM1 && key<=KEY_MAP_ITEM1000)
 	{
-		char s[32];
-		sprintf( s, "KEY_MAP_ITEM%d", key-KEY_MAP_ITEM1+1);
-		return s;
+		return rangeName( "KEY_MAP_ITEM", key-KEY_MAP_ITEM1+1);
 	}
 	return "";
 }
 
-keybutton string2key( std::string s)
+keybutton string2key( const char *s, size_t length)
 {
-	for ( int p=0;;p++)
+	unsigned short p =nameTable.entry[ nameSlot( s, length)];
+	if ( p<KEY_NAMES && strlen( keys[p].txt)==length && memcmp( keys[p].txt, s, length)==0)
 	{
-		if ( keys[p].key ==KEY_UNDEFINED)
-		{
-			break;
-		}
-		if ( keys[p].txt ==s)
-		{
-			// Found key.
-			return keys[p].key;
-		}
+		// Found key.
+		return keys[p].key;
 	}
 	// KEY_RADICAL1 ..89
 	// KEY_FOUND1 ..42
 	// KEY_COLOUR_1 ..48
 	// KEY_MAP_ITEM1 ..1000
-	if ( s.find( "KEY_RADICAL")==0)
+	if ( hasPrefix( s, length, "KEY_RADICAL", 11))
 	{
-		return (keybutton)( KEY_RADICAL1+(atoi( s.c_str()+11))-1);
+		return (keybutton)( KEY_RADICAL1+rangeNumber( s+11, length-11)-1);
 	}
-	if ( s.find( "KEY_FOUND")==0)
+	if ( hasPrefix( s, length, "KEY_FOUND", 9))
 	{
-		return (keybutton)( KEY_FOUND1+(atoi( s.c_str()+9))-1);
+		return (keybutton)( KEY_FOUND1+rangeNumber( s+9, length-9)-1);
 	}
-	if ( s.find( "KEY_COLOUR_")==0)
+	if ( hasPrefix( s, length, "KEY_COLOUR_", 11))
 	{
-		return (keybutton)( KEY_COLOUR_1+(atoi( s.c_str()+11))-1);
+		return (keybutton)( KEY_COLOUR_1+rangeNumber( s+11, length-11)-1);
 	}
-	if ( s.find( "KEY_MAP_ITEM")==0)
+	if ( hasPrefix( s, length, "KEY_MAP_ITEM", 12))
 	{
-		return (keybutton)( KEY_MAP_ITEM1+(atoi( s.c_str()+12))-1);
+		return (keybutton)( KEY_MAP_ITEM1+rangeNumber( s+12, length-12)-1);
 	}
 	return KEY_UNDEFINED;
 }
@@ -397,7 +567,16 @@ Ckeybutton::operator keybutton()
 }
 
 Ckeybutton::Ckeybutton( const std::string &str)
-: m_key( string2key(str))
+: m_key( string2key( str.data(), str.size()))
+{
+}
+
+/** @brief Key from a name which is not zero terminated.
+ *  @param str [in] Name, e.g. from a JSON text.
+ *  @param length [in] Characters in the name.
+ */
+Ckeybutton::Ckeybutton( const char *str, size_t length)
+: m_key( string2key( str, length))
 {
 }
 
@@ -117,6 +117,7 @@ void Clabel::setText( const std::string &txt)
 {
 	m_label=txt;
 	m_enable =(m_label.length()) ? true:false;
+	invalidate();
 	int w=0,h=0;
 	if ( !m_font.local.font)
 	{
@@ -133,4 +134,5 @@ void Clabel::setText( const std::string &txt)
 	m_rect.setHeight(h);
 	m_rect.setLeft( m_rect.right()-w);
 	m_rect.setWidth( w);
+	invalidate();
 }
@@ -0,0 +1,737 @@
+/*============================================================================*/
+/**  @file       sdl_layout.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Compile JSON dialog layouts.
+ **
+ **  Resolve JSON layouts into records, save them and map them again.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              ClayoutCompiler
+ **              ClayoutFile
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include <ctype.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sdl_layout.h"
+
+/** @brief Constructor, defaults for the first object. */
+ClayoutCompiler::ClayoutCompiler()
+: m_lastCode(KEY_NONE)
+, m_lastRect(0,0,6,6)
+, m_buttonBorder( BORDER_THIN)
+, m_lastBorder(BORDER_NONE)
+, m_buttonGravity(GRAVITY_CENTER)
+, m_imageGravity(GRAVITY_CENTER)
+, m_lastMargin(0)
+, m_lastLabel("")
+, m_lastType("image")
+, m_lastColour1(0)
+, m_lastColour2(0)
+, m_lastButtonFill( FILL_GRADIENT)
+, m_lastBackgroundRadius( 0)
+, m_lastBackgroundBorderWidth( 2)
+, m_lastBackgroundFill( FILL_GRADIENT)
+, m_lastButtonRadius( 4)
+{
+}
+
+/** @brief Name of the compiled layout for a JSON file.
+ *  @param fname [in] JSON file.
+ *  @return Compiled file name.
+ */
+std::string ClayoutCompiler::compiledName( const std::string &fname)
+{
+	return fname + LAYOUT_EXTENSION;
+}
+
+/** @brief Resolve a JSON description into records.
+ *  Defaults taken over from earlier objects are kept between calls.
+ *  @param description [in] Json string with one object or an array.
+ *  @return false on a parse error.
+ */
+bool ClayoutCompiler::compile( const std::string &description)
+{
+	m_records.clear();
+	m_strings.clear();
+	m_offsets.clear();
+	addString( "");
+	// Strings of the parsed json point into the description.
+	m_arena.clear();
+	bool parsingSuccessful = m_reader.parse( description, m_arena, m_root);
+	if ( !parsingSuccessful )
+	{
+		if ( Cgraphics::m_defaults.log)
+		{
+			// The dialog stays empty, tell why.
+			Cgraphics::m_defaults.log( "ClayoutCompiler::compile  Failed to parse layout: %s",
+					                   m_reader.getFormattedErrorMessages().c_str());
+		}
+		return false;
+    }
+	if ( m_root.isArray())
+	{
+		for ( int n=0; n<(int)m_root.size(); n++)
+		{
+			decode( m_root[n]);
+		}
+	}
+	else
+	{
+		decode( m_root);
+	}
+	return true;
+}
+
+/** @brief Write the records of the last compile.
+ *  @param fname [in] Compiled layout file.
+ *  @return true on success.
+ */
+bool ClayoutCompiler::save( const std::string &fname)
+{
+	SlayoutHeader header;
+	header.magic =LAYOUT_MAGIC;
+	header.version =LAYOUT_VERSION;
+	header.recordSize =sizeof(SlayoutRecord);
+	header.records =(uint32_t)m_records.size();
+	header.strings =(uint32_t)m_strings.size();
+
+	FILE *f =fopen( fname.c_str(), "wb");
+	if ( f ==NULL)
+	{
+		return false;
+	}
+	bool retVal =( fwrite( &header, sizeof(header), 1, f) ==1);
+	if ( retVal && m_records.empty() ==false)
+	{
+		retVal =( fwrite( &m_records[0], sizeof(SlayoutRecord), m_records.size(), f) ==m_records.size());
+	}
+	if ( retVal)
+	{
+		retVal =( fwrite( &m_strings[0], 1, m_strings.size(), f) ==m_strings.size());
+	}
+	if ( fclose( f) !=0)
+	{
+		retVal =false;
+	}
+	return retVal;
+}
+
+/** @brief Put a string in the table once.
+ *  @param text [in] What to add.
+ *  @return Offset in the string table.
+ */
+uint32_t ClayoutCompiler::addString( const std::string &text)
+{
+	auto it =m_offsets.find( text);
+	if ( it !=m_offsets.end())
+	{
+		return it->second;
+	}
+	uint32_t offset =(uint32_t)m_strings.size();
+	m_strings.insert( m_strings.end(), text.begin(), text.end());
+	m_strings.push_back( 0);
+	m_offsets[text] =offset;
+	return offset;
+}
+
+/** @brief Decode the object
+ *  @param value [in] One object.
+ */
+void ClayoutCompiler::decode( const Json::ArenaValue &value)
+{
+	SlayoutRecord record;
+	memset( &record, 0, sizeof(record));
+
+	Json::ArenaValue v=value["type"];
+	if ( v.isString())
+	{
+		m_lastType =v.asString();
+	}
+	if ( m_lastType.compare("image")==0)
+	{
+		record.type =LAYOUT_IMAGE;
+		decodeImage( value, record);
+	}
+	else if ( m_lastType.compare("button")==0)
+	{
+		record.type =LAYOUT_BUTTON;
+		decodeButton( value, record);
+	}
+	else if ( m_lastType.compare("bottombutton")==0)
+	{
+		record.type =LAYOUT_BOTTOM_BUTTON;
+		decodeButton( value, record);
+	}
+	else if ( m_lastType.compare("calculatorbutton")==0)
+	{
+		record.type =LAYOUT_CALCULATOR_BUTTON;
+		decodeButton( value, record);
+	}
+	else if (   m_lastType.compare("header")==0
+			 || m_lastType.compare("headerbutton")==0)
+	{
+		record.type =LAYOUT_HEADER_BUTTON;
+		decodeButton( value, record);
+	}
+	else if ( m_lastType.compare("background")==0)
+	{
+		record.type =LAYOUT_BACKGROUND;
+		decodeBackground( value, record);
+	}
+	else if ( m_lastType.compare("text")==0)
+	{
+		record.type =LAYOUT_TEXT;
+		decodeText( value, record);
+	}
+	else
+	{
+		//"ClayoutCompiler::decode Wrong type!!");
+		return;
+	}
+	m_records.push_back( record);
+}
+
+/** @brief Find a string value.
+ *  @param root [in] Object.
+ *  @param key [in] Name of the value.
+ *  @param flag [in] Flag to set in the record when the value is there.
+ *  @param record [out] Record to mark.
+ *  @return Value or empty.
+ */
+std::string ClayoutCompiler::decodeString( const Json::ArenaValue &root, const char *key,
+		                                   uint32_t flag, SlayoutRecord &record)
+{
+	Json::ArenaValue v =root[key];
+	if ( v.isString())
+	{
+		record.flags |=flag;
+		return v.asString();
+	}
+	return "";
+}
+
+void ClayoutCompiler::decodeImage( const Json::ArenaValue &root, SlayoutRecord &record)
+{
+	Crect rect =decodeRect( root);
+	record.code =decodeKeybutton( root);
+	record.icon =addString( decodeIcon( root));
+	record.border =decodeBorder( root, m_lastBorder);
+	record.margin =decodeMargin( root);
+	m_lastLabel ="";
+	record.label =addString( decodeLabel( root));
+	Json::ArenaValue v=root["gravity"];
+	if ( v.isString())
+	{
+		m_imageGravity =decodeGravity( root, m_imageGravity);
+	}
+	record.gravity =m_imageGravity;
+	record.left =rect.left();
+	record.top =rect.top();
+	record.width =rect.width();
+	record.height =rect.height();
+}
+
+int ClayoutCompiler::decodeBorderWidth( const Json::ArenaValue &root, int &borderwidth)
+{
+	Json::ArenaValue v=root["border"];
+	if ( v.isInt())
+	{
+		borderwidth =v.asInt();
+	}
+	return borderwidth;
+}
+
+std::string ClayoutCompiler::decodeIcon( const Json::ArenaValue &root)
+{
+	std::string icon ="";
+	Json::ArenaValue v=root["icon"];
+	if ( v.isString())
+	{
+		icon =v.asString();
+	}
+	else
+	{
+		v=root["image"];
+		if ( v.isString())
+		{
+			icon =v.asString();
+		}
+	}
+	return icon;
+}
+
+int ClayoutCompiler::decodeMargin( const Json::ArenaValue &root)
+{
+	int margin =m_lastMargin;
+	Json::ArenaValue v=root["margin"];
+	if ( v.isIntegral())
+	{
+		margin =v.asInt();
+		m_lastMargin =margin;
+	}
+	return m_lastMargin;
+}
+
+std::string ClayoutCompiler::decodeLabel( const Json::ArenaValue &root)
+{
+	std::string label =m_lastLabel;
+	Json::ArenaValue v=root["label"];
+	if ( v.isString())
+	{
+		label =v.asString();
+		m_lastLabel =label;
+	}
+	return m_lastLabel;
+}
+
+/** @brief Decode the button for the object
+ *  @param root [in] What root
+ */
+keybutton ClayoutCompiler::decodeKeybutton( const Json::ArenaValue &root)
+{
+	Json::ArenaValue v=root["code"];
+	if ( v.isString())
+	{
+		m_lastCode =Ckeybutton( v.data(), v.length());
+	}
+	else
+	{
+		if ( m_lastCode !=KEY_NONE)
+		{
+			m_lastCode++;
+		}
+	}
+	return (keybutton)m_lastCode;
+}
+
+Crect ClayoutCompiler::decodeRect( const Json::ArenaValue &root)
+{
+	Json::ArenaValue v=root["rect"];
+	if ( v.isArray() && v.size()==4)
+	{
+		int left =v[(unsigned int)0].asInt();
+		int top =v[1].asInt();
+		int width =v[2].asInt();
+		int height =v[3].asInt();
+		m_lastRect =Crect( left, top, width, height);
+	}
+	else
+	{
+		m_lastRect.setLeft( m_lastRect.right());
+	}
+	return m_lastRect;
+}
+
+colour ClayoutCompiler::decodeColour1( const Json::ArenaValue &root)
+{
+	Json::ArenaValue v=root["colour"];
+	if ( !v.isString())
+	{
+		v =root["colour1"];
+	}
+	if ( v.isString())
+	{
+		std::string s =v.asString();
+		if (s.size()>1 && toupper(s[1]) =='X')
+		{
+			m_lastColour1 =strtol(s.c_str()+2, NULL, 16);
+		}
+		else
+		{
+			m_lastColour1 =atoi( s.c_str());
+		}
+	}
+	return m_lastColour1;
+}
+
+colour ClayoutCompiler::decodeColour2( const Json::ArenaValue &root)
+{
+	Json::ArenaValue v=root["colour2"];
+	if ( v.isString())
+	{
+		std::string s =v.asString();
+		if (s.size()>1 && toupper(s[1]) =='X')
+		{
+			m_lastColour2 =strtol(s.c_str()+2, NULL, 16);
+		}
+		else
+		{
+			m_lastColour2 =atoi( s.c_str());
+		}
+	}
+
+	return m_lastColour2;
+}
+
+int ClayoutCompiler::decodeRadius( const Json::ArenaValue &root, int &lastValue)
+{
+	Json::ArenaValue v=root["radius"];
+	if ( v.isInt())
+	{
+		lastValue =v.asInt();
+	}
+	return lastValue;
+}
+
+EfillType ClayoutCompiler::decodeFillType( const Json::ArenaValue &root, EfillType &fill)
+{
+	Json::ArenaValue v=root["fill"];
+	if ( v.isString())
+	{
+		std::string s=v.asString();
+		if ( s.compare("none")==0)
+		{
+			fill =FILL_NONE;
+		}
+		else if ( s.compare("solid")==0)
+		{
+			fill =FILL_UNICOLOURED;
+		}
+		else if ( s.compare("2colours")==0)
+		{
+			fill =FILL_2COLOURS;
+		}
+		else if ( s.compare("gradient")==0)
+		{
+			fill =FILL_GRADIENT;
+		}
+		else if ( s.compare("pyramid")==0)
+		{
+			fill =FILL_PYRAMID;
+		}
+		else if ( s.compare("image")==0)
+		{
+			fill =FILL_IMAGE;
+		}
+	}
+	return fill;
+}
+
+EborderType ClayoutCompiler::decodeBorder( const Json::ArenaValue &root, EborderType &border)
+{
+	Json::ArenaValue v=root["border"];
+	if ( v.isString())
+	{
+		std::string  border =v.asString();
+		if ( v.compare( "none")==0)
+		{
+			border =BORDER_NONE;
+		}
+		else if ( v.compare( "thin"))
+		{
+			border =BORDER_THIN;
+		}
+		else if ( v.compare( "thin_shadow"))
+		{
+			border =BORDER_THIN_SHADOW;
+		}
+		else if ( v.compare( "thin_selected"))
+		{
+			border =BORDER_THIN_SELECTED;
+		}
+		else if ( v.compare( "thin_button_shadow"))
+		{
+			border =BORDER_THIN_BUTTON_SHADOW;
+		}
+		else if ( v.compare( "thin"))
+		{
+			border =BORDER_THIN;
+		}
+		else if ( v.compare( "thin"))
+		{
+			border =BORDER_THIN;
+		}
+		else if ( v.compare( "thin"))
+		{
+			border =BORDER_THIN;
+		}
+		else if ( v.compare( "thin"))
+		{
+			border =BORDER_THIN;
+		}
+		else if ( v.compare( "thin"))
+		{
+			border =BORDER_THIN;
+		}
+	}
+	return border;
+}
+
+void ClayoutCompiler::decodeText( const Json::ArenaValue &root, SlayoutRecord &record)
+{
+	Crect rect =decodeRect( root);
+	record.code =decodeKeybutton( root);
+	record.font =addString( decodeFont( root, "button"));
+	record.text =addString( decodeString( root, "text", 0, record));
+	record.textColour =addString( decodeString( root, "text_colour", LAYOUT_HAS_TEXT_COLOUR, record));
+	record.gravity =decodeGravity( root, m_buttonGravity);
+	record.left =rect.left();
+	record.top =rect.top();
+	record.width =rect.width();
+	record.height =rect.height();
+}
+
+/** @brief Find font in the string
+ *  @param root [in] Where to look
+ *  @param name [in] Default value
+ *  @return Font name
+ */
+std::string ClayoutCompiler::decodeFont( const Json::ArenaValue &root, const std::string &name)
+{
+	std::string fontName =name;
+	Json::ArenaValue v =root["font"];
+	if ( v.isString())
+	{
+		fontName =v.asString();
+	}
+	return fontName;
+}
+
+/** @brief Find gravity in the string
+ *  @param value [in] Where to look
+ *  @param gravity [in] Default value
+ *  @return Gravity found or default value
+ */
+Egravity ClayoutCompiler::decodeGravity( const Json::ArenaValue &value, Egravity &gravity)
+{
+	Json::ArenaValue v=value["gravity"];
+	if ( v.isString())
+	{
+		std::string s=v.asString();
+		if ( s.compare("left")==0)
+		{
+			gravity =GRAVITY_LEFT_CENTER;
+		}
+		else if ( s.compare("left_top")==0)
+		{
+			gravity =GRAVITY_LEFT;
+		}
+		else if ( s.compare("top_center")==0)
+		{
+			gravity =GRAVITY_TOP_CENTER;
+		}
+		else if ( s.compare("right_center")==0)
+		{
+			gravity =GRAVITY_RIGHT_CENTER;
+		}
+		else if ( s.compare("right_bottom")==0)
+		{
+			gravity =GRAVITY_RIGHT_BOTTOM;
+		}
+		else if ( s.compare("right_top")==0)
+		{
+			gravity =GRAVITY_RIGHT;
+		}
+		else if ( s.compare("center")==0)
+		{
+			gravity =GRAVITY_CENTER;
+		}
+		else if ( s.compare("resize"))
+		{
+			gravity =GRAVITY_RESIZE;
+		}
+		// "ClayoutCompiler::decodeGravity wrong %s!!", s.c_str());
+	}
+	return gravity;
+}
+
+/** @brief Decode all kinds of buttons, only the values each kind uses.
+ *  @param root [in] Json object to decode
+ *  @param record [out] Resolved button.
+ */
+void ClayoutCompiler::decodeButton( const Json::ArenaValue &root, SlayoutRecord &record)
+{
+	Crect rect =decodeRect( root);
+	record.code =decodeKeybutton( root);
+	record.left =rect.left();
+	record.top =rect.top();
+	record.width =rect.width();
+	record.height =rect.height();
+
+	switch ( record.type)
+	{
+	case LAYOUT_BUTTON:
+		record.border =decodeBorder( root, m_buttonBorder); // default =BORDER_THIN
+		record.font =addString( decodeFont( root, "button"));
+		record.gravity =decodeGravity( root, m_buttonGravity);
+		record.id =addString( decodeString( root, "id", LAYOUT_HAS_ID, record));
+		record.radius =decodeRadius( root, m_lastButtonRadius); // default =6
+		record.fill =decodeFillType( root, m_lastButtonFill); // default =FILL_UNICOLOURED
+		record.label =addString( decodeString( root, "label", LAYOUT_HAS_LABEL, record));
+		break;
+	case LAYOUT_BOTTOM_BUTTON:
+		record.id =addString( decodeString( root, "id", LAYOUT_HAS_ID, record));
+		record.icon =addString( decodeIcon( root));
+		break;
+	case LAYOUT_HEADER_BUTTON:
+		record.id =addString( decodeString( root, "id", LAYOUT_HAS_ID, record));
+		break;
+	default:
+		break;
+	}
+	record.text =addString( decodeString( root, "text", 0, record));
+}
+
+/** @brief Decode the background object
+ *
+ *  @param root [in] Json object to decode
+ *  @param record [out] Resolved background.
+ */
+void ClayoutCompiler::decodeBackground( const Json::ArenaValue &root, SlayoutRecord &record)
+{
+	Crect rect =decodeRect( root);
+	record.code =decodeKeybutton( root);
+	record.colour1 =decodeColour1( root);
+	record.colour2 =decodeColour2( root);
+	record.radius =decodeRadius( root, m_lastBackgroundRadius);
+	record.fill =decodeFillType( root, m_lastBackgroundFill);
+	if ( record.fill ==FILL_IMAGE)
+	{
+		record.icon =addString( decodeIcon( root));
+	}
+	record.borderWidth =decodeBorderWidth( root, m_lastBackgroundBorderWidth);
+	record.left =rect.left();
+	record.top =rect.top();
+	record.width =rect.width();
+	record.height =rect.height();
+}
+
+/** @brief Constructor, nothing mapped. */
+ClayoutFile::ClayoutFile()
+: m_map( NULL)
+, m_length( 0)
+, m_header( NULL)
+, m_records( NULL)
+, m_strings( NULL)
+{
+}
+
+/** @brief Destructor, unmap the file. */
+ClayoutFile::~ClayoutFile()
+{
+	close();
+}
+
+/** @brief Check if the compiled layout is not older than its JSON file.
+ *  @param compiled [in] Compiled layout.
+ *  @param source [in] JSON file, may be missing when only the compiled one is shipped.
+ *  @return true when the compiled layout can be used.
+ */
+bool ClayoutFile::isUpToDate( const std::string &compiled, const std::string &source)
+{
+	struct stat c, s;
+	if ( stat( compiled.c_str(), &c) !=0)
+	{
+		return false;
+	}
+	if ( stat( source.c_str(), &s) !=0)
+	{
+		return true;
+	}
+	return c.st_mtime >=s.st_mtime;
+}
+
+/** @brief Map a compiled layout and check it.
+ *  @param fname [in] Compiled layout.
+ *  @return false when missing, another version or damaged.
+ */
+bool ClayoutFile::open( const std::string &fname)
+{
+	close();
+	int fd =::open( fname.c_str(), O_RDONLY);
+	if ( fd <0)
+	{
+		return false;
+	}
+	struct stat st;
+	if ( fstat( fd, &st) !=0 || st.st_size <(off_t)sizeof(SlayoutHeader))
+	{
+		::close( fd);
+		return false;
+	}
+	m_length =(size_t)st.st_size;
+	m_map =mmap( NULL, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close( fd);
+	if ( m_map ==MAP_FAILED)
+	{
+		m_map =NULL;
+		return false;
+	}
+	const SlayoutHeader *header =(const SlayoutHeader*)m_map;
+	size_t records =(size_t)header->records*sizeof(SlayoutRecord);
+	if (   header->magic !=LAYOUT_MAGIC
+		|| header->version !=LAYOUT_VERSION
+		|| header->recordSize !=sizeof(SlayoutRecord)
+		|| header->strings ==0
+		|| m_length !=sizeof(SlayoutHeader)+records+header->strings)
+	{
+		close();
+		return false;
+	}
+	m_header =header;
+	m_records =(const SlayoutRecord*)(header+1);
+	m_strings =(const char*)m_records+records;
+	if ( m_strings[header->strings-1] !=0)
+	{
+		close();
+		return false;
+	}
+	for ( int n=0; n<size(); n++)
+	{
+		const SlayoutRecord &r =m_records[n];
+		if (   r.icon>=header->strings || r.label>=header->strings
+			|| r.font>=header->strings || r.text>=header->strings
+			|| r.id>=header->strings || r.textColour>=header->strings)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Unmap the file. */
+void ClayoutFile::close()
+{
+	if ( m_map)
+	{
+		munmap( m_map, m_length);
+	}
+	m_map =NULL;
+	m_length =0;
+	m_header =NULL;
+	m_records =NULL;
+	m_strings =NULL;
+}
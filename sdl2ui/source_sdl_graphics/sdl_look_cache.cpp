@@ -0,0 +1,206 @@
+/*============================================================================*/
+/**  @file       sdl_look_cache.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Keep painted button backgrounds between frames.
+ **
+ **  A look is painted in a target texture at position 0,0 and copied to
+ **  the button with one SDL_RenderCopy afterwards.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              ClookCache
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include "sdl_look_cache.h"
+
+#ifdef USE_SDL2
+/** @brief Constructor, empty cache. */
+ClookCache::ClookCache()
+: m_bytes(0)
+, m_painting(NULL)
+, m_target(NULL)
+, m_offset(0,0)
+{
+}
+
+/** @brief Destructor, release all textures. */
+ClookCache::~ClookCache()
+{
+	clear();
+}
+
+/** @brief Round a touch level, so an after-glow uses a few looks only.
+ *  @param touch [in] Touch level from the after-glow.
+ *  @return Touch level to paint, 0 stays 0.
+ */
+int ClookCache::quantize( int touch)
+{
+	if ( touch ==0)
+	{
+		return 0;
+	}
+	int step =TOUCH_MAXIMUM/LOOK_TOUCH_STEPS;
+	int level =( touch>0) ? (touch+step-1)/step : (touch-step+1)/step;
+	return gLimit( level*step, TOUCH_MINIMUM, TOUCH_MAXIMUM);
+}
+
+/** @brief Paint a look from the cache.
+ *  @param key [in] Look to find.
+ *  @param graphics [in] Where to paint.
+ *  @param left [in] Left position in pixels.
+ *  @param top [in] Top position in pixels.
+ *  @return true when found and painted.
+ */
+bool ClookCache::paint( const SlookKey &key, Cgraphics *graphics, int left, int top)
+{
+	if ( graphics ==NULL || Cgraphics::m_defaults.look_cache_size<=0)
+	{
+		return false;
+	}
+	m_lock.lock();
+	std::map<SlookKey, Slook>::iterator it =m_looks.find( key);
+	if ( it ==m_looks.end())
+	{
+		m_lock.unlock();
+		return false;
+	}
+	// Most recent to the front.
+	m_lru.splice( m_lru.begin(), m_lru, it->second.lru);
+	Cpoint offset =graphics->getPixelOffset();
+	graphics->renderTexture( it->second.texture, left+offset.x, top+offset.y, key.width, key.height);
+	m_lock.unlock();
+	return true;
+}
+
+/** @brief Start painting a new look, everything is painted in a texture
+ *         from position 0,0 until end().
+ *  @param key [in] Look to paint.
+ *  @param graphics [in] Graphics to paint with.
+ *  @return false when the look cannot be cached.
+ */
+bool ClookCache::begin( const SlookKey &key, Cgraphics *graphics)
+{
+	int bytes =key.width*key.height*4;
+	if (   graphics ==NULL || m_painting !=NULL
+		|| bytes<=0 || bytes>Cgraphics::m_defaults.look_cache_size/4)
+	{
+		return false;
+	}
+	SDL_Renderer *renderer =graphics->getRenderer();
+	if ( renderer ==NULL)
+	{
+		return false;
+	}
+	m_painting =SDL_CreateTexture( renderer, SDL_PIXELFORMAT_ARGB8888,
+			                       SDL_TEXTUREACCESS_TARGET, key.width, key.height);
+	if ( m_painting ==NULL)
+	{
+		return false;
+	}
+	SDL_SetTextureBlendMode( m_painting, SDL_BLENDMODE_BLEND);
+	// A new target loses viewport and clipping, keep them.
+	m_target =SDL_GetRenderTarget( renderer);
+	SDL_RenderGetViewport( renderer, &m_viewport);
+	SDL_RenderGetClipRect( renderer, &m_clip);
+	m_offset =graphics->getPixelOffset();
+	SDL_SetRenderTarget( renderer, m_painting);
+	SDL_SetRenderDrawColor( renderer, 0,0,0, SDL_ALPHA_TRANSPARENT);
+	SDL_RenderClear( renderer);
+	graphics->setPixelOffset( 0,0);
+	return true;
+}
+
+/** @brief Stop painting a look and store it.
+ *  @param key [in] Look painted since begin().
+ *  @param graphics [in] Graphics used in begin().
+ */
+void ClookCache::end( const SlookKey &key, Cgraphics *graphics)
+{
+	if ( m_painting ==NULL)
+	{
+		return;
+	}
+	SDL_Renderer *renderer =graphics->getRenderer();
+	SDL_SetRenderTarget( renderer, m_target);
+	SDL_RenderSetViewport( renderer, &m_viewport);
+	SDL_RenderSetClipRect( renderer, ( m_clip.w>0 && m_clip.h>0) ? &m_clip:NULL);
+	graphics->setPixelOffset( m_offset.x, m_offset.y);
+
+	Slook look;
+	look.texture =m_painting;
+	m_painting =NULL;
+	int bytes =key.width*key.height*4;
+	m_lock.lock();
+	std::map<SlookKey, Slook>::iterator it =m_looks.find( key);
+	if ( it !=m_looks.end())
+	{
+		m_lock.unlock();
+		SDL_DestroyTexture( look.texture);
+		return;
+	}
+	evict( Cgraphics::m_defaults.look_cache_size-bytes);
+	m_lru.push_front( key);
+	look.lru =m_lru.begin();
+	m_looks[key] =look;
+	m_bytes +=bytes;
+	m_lock.unlock();
+}
+
+/** @brief Remove least recently used looks until we fit in the budget.
+ *  @param budget [in] Maximum bytes in use after eviction.
+ */
+void ClookCache::evict( int budget)
+{
+	while ( m_bytes>budget && !m_lru.empty())
+	{
+		std::map<SlookKey, Slook>::iterator it =m_looks.find( m_lru.back());
+		m_lru.pop_back();
+		if ( it !=m_looks.end())
+		{
+			m_bytes -=it->first.width*it->first.height*4;
+			SDL_DestroyTexture( it->second.texture);
+			m_looks.erase( it);
+		}
+	}
+}
+
+/** @brief Remove all looks, e.g. when the renderer is closed. */
+void ClookCache::clear()
+{
+	m_lock.lock();
+	for ( std::map<SlookKey, Slook>::iterator it =m_looks.begin(); it !=m_looks.end(); ++it)
+	{
+		SDL_DestroyTexture( it->second.texture);
+	}
+	m_looks.clear();
+	m_lru.clear();
+	m_bytes =0;
+	m_lock.unlock();
+}
+#endif
@@ -68,37 +68,35 @@ CmessageBox::CmessageBox( const std::string &name, textId id)
 , m_ok( this, Crect( 0,0, BTN_WIDTH,BTN_HEIGHT), KEY_CR, Cgraphics::m_defaults.icon_ok48)
 , m_cancel( this, Crect( 0,0, BTN_WIDTH,BTN_HEIGHT), KEY_CANCEL, Cgraphics::m_defaults.icon_cancel48)
 {
+	initClose();
 	m_push =true;
 
 	m_text =Cgraphics::m_defaults.get_translation( id, Cgraphics::m_defaults.country);
 	setFlags( MB_TIME2|MB_BEEP);
 	registerMessageBox();
-	if ( m_flags & MB_DARKEN)
-	{
-		m_graphics->darken( 0,0,0,0);
-	}
 
 	if ( !(m_flags & MB_RETURN_IMMEDIATELY))
 	{
 		onExecute( NULL);
 	}
-	else if ( m_in_main_thread ==true)
+	else
 	{
-		m_world->lock();
 		onInit();
-		onClearScreen();
-		onPaintButtons();
-		onPaint();
-		if (m_render_after_paint)
-		{
-			onRender();
-		}
-		onDisplay();
-
-		m_world->unlock();
+		display();
 	}
 }
 
+/** @brief Prepare closing, before anything else in the constructors. */
+void CmessageBox::initClose()
+{
+	m_flags =0;
+	m_modal =false;
+	m_done =NULL;
+	m_context =NULL;
+	pthread_mutex_init( &m_closeMutex, NULL);
+	pthread_cond_init( &m_closed, NULL);
+}
+
 /*============================================================================*/
 ///
 /// @brief 		I am the messagebox and want to register.
@@ -110,9 +108,51 @@ void CmessageBox::registerMessageBox()
 {
 	m_push =true;
 	m_isMessageBox=true;
+#ifdef USE_SDL2
+	if ( !m_graphics)
+	{
+		// Boxes paint on the main screen, see Cworld::paintOverlays().
+		m_graphics =m_world->graphics();
+	}
+#endif
 	m_world->registerMessageBox(this);
 }
 
+/*============================================================================*/
+///
+/// @brief 		Show the box on top of the running dialog and return at once.
+/// The main loop of the dialog below paints and closes the box. Keys do not
+/// reach that dialog until the box is closed.
+///
+/// @param		done [in] Called once after closing, NULL when not needed.
+/// @param		context [in] Passed to done.
+///
+/// @post       Box shown. It is deleted by the world after done returned.
+///
+/*============================================================================*/
+void CmessageBox::open( message_box_result_func done, void *context)
+{
+	m_done =done;
+	m_context =context;
+	m_modal =true;
+	m_selfDestruct =true;
+	m_visible =true;
+	m_running =true;
+	onInit();
+	invalidate();
+	m_world->invalidateAll();
+}
+
+/** @brief Paint the box now, before the caller continues. */
+void CmessageBox::display()
+{
+	if ( m_world->inMainThread())
+	{
+		invalidate();
+		m_world->paintAll();
+	}
+}
+
 /*============================================================================*/
 ///
 /// @brief 		Standard execution for a message box.
@@ -129,6 +169,7 @@ int CmessageBox::onExecute( Cdialog *parent)
 
 	// "begin CmessageBox::onExecute:%s %d", m_name.c_str(), m_in_main_thread);
 	m_running =true;
+	m_in_main_thread =m_world->inMainThread();
 
 	if (onInit() == false)
 	{
@@ -140,32 +181,16 @@ int CmessageBox::onExecute( Cdialog *parent)
 	}
 	m_touchList.clear();
 	startExecute();
+	invalidate();
 
-	while (m_running)
+	while (m_running && m_in_main_thread)
 	{
 		bool no_action =true;
 #ifndef ZHONGCAN_MULTI_THREAD
 		CdialogEvent::Instance()->work();
 #endif
-  		//if (m_invalidate && m_in_main_thread)
-  		if ( m_in_main_thread)
-		{
-			m_world->lock();
-			if ( m_visible)
-			{
-				onClearScreen();
-				onPaintButtons();
-				onPaint();
-				if (m_render_after_paint)
-				{
-					onRender();
-				}
-				m_invalidate =false;
-			}
-			onDisplay();
-			m_invalidate =false;
-			m_world->unlock();
-		}
+		// Only the boxes are painted, the dialog below stays frozen.
+		m_world->paintAll();
 		if ( onLoop() ==false)
 		{
 			m_running =false;
@@ -174,43 +199,38 @@ int CmessageBox::onExecute( Cdialog *parent)
 		{
 			break;
 		}
-		if (m_in_main_thread)
+		EpollStatus poll;
+		while ( m_running ==true && ( poll=CdialogEvent::Instance()->pollEvent( this))!=POLL_EMPTY)
 		{
-			EpollStatus poll;
-			while ( m_running ==true && ( poll=CdialogEvent::Instance()->pollEvent( this))!=POLL_EMPTY)
-			{
-				no_action =false;
-				if ( poll ==POLL_TESTING)
-				{
-					break;
-				}
-			}
-#if 0
-			if ( m_idiot)
-			{
-				no_action =false;
-				createRandomEvent(&m_event);
-				onEvent(&m_event);
-			}
-#endif
-			if ( !m_running)
+			no_action =false;
+			if ( poll ==POLL_TESTING)
 			{
 				break;
 			}
-			if ( m_touchList.update( CdialogEvent::Instance()->pressMouse(), CdialogEvent::Instance()->lastMouse()))
-			{
-				invalidate();
-			}
-			if ( no_action==true)
-			{
-				delay(10);
-			}
 		}
-		else
+		if ( !m_running)
+		{
+			break;
+		}
+		if ( m_touchList.update( CdialogEvent::Instance()->pressMouse(), CdialogEvent::Instance()->lastMouse()))
+		{
+			invalidate();
+		}
+		if ( no_action==true)
 		{
-			delay(100);
+			m_world->waitEvent( this);
 		}
 	}
+	if ( !m_in_main_thread)
+	{
+		// The main loop paints the box and closes it.
+		pthread_mutex_lock( &m_closeMutex);
+		while ( m_running)
+		{
+			pthread_cond_wait( &m_closed, &m_closeMutex);
+		}
+		pthread_mutex_unlock( &m_closeMutex);
+	}
 	stopExecute();
 	// "Cdialog::onExecute onCleanUp");
 	onCleanup();
@@ -220,15 +240,10 @@ int CmessageBox::onExecute( Cdialog *parent)
 		if (d) d->onCleanup();
 	}
 	// ("end Cdialog::onExecute:%s %d", m_name.c_str(), m_exitValue);
-	delay(50);
 	if ( m_selfDestruct)
 	{
 		m_alive =false;
 	}
-	//if ( parent !=NULL)
-	//{
-	//	dlgLock();
-	//}
 
 	return m_exitValue;
 }
@@ -239,8 +254,24 @@ int CmessageBox::onExecute( Cdialog *parent)
 void CmessageBox::stop(int exitValue)
 {
 	// ( "Stop message box %s exit=%d", m_name.c_str(), exitValue);
-	m_exitValue=exitValue;
+	close( exitValue);
+}
+
+/** @brief Hide the box, end onExecute() or the opened box.
+ *  @param exitValue [in] Result for the caller.
+ */
+void CmessageBox::close( int exitValue)
+{
+	pthread_mutex_lock( &m_closeMutex);
+	m_exitValue =exitValue;
+	m_visible =false;
+	if ( m_selfDestruct)
+	{
+		m_alive =false;
+	}
 	m_running =false;
+	pthread_cond_broadcast( &m_closed);
+	pthread_mutex_unlock( &m_closeMutex);
 	invalidate();
 }
 
@@ -315,30 +346,14 @@ CmessageBox::CmessageBox( const std::string &name, int x, int y, int w, int h,
 , m_ok( this, Crect( 0,0, BTN_WIDTH,BTN_HEIGHT), KEY_CR, Cgraphics::m_defaults.icon_ok48)
 , m_cancel( this, Crect( 0,0, BTN_WIDTH,BTN_HEIGHT), KEY_CANCEL, Cgraphics::m_defaults.icon_cancel48)
 {
+	initClose();
 	m_text =Text;
 	setFlags(FLAGS);
 	registerMessageBox();
-	if ( m_flags & MB_DARKEN)
-	{
-
-		graphics()->darken(0,0,0,0);
-	}
 	onInit();
 	if ( m_flags & MB_DISPLAY_IMMEDIATELY)
 	{
-		m_world->lock();
-
-		onInit();
-		onClearScreen();
-		onPaintButtons();
-		onPaint();
-		if (m_render_after_paint)
-		{
-			onRender();
-		}
-		onDisplay();
-
-		m_world->unlock();
+		display();
 	}
 	if ( !(m_flags & (MB_SELF_DESTRUCT | MB_RETURN_IMMEDIATELY)))
 	{
@@ -364,30 +379,15 @@ CmessageBox::CmessageBox(  const std::string &name, int x, int y, int w, int h,
 , m_ok( this, Crect( 0,0,Cgraphics::m_defaults.button_height+2,Cgraphics::m_defaults.button_height), KEY_CR, Cgraphics::m_defaults.icon_ok48)
 , m_cancel( this, Crect( 0,0, BTN_WIDTH,BTN_HEIGHT), KEY_CANCEL, Cgraphics::m_defaults.icon_cancel48)
 {
+	initClose();
 	m_text =Cgraphics::m_defaults.get_translation( id, Cgraphics::m_defaults.country);
 	setFlags(FLAGS);
 	registerMessageBox();
-	if ( m_flags & MB_DARKEN)
-	{
-		graphics()->darken( 0,0, Cgraphics::m_defaults.width, Cgraphics::m_defaults.height);
-	}
 	onInit();
 
 	if ( m_flags & MB_DISPLAY_IMMEDIATELY)
 	{
-		m_world->lock();
-
-		onInit();
-		onClearScreen();
-		onPaintButtons();
-		onPaint();
-		if (m_render_after_paint)
-		{
-			onRender();
-		}
-		onDisplay();
-
-		m_world->unlock();
+		display();
 	}
 
 	if ( !(m_flags & MB_RETURN_IMMEDIATELY))
@@ -409,26 +409,14 @@ CmessageBox::CmessageBox( const std::string &name, const Crect &xx, textId id, i
 , m_ok( this, Crect( 0,0, BTN_WIDTH,BTN_HEIGHT), KEY_CR, Cgraphics::m_defaults.icon_ok48)
 , m_cancel( this, Crect( 0,0, BTN_WIDTH,BTN_HEIGHT), KEY_CANCEL, Cgraphics::m_defaults.icon_cancel48)
 {
+	initClose();
 	m_text =Cgraphics::m_defaults.get_translation( id, Cgraphics::m_defaults.country);
 	setFlags(FLAGS);
 	registerMessageBox();
-	if ( m_flags & MB_DARKEN)
-	{
-		m_graphics->darken( 0,0,0,0);
-	}
 	if ( m_flags & MB_DISPLAY_IMMEDIATELY)
 	{
-		m_world->lock();
 		onInit();
-		onClearScreen();
-		onPaintButtons();
-		onPaint();
-		if (m_render_after_paint)
-		{
-			onRender();
-		}
-		onDisplay();
-		m_world->unlock();
+		display();
 	}
 
 	if ( !(m_flags & MB_RETURN_IMMEDIATELY))
@@ -453,26 +441,8 @@ CmessageBox::CmessageBox( const std::string &name) :
 {
 	// TODO Auto-generated constructor stub
 	//pushScreen();
+	initClose();
 	registerMessageBox();
-
-	if ( m_flags & MB_DISPLAY_IMMEDIATELY)
-	{
-		m_world->lock(); // Dialog list should not change.
-		onInit();
-		CdialogEvent::Instance()->lock();
-
-		onClearScreen();
-		onPaintButtons();
-		onPaint();
-		if (m_render_after_paint)
-		{
-			onRender();
-		}
-		onDisplay();
-
-		CdialogEvent::Instance()->unlock();
-		m_world->unlock();
-	}
 }
 
 CmessageBox::~CmessageBox()
@@ -483,6 +453,8 @@ CmessageBox::~CmessageBox()
 		m_world->unregisterMessageBox(this);
 		m_push =false;
 	}
+	pthread_cond_destroy( &m_closed);
+	pthread_mutex_destroy( &m_closeMutex);
 	//("end CmessageBox::~CmessageBox");
 }
 
@@ -535,8 +507,13 @@ void CmessageBox::onUpdate()
  */
 void CmessageBox::onClearScreen()
 {
+	if ( m_flags & MB_DARKEN)
+	{
+		// The frozen screen below is restored before every paint.
+		graphics()->darken( 0,0,0,0);
+	}
 	graphics()->darken( 8*(m_rect.left()+2), 8*(m_rect.top()+2),
-			             8*m_rect.width(), 8*m_rect.height());
+			             8*(m_rect.right()+2), 8*(m_rect.bottom()+2));
     Cbackground( NULL, m_rect, KEY_NONE, Cgraphics::m_defaults.messagebox_background2,
     		     0, FILL_GRADIENT, Cgraphics::m_defaults.messagebox_background1).onPaint(0);
     Egravity gravity =(m_flags&MB_TEXT_CENTER) ? GRAVITY_CENTER:GRAVITY_LEFT;
@@ -604,7 +581,7 @@ Estatus CmessageBox::onButton( keymode mod, keybutton sym)
 	Ctimestamp d;
 	if (!( m_flags & MB_STYLE) )
 	{
-		return DIALOG_EVENT_OPEN;
+		return m_modal ? DIALOG_EVENT_PROCESSED:DIALOG_EVENT_OPEN;
 	}
 	if ( sym==KEY_NONE)
 	{
@@ -615,28 +592,14 @@ Estatus CmessageBox::onButton( keymode mod, keybutton sym)
 	switch (sym)
 	{
 	case KEY_ESCAPE:
-
-		m_visible =false;
-		invalidate();
-		if ( m_selfDestruct)
-		{
-			m_alive =false;
-		}
-		m_running =false;
-		//stop(0);
+		close( MB_QUIT);
 		break;
 	case KEY_CR:
-		m_visible =false;
-		invalidate();
-		if ( m_selfDestruct)
-		{
-			m_alive =false;
-		}
-		m_running =false;
-		//stop(0);
+		close( MB_OK);
 		break;
 	default:
-		return DIALOG_EVENT_OPEN;
+		// A modal box keeps the keys from the frozen dialog.
+		return m_modal ? DIALOG_EVENT_PROCESSED:DIALOG_EVENT_OPEN;
 	}
 	return DIALOG_EVENT_PROCESSED;
 }
@@ -650,20 +613,21 @@ bool CmessageBox::onLoop()
 	{
 		if ( m_timer.expired() && ( m_visible==true || m_running==true) )
 		{
-			m_visible =false;
-			m_running =false;
-			invalidate();
+			close( MB_READY);
 		}
 	}
 	return m_alive;
 }
 
-/** @brief Exit function for the dialog */
+/** @brief Exit function for the dialog, the world calls it before deleting an opened box. */
 void CmessageBox::onExit()
 {
-	if (m_flags & MB_RETURN)
+	message_box_result_func done =m_done;
+	m_done =NULL;
+	if ( done)
 	{
-
+		// May open the next box, it is shown on the same frozen screen.
+		done( this, m_exitValue, m_context);
 	}
 }
 
@@ -0,0 +1,288 @@
+/*============================================================================*/
+/**  @file       sdl_profiler.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Frame profiler.
+ **
+ **  Every thread writes its scopes in its own ring, without locks. The main
+ **  thread summarizes each frame for the overlay, dump() writes all rings in
+ **  the Chrome trace_event format.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              Cprofiler
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include "sdl_profiler.h"
+#include "sdl_keybutton.h"
+
+#ifdef USE_PROFILER
+
+/// @brief Scopes of one thread, only that thread writes.
+class CprofileRing
+{
+public:
+	CprofileRing( int id) : m_scopes( PROFILE_RING), m_count( 0), m_id( id), m_main( false) {}
+
+public:
+	std::vector<SprofileScope> m_scopes; ///< Index is the scope number modulo PROFILE_RING.
+	std::atomic<unsigned int> m_count; ///< Scopes written, also the next number.
+	int		m_id;		///< Thread number in the trace.
+	bool	m_main;		///< Thread that marks the frames.
+};
+
+/// Ring of the running thread, made on its first scope.
+static thread_local CprofileRing *s_ring =NULL;
+
+Cprofiler::Cprofiler()
+: m_start( now())
+, m_lastFrame( 0)
+, m_frameFirst( 0)
+, m_frames( PROFILE_FRAMES, 0)
+, m_frameCount( 0)
+{
+	m_top.reserve( PROFILE_TOP+1);
+}
+
+Cprofiler::~Cprofiler()
+{
+	for ( auto ring : m_rings)
+	{
+		delete ring;
+	}
+}
+
+/** @brief Monotonic time, not disturbed by clock changes.
+ *  @return Time in usec.
+ */
+uint64_t Cprofiler::now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+/** @brief Find the ring of the running thread.
+ *  @return Ring, made and added to the list the first time.
+ */
+CprofileRing *Cprofiler::threadRing()
+{
+	if ( s_ring ==NULL)
+	{
+		m_lock.lock();
+		s_ring =new CprofileRing( (int)m_rings.size()+1);
+		m_rings.push_back( s_ring);
+		m_lock.unlock();
+	}
+	return s_ring;
+}
+
+/** @brief Store a finished scope.
+ *  @param kind [in] What is measured.
+ *  @param name [in] Static text.
+ *  @param object [in] Painted object or NULL.
+ *  @param key [in] Key of the object.
+ *  @param start [in] Usec at the start.
+ *  @param end [in] Usec at the end.
+ */
+void Cprofiler::add( EprofileKind kind, const char *name, const void *object, int key,
+					 uint64_t start, uint64_t end)
+{
+	CprofileRing *ring =threadRing();
+	unsigned int n =ring->m_count.load( std::memory_order_relaxed);
+	SprofileScope &s =ring->m_scopes[n%PROFILE_RING];
+	s.name =name;
+	s.object =object;
+	s.key =key;
+	s.kind =kind;
+	s.start =start;
+	s.duration =(uint32_t)(end-start);
+	// dump() reads the scope only after it sees the new count.
+	ring->m_count.store( n+1, std::memory_order_release);
+}
+
+/** @brief End the running frame, keep its busy time and slowest objects.
+ *  Call from the main thread only, the rings of other threads are not read.
+ */
+void Cprofiler::frame()
+{
+	uint64_t t =now();
+	CprofileRing *ring =threadRing();
+	ring->m_main =true;
+	unsigned int last =ring->m_count.load( std::memory_order_relaxed);
+	unsigned int first =m_frameFirst;
+	if ( last-first>PROFILE_RING)
+	{
+		first =last-PROFILE_RING;
+	}
+	uint64_t idle =0;
+	m_top.clear();
+	for ( unsigned int n=first; n!=last; n++)
+	{
+		const SprofileScope &s =ring->m_scopes[n%PROFILE_RING];
+		switch ( s.kind)
+		{
+		case PROFILE_KIND_IDLE:
+			idle +=s.duration;
+			break;
+		case PROFILE_KIND_OBJECT:
+		{
+			// Insert sorted, slowest first.
+			int a =(int)m_top.size();
+			while ( a>0 && m_top[a-1].duration<s.duration)
+			{
+				a--;
+			}
+			if ( a<PROFILE_TOP)
+			{
+				m_top.insert( m_top.begin()+a, s);
+				if ( m_top.size()>PROFILE_TOP)
+				{
+					m_top.pop_back();
+				}
+			}
+			break;
+		}
+		case PROFILE_KIND_SCOPE:
+			break;
+		}
+	}
+	if ( m_lastFrame)
+	{
+		uint64_t busy =t-m_lastFrame;
+		busy =( busy>idle) ? busy-idle:0;
+		m_frames[m_frameCount%PROFILE_FRAMES] =(uint32_t)busy;
+		m_frameCount++;
+	}
+	m_lastFrame =t;
+	m_frameFirst =last;
+}
+
+/** @brief Number of frames in the histogram.
+ *  @return At most PROFILE_FRAMES.
+ */
+int Cprofiler::frames()
+{
+	return ( m_frameCount<PROFILE_FRAMES) ? m_frameCount:PROFILE_FRAMES;
+}
+
+/** @brief Busy time of a frame, the time waiting for input is not counted.
+ *  @param age [in] 0 for the last frame, 1 for the one before etc.
+ *  @return Time in usec.
+ */
+uint32_t Cprofiler::frameTime( int age)
+{
+	if ( age<0 || age>=frames())
+	{
+		return 0;
+	}
+	return m_frames[(m_frameCount-1-age)%PROFILE_FRAMES];
+}
+
+/** @brief Readable class name of a type_info name.
+ *  @param name [in] Name from typeid, e.g. "7Cbutton".
+ *  @return Name without length, e.g. "Cbutton".
+ */
+const char *Cprofiler::className( const char *name)
+{
+	while ( *name>='0' && *name<='9')
+	{
+		name++;
+	}
+	return name;
+}
+
+/** @brief Write all scopes of all threads, for chrome://tracing or Perfetto.
+ *  Threads may keep running, scopes they overwrite meanwhile are skipped.
+ *  @param fname [in] File to write.
+ *  @return true on success.
+ */
+bool Cprofiler::dump( const std::string &fname)
+{
+	FILE *f =fopen( fname.c_str(), "w");
+	if ( f ==NULL)
+	{
+		return false;
+	}
+	m_lock.lock();
+	std::vector<CprofileRing*> rings( m_rings);
+	m_lock.unlock();
+
+	std::vector<SprofileScope> scopes;
+	fprintf( f, "{\"traceEvents\":[");
+	const char *separator ="\n";
+	for ( auto ring : rings)
+	{
+		fprintf( f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+				    "\"args\":{\"name\":\"%s%d\"}}",
+				 separator, ring->m_id, ring->m_main ? "main ":"thread ", ring->m_id);
+		separator =",\n";
+
+		unsigned int last =ring->m_count.load( std::memory_order_acquire);
+		unsigned int first =( last>PROFILE_RING) ? last-PROFILE_RING:0;
+		scopes.clear();
+		for ( unsigned int n=first; n!=last; n++)
+		{
+			scopes.push_back( ring->m_scopes[n%PROFILE_RING]);
+		}
+		// Scopes written during the copy may have replaced the oldest ones.
+		unsigned int written =ring->m_count.load( std::memory_order_acquire);
+		unsigned int skip =( written+1-first>PROFILE_RING) ? written+1-first-PROFILE_RING:0;
+		for ( unsigned int n=skip; n<scopes.size(); n++)
+		{
+			const SprofileScope &s =scopes[n];
+			unsigned long long ts =( s.start>m_start) ? s.start-m_start:0;
+			switch ( s.kind)
+			{
+			case PROFILE_KIND_OBJECT:
+				fprintf( f, ",\n{\"name\":\"%s\",\"cat\":\"object\",\"ph\":\"X\",\"ts\":%llu,"
+						    "\"dur\":%u,\"pid\":1,\"tid\":%d,\"args\":{\"key\":\"%s\"}}",
+						 className( s.name), ts, s.duration, ring->m_id,
+						 ((std::string)Ckeybutton( (keybutton)s.key)).c_str());
+				break;
+			case PROFILE_KIND_IDLE:
+			case PROFILE_KIND_SCOPE:
+				fprintf( f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,"
+						    "\"dur\":%u,\"pid\":1,\"tid\":%d}",
+						 s.name, ( s.kind==PROFILE_KIND_IDLE) ? "idle":"work",
+						 ts, s.duration, ring->m_id);
+				break;
+			}
+		}
+	}
+	fprintf( f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	bool ok =( ferror( f) ==0);
+	fclose( f);
+	return ok;
+}
+
+#endif
@@ -89,7 +89,7 @@ void CprogressBar::onPaint( int touch)
 	//m_todoTime =((m_maximum-m_minimum)-m_value)/m_speed;
 	char t[32];
 	sprintf(t, "%d", m_todoTime);
-	Crect r( (m_rect.left()+m_rect.right())/2-4, m_rect.bottom(), 8,4);
+	Crect r( timeRect());
 	Cbutton btn( NULL, r, KEY_NOCHANGE, CtextFont(""),
 			     t, BORDER_NONE, GRAVITY_BOTTOM_CENTER, 4, FILL_UNICOLOURED);
 	btn.setColours(0,0xcccccc,0xcccccc);
@@ -99,6 +99,7 @@ void CprogressBar::onPaint( int touch)
 void CprogressBar::setValue(double y)
 {
 	int n =m_timer.elapsed();
+	int todo =m_todoTime;
 	Cslider::setValue(y);
 	m_todoTime =(int)(m_maximum+1);
 	if (n!=0)
@@ -109,6 +110,18 @@ void CprogressBar::setValue(double y)
 			m_todoTime =(int)(((m_maximum-m_minimum)-y)/m_speed);
 		}
 	}
+	if ( m_todoTime !=todo)
+	{
+		invalidate( timeRect());
+	}
+}
+
+/** @brief Where the time left is painted, below the bar.
+ *  @return Rectangle in touch squares.
+ */
+Crect CprogressBar::timeRect()
+{
+	return Crect( (m_rect.left()+m_rect.right())/2-4, m_rect.bottom(), 8,4);
 }
 
 void CprogressBar::start()
@@ -0,0 +1,482 @@
+/*============================================================================*/
+/**  @file       sdl_raster.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Software fill of rounded backgrounds.
+ **
+ **  Every kernel fills one span of a row. The scalar version is the
+ **  reference, the SSE2 and AVX2 versions give the same pixels.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              Craster
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include <math.h>
+#include "sdl_raster.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RASTER_X86
+#define TARGET_SSE2	__attribute__((target("sse2")))
+#define TARGET_AVX2	__attribute__((target("avx2")))
+#endif
+
+ErasterLevel Craster::m_level =RASTER_BEST;
+
+/*------------- Scalar kernels -----------------------------------------------*/
+
+/** @brief Fill a span with one colour. */
+static void spanScalar( Uint32 *row, int left, int right, Uint32 col)
+{
+	for ( int x=left; x<right; x++)
+	{
+		row[x] =col;
+	}
+}
+
+/** @brief Colour with alpha falling off from the centre.
+ *  @param cx [in] Centre of the circle.
+ *  @param dy2 [in] Squared vertical distance to the centre.
+ *  @param scale [in] 1/maximum distance.
+ *  @param rgb [in] Colour without alpha.
+ */
+static void circularScalar( Uint32 *row, int left, int right,
+		                    float cx, float dy2, float scale, Uint32 rgb)
+{
+	for ( int x=left; x<right; x++)
+	{
+		float dx =(float)x-cx;
+		float alpha =1.0f-sqrtf( dx*dx+dy2)*scale;
+		alpha =gLimit( alpha, 0.0f, 1.0f);
+		row[x] =((Uint32)(alpha*255.0f) << 24) | rgb;
+	}
+}
+
+/** @brief Two colours split on an angle, see Cbackground::pieColour.
+ *  The angle is clockwise from the top. A pixel gets the first colour when
+ *  it is on the left side of the split (cross product) and, for a split
+ *  after half a turn, also in the left half of the pie.
+ *  @param cx [in] Centre of the pie.
+ *  @param up [in] Distance above the centre.
+ *  @param cosCorner [in] Cosine of the split.
+ *  @param sinCorner [in] Sine of the split.
+ *  @param wide [in] Split is at half a turn or more.
+ */
+static void pieScalar( Uint32 *row, int left, int right, float cx, float up,
+		               float cosCorner, float sinCorner, bool wide, Uint32 col1, Uint32 col2)
+{
+	float offset =sinCorner*up;
+	for ( int x=left; x<right; x++)
+	{
+		float dx =(float)x-cx;
+		bool after =( cosCorner*dx-offset>=0.0f);
+		bool lower =( up<0.0f) ? dx<=0.0f : dx<0.0f;
+		bool first =wide ? (after && lower):(after || lower);
+		row[x] =first ? col1:col2;
+	}
+}
+
+#ifdef RASTER_X86
+/*------------- SSE2 kernels -------------------------------------------------*/
+
+TARGET_SSE2
+static void spanSse2( Uint32 *row, int left, int right, Uint32 col)
+{
+	__m128i c =_mm_set1_epi32( (int)col);
+	int x =left;
+	for ( ; x+4<=right; x+=4)
+	{
+		_mm_storeu_si128( (__m128i*)(row+x), c);
+	}
+	spanScalar( row, x, right, col);
+}
+
+TARGET_SSE2
+static void circularSse2( Uint32 *row, int left, int right,
+		                  float cx, float dy2, float scale, Uint32 rgb)
+{
+	__m128 step =_mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f);
+	__m128 vcx =_mm_set1_ps( cx);
+	__m128 vdy2 =_mm_set1_ps( dy2);
+	__m128 vscale =_mm_set1_ps( scale);
+	__m128 one =_mm_set1_ps( 1.0f);
+	__m128 zero =_mm_setzero_ps();
+	__m128 full =_mm_set1_ps( 255.0f);
+	__m128i vrgb =_mm_set1_epi32( (int)rgb);
+	int x =left;
+	for ( ; x+4<=right; x+=4)
+	{
+		__m128 dx =_mm_sub_ps( _mm_add_ps( _mm_set1_ps( (float)x), step), vcx);
+		__m128 d =_mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( dx,dx), vdy2));
+		__m128 alpha =_mm_sub_ps( one, _mm_mul_ps( d, vscale));
+		alpha =_mm_min_ps( _mm_max_ps( alpha, zero), one);
+		__m128i a =_mm_cvttps_epi32( _mm_mul_ps( alpha, full));
+		_mm_storeu_si128( (__m128i*)(row+x), _mm_or_si128( _mm_slli_epi32( a, 24), vrgb));
+	}
+	circularScalar( row, x, right, cx, dy2, scale, rgb);
+}
+
+TARGET_SSE2
+static void pieSse2( Uint32 *row, int left, int right, float cx, float up,
+		             float cosCorner, float sinCorner, bool wide, Uint32 col1, Uint32 col2)
+{
+	__m128 step =_mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f);
+	__m128 vcx =_mm_set1_ps( cx);
+	__m128 vcos =_mm_set1_ps( cosCorner);
+	__m128 offset =_mm_set1_ps( sinCorner*up);
+	__m128 zero =_mm_setzero_ps();
+	__m128i c1 =_mm_set1_epi32( (int)col1);
+	__m128i c2 =_mm_set1_epi32( (int)col2);
+	int x =left;
+	for ( ; x+4<=right; x+=4)
+	{
+		__m128 dx =_mm_sub_ps( _mm_add_ps( _mm_set1_ps( (float)x), step), vcx);
+		__m128 after =_mm_cmpge_ps( _mm_sub_ps( _mm_mul_ps( vcos, dx), offset), zero);
+		__m128 lower =( up<0.0f) ? _mm_cmple_ps( dx, zero) : _mm_cmplt_ps( dx, zero);
+		__m128 first =wide ? _mm_and_ps( after, lower) : _mm_or_ps( after, lower);
+		__m128i mask =_mm_castps_si128( first);
+		_mm_storeu_si128( (__m128i*)(row+x),
+				_mm_or_si128( _mm_and_si128( mask, c1), _mm_andnot_si128( mask, c2)));
+	}
+	pieScalar( row, x, right, cx, up, cosCorner, sinCorner, wide, col1, col2);
+}
+
+/*------------- AVX2 kernels -------------------------------------------------*/
+
+TARGET_AVX2
+static void spanAvx2( Uint32 *row, int left, int right, Uint32 col)
+{
+	__m256i c =_mm256_set1_epi32( (int)col);
+	int x =left;
+	for ( ; x+8<=right; x+=8)
+	{
+		_mm256_storeu_si256( (__m256i*)(row+x), c);
+	}
+	spanScalar( row, x, right, col);
+}
+
+TARGET_AVX2
+static void circularAvx2( Uint32 *row, int left, int right,
+		                  float cx, float dy2, float scale, Uint32 rgb)
+{
+	__m256 step =_mm256_set_ps( 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+	__m256 vcx =_mm256_set1_ps( cx);
+	__m256 vdy2 =_mm256_set1_ps( dy2);
+	__m256 vscale =_mm256_set1_ps( scale);
+	__m256 one =_mm256_set1_ps( 1.0f);
+	__m256 zero =_mm256_setzero_ps();
+	__m256 full =_mm256_set1_ps( 255.0f);
+	__m256i vrgb =_mm256_set1_epi32( (int)rgb);
+	int x =left;
+	for ( ; x+8<=right; x+=8)
+	{
+		__m256 dx =_mm256_sub_ps( _mm256_add_ps( _mm256_set1_ps( (float)x), step), vcx);
+		__m256 d =_mm256_sqrt_ps( _mm256_add_ps( _mm256_mul_ps( dx,dx), vdy2));
+		__m256 alpha =_mm256_sub_ps( one, _mm256_mul_ps( d, vscale));
+		alpha =_mm256_min_ps( _mm256_max_ps( alpha, zero), one);
+		__m256i a =_mm256_cvttps_epi32( _mm256_mul_ps( alpha, full));
+		_mm256_storeu_si256( (__m256i*)(row+x), _mm256_or_si256( _mm256_slli_epi32( a, 24), vrgb));
+	}
+	circularScalar( row, x, right, cx, dy2, scale, rgb);
+}
+
+TARGET_AVX2
+static void pieAvx2( Uint32 *row, int left, int right, float cx, float up,
+		             float cosCorner, float sinCorner, bool wide, Uint32 col1, Uint32 col2)
+{
+	__m256 step =_mm256_set_ps( 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+	__m256 vcx =_mm256_set1_ps( cx);
+	__m256 vcos =_mm256_set1_ps( cosCorner);
+	__m256 offset =_mm256_set1_ps( sinCorner*up);
+	__m256 zero =_mm256_setzero_ps();
+	__m256i c1 =_mm256_set1_epi32( (int)col1);
+	__m256i c2 =_mm256_set1_epi32( (int)col2);
+	int x =left;
+	for ( ; x+8<=right; x+=8)
+	{
+		__m256 dx =_mm256_sub_ps( _mm256_add_ps( _mm256_set1_ps( (float)x), step), vcx);
+		__m256 after =_mm256_cmp_ps( _mm256_sub_ps( _mm256_mul_ps( vcos, dx), offset), zero, _CMP_GE_OQ);
+		__m256 lower =( up<0.0f) ? _mm256_cmp_ps( dx, zero, _CMP_LE_OQ) : _mm256_cmp_ps( dx, zero, _CMP_LT_OQ);
+		__m256 first =wide ? _mm256_and_ps( after, lower) : _mm256_or_ps( after, lower);
+		_mm256_storeu_si256( (__m256i*)(row+x), _mm256_blendv_epi8( c2, c1, _mm256_castps_si256( first)));
+	}
+	pieScalar( row, x, right, cx, up, cosCorner, sinCorner, wide, col1, col2);
+}
+#endif
+
+/*------------- Craster ------------------------------------------------------*/
+
+/** @brief Constructor, empty buffer. */
+Craster::Craster()
+: m_width(0)
+, m_height(0)
+, m_radius(0)
+, m_graphics(NULL)
+, m_handle(INVALID_TEXTURE_HANDLE)
+{
+}
+
+/** @brief Destructor. */
+Craster::~Craster()
+{
+	releaseHandle();
+}
+
+/** @brief Give the texture back to the graphics. */
+void Craster::releaseHandle()
+{
+#ifdef USE_SDL2
+	if ( m_graphics)
+	{
+		m_graphics->releaseHandle( m_handle);
+	}
+#endif
+	m_graphics =NULL;
+	m_handle =INVALID_TEXTURE_HANDLE;
+}
+
+/** @brief Change the size, keeps the memory when nothing changed.
+ *  @param width [in] Width in pixels.
+ *  @param height [in] Height in pixels.
+ *  @param radius [in] Corner radius in pixels.
+ */
+void Craster::setSize( int width, int height, int radius)
+{
+	width =gMax( width, 0);
+	height =gMax( height, 0);
+	if ( width ==m_width && height ==m_height && radius ==m_radius)
+	{
+		return;
+	}
+	m_width =width;
+	m_height =height;
+	m_radius =radius;
+	m_pixels.resize( width*height);
+	m_inset.assign( height, 0);
+	// Same corners as the line by line painting in Cbackground.
+	for ( int y=0; y<=radius && y<height; y++)
+	{
+		int v=(int)( sqrt( (double)(radius*radius-(radius-y)*(radius-y))+0.5) );
+		v =gLimit( radius-v, 0, width/2);
+		m_inset[y] =v;
+		m_inset[height-1-y] =v;
+	}
+}
+
+/** @brief Make the corners of a row transparent.
+ *  @param y [in] Row.
+ */
+void Craster::clearRow( int y)
+{
+	Uint32 *row =&m_pixels[y*m_width];
+	int inset =m_inset[y];
+	for ( int x=0; x<inset; x++)
+	{
+		row[x] =0;
+		row[m_width-1-x] =0;
+	}
+}
+
+/** @brief Fill every row with its own colour, for gradients.
+ *  @param rowColours [in] RGB colour per row.
+ */
+void Craster::fillRows( const std::vector<Uint32> &rowColours)
+{
+	ErasterLevel lvl =level();
+	for ( int y=0; y<m_height && y<(int)rowColours.size(); y++)
+	{
+		Uint32 *row =&m_pixels[y*m_width];
+		Uint32 col =rowColours[y] | 0xFF000000;
+		int left =m_inset[y];
+		int right =m_width-m_inset[y];
+		clearRow( y);
+		switch ( lvl)
+		{
+#ifdef RASTER_X86
+		case RASTER_AVX2: spanAvx2( row, left, right, col); break;
+		case RASTER_SSE2: spanSse2( row, left, right, col); break;
+#endif
+		default: spanScalar( row, left, right, col); break;
+		}
+	}
+}
+
+/** @brief Colour in the middle, fading to transparent at the outside.
+ *  @param col [in] Colour in the middle.
+ *  @param maxDistance [in] Distance in pixels where the colour is gone.
+ */
+void Craster::fillCircular( colour col, double maxDistance)
+{
+	ErasterLevel lvl =level();
+	float cx =(float)((m_width-1)/2);
+	float cy =(float)((m_height-1)/2);
+	float scale =( maxDistance>0.0) ? (float)(1.0/maxDistance):0.0f;
+	Uint32 rgb =(Uint32)col & 0x00FFFFFF;
+	for ( int y=0; y<m_height; y++)
+	{
+		Uint32 *row =&m_pixels[y*m_width];
+		float dy2 =((float)y-cy)*((float)y-cy);
+		int left =m_inset[y];
+		int right =m_width-m_inset[y];
+		clearRow( y);
+		switch ( lvl)
+		{
+#ifdef RASTER_X86
+		case RASTER_AVX2: circularAvx2( row, left, right, cx, dy2, scale, rgb); break;
+		case RASTER_SSE2: circularSse2( row, left, right, cx, dy2, scale, rgb); break;
+#endif
+		default: circularScalar( row, left, right, cx, dy2, scale, rgb); break;
+		}
+	}
+}
+
+/** @brief Two colours, the first one clockwise from a corner to the top.
+ *  @param col1 [in] Colour after the corner.
+ *  @param col2 [in] Colour before the corner.
+ *  @param corner [in] Corner in radians, clockwise from the top.
+ */
+void Craster::fillPie( colour col1, colour col2, double corner)
+{
+	ErasterLevel lvl =level();
+	float cx =(float)((m_width-1)/2);
+	float cy =(float)((m_height-1)/2);
+	float cosCorner =(float)cos( corner);
+	float sinCorner =(float)sin( corner);
+	bool wide =( corner>=M_PI);
+	Uint32 c1 =(Uint32)col1 | 0xFF000000;
+	Uint32 c2 =(Uint32)col2 | 0xFF000000;
+	for ( int y=0; y<m_height; y++)
+	{
+		Uint32 *row =&m_pixels[y*m_width];
+		float up =cy-(float)y;
+		int left =m_inset[y];
+		int right =m_width-m_inset[y];
+		clearRow( y);
+		switch ( lvl)
+		{
+#ifdef RASTER_X86
+		case RASTER_AVX2: pieAvx2( row, left, right, cx, up, cosCorner, sinCorner, wide, c1, c2); break;
+		case RASTER_SSE2: pieSse2( row, left, right, cx, up, cosCorner, sinCorner, wide, c1, c2); break;
+#endif
+		default: pieScalar( row, left, right, cx, up, cosCorner, sinCorner, wide, c1, c2); break;
+		}
+	}
+	// The centre itself has angle 0.
+	int centre =(int)cy*m_width+(int)cx;
+	if ( centre<(int)m_pixels.size() && (int)cx>=m_inset[(int)cy])
+	{
+		m_pixels[centre] =( corner<=0.0) ? c1:c2;
+	}
+}
+
+/** @brief Copy the buffer to the screen.
+ *  @param graphics [in] Where to paint.
+ *  @param x [in] Left position in pixels.
+ *  @param y [in] Top position in pixels.
+ *  @return true on success.
+ */
+bool Craster::paint( Cgraphics *graphics, int x, int y)
+{
+	if ( graphics ==NULL || m_width ==0 || m_height ==0)
+	{
+		return false;
+	}
+	SDL_Surface *surface =SDL_CreateRGBSurfaceFrom( &m_pixels[0], m_width, m_height, 32, m_width*4,
+			                                        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+	if ( surface ==NULL)
+	{
+		return false;
+	}
+#ifdef USE_SDL2
+	// Keep the texture, the next fill is streamed into the same one.
+	// The pool takes it back when this raster is not painted for a while.
+	if ( graphics !=m_graphics)
+	{
+		releaseHandle();
+		m_graphics =graphics;
+	}
+	m_handle =graphics->uploadSurface( surface, m_handle);
+	Cpoint offset =graphics->getPixelOffset();
+	bool retVal =graphics->renderHandle( m_handle, x+offset.x, y+offset.y, m_width, m_height);
+#else
+	bool retVal =graphics->renderSurface( surface, x, y, m_width, m_height);
+#endif
+	SDL_FreeSurface( surface);
+	return retVal;
+}
+
+/** @brief Kernels in use. */
+ErasterLevel Craster::level()
+{
+	if ( m_level ==RASTER_BEST)
+	{
+		m_level =bestLevel();
+	}
+	return m_level;
+}
+
+/** @brief Best kernels for this processor. */
+ErasterLevel Craster::bestLevel()
+{
+#ifdef RASTER_X86
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports( "avx2"))
+	{
+		return RASTER_AVX2;
+	}
+	if ( __builtin_cpu_supports( "sse2"))
+	{
+		return RASTER_SSE2;
+	}
+#endif
+	return RASTER_SCALAR;
+}
+
+/** @brief Choose other kernels, e.g. to compare speed. A level the processor
+ *         does not have falls back to the best one.
+ *  @param level [in] Kernels to use.
+ */
+void Craster::setLevel( ErasterLevel level)
+{
+	ErasterLevel best =bestLevel();
+	m_level =( level>best) ? best:level;
+}
+
+/** @brief Name of the kernels for logging. */
+const char *Craster::levelName( ErasterLevel level)
+{
+	switch ( level)
+	{
+	case RASTER_SCALAR: return "scalar";
+	case RASTER_SSE2: return "sse2";
+	case RASTER_AVX2: return "avx2";
+	default: break;
+	}
+	return "best";
+}
@@ -69,6 +69,7 @@ Crectangle::~Crectangle()
 void Crectangle::setFillStyle( EfillType pattern)
 {
 	m_square.setFillStyle( pattern);
+	invalidate();
 }
 
 /*============================================================================*/
@@ -146,9 +147,11 @@ void Crectangle::setBackground( EfillType pattern, colour background1, colour fo
 	m_square.setColours( background1, background2);
 	m_border1 =foreground2;
 	m_border2 =background1;
+	invalidate();
 }
 
 void Crectangle::setCode( keybutton key)
 {
 	m_square.setCode( key);
+	invalidate();
 }
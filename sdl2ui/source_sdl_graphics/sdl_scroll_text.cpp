@@ -67,7 +67,7 @@ CscrollText::CscrollText( Cdialog *parent,
 , m_horizontal_margin(0)
 , m_vertical_margin(0)
 , m_shadow(0)
-, m_surface( value, m_font.chinese.font, Csize(10000, rect.height()*8), GRAVITY_LEFT_CENTER)
+, m_surface( value, StextFonts( m_font.local.font, m_font.chinese.font), Csize(10000, rect.height()*8), GRAVITY_LEFT_CENTER)
 {
 }
 
@@ -98,22 +98,12 @@ void CscrollText::onPaint( int touch)
 /*============================================================================*/
 void CscrollText::onPaint( const std::string &text, int touch)
 {
-	utf8string zs(text); // Conversion old format.
-	std::string t(zs);
-	TTF_Font *f=m_font.local.font;
-	for ( int a=0; a<(int)zs.size(); a++)
-	{
-		if ( zs[a]>4096)
-		{
-			f=m_font.chinese.font;
-			break;
-		}
-	}
-	if (!f)
+	StextFonts fonts( CtextFont::styled( m_font.local.font, m_style),
+			          CtextFont::styled( m_font.chinese.font, m_style));
+	if ( !fonts.font[SCRIPT_LOCAL])
 	{
 		return;
 	}
-	TTF_SetFontStyle( f, m_style);
 	Crect rect( m_rect*8);
 
 	rect =Crect( rect.left()+m_horizontal_margin, rect.top()+m_vertical_margin,
@@ -162,6 +152,7 @@ void CscrollText::setColour( colour text)
 void CscrollText::setText( const std::string &text)
 {
 	m_value =text;
+	invalidate();
 }
 
 /*============================================================================*/
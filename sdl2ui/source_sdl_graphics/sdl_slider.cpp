@@ -265,6 +265,7 @@ void Cslider::setImage( const std::string &image)
 {
 	m_image =image;
 	m_imageEnable =(m_image.size() >0);
+	invalidate();
 }
 
 /*============================================================================*/
@@ -278,6 +279,7 @@ void Cslider::setColours( colour scrollbar, colour background)
 {
 	(void)scrollbar;
 	m_backgroundColour =background;
+	invalidate();
 }
 
 bool Cslider::wheelUp()
@@ -392,6 +394,7 @@ bool Cslider::setRange( double minimum, double maximum)
 	bool retVal =false;
 	m_minimum =minimum;
 	m_maximum =maximum;
+	invalidate();
 	if ( m_value<m_minimum)
 	{
 		m_value =m_minimum;
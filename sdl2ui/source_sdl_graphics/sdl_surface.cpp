@@ -38,6 +38,9 @@
 /*------------- Standard includes --------------------------------------------*/
 #include <assert.h>
 #include "sdl_surface.h"
+#include "sdl_text_cache.h"
+#include "sdl_text_script.h"
+#include "sdl_text_layout.h"
 #include "sdl_dialog_object.h"
 #include <string>
 
@@ -74,138 +77,35 @@ void CtextSurface::setColour( colour text, colour back)
 /// @post       Surfaces per line calculated.
 ///
 /*============================================================================*/
-void CtextSurface::createSurfaces( TTF_Font *font)
+void CtextSurface::createSurfaces()
 {
 	m_lock.lock();
 	m_index =0;
-	int lineNr=0;
-	int wordNr=0;
-	int c=0;
-	int w=0;
-	int i=0;
-	int h=0;
-	//SDL_Colour sdc;
-	//sdc.r =0; sdc.g =0; sdc.b =64;
-	utf8string fit;
-
-	SDL_Surface *bitmap =NULL;
 	m_vertical_spacing =1;
 
-	// For loop of all lines.
-	for ( lineNr=0; lineNr<(int)m_split.size(); lineNr++)
+	std::vector<utf8string> paragraphs;
+	for ( int a=0; a<m_split.size(); a++)
 	{
-		// Log.write( "String %d %s", a, m_split[a].c_str());
-		// Split one line into words and see how many words do fit...
-		CtextSplitter word( m_split[lineNr], " ", "\t");
-		if ( word.size() ==0)
-		{
-			continue;
-		}
-		fit =word[0];
-		TTF_SizeUTF8( font, fit.c_str(), &w, &h);
-		if ( w>m_rect.width() && m_rect.width() !=0)
-		{
-			// Even the first word of line a does not fit!
-			fit ="";
-			for ( i=0; i<(int)word[0].size(); i++)
-			{
-				// Check how many characters do fit!
-				fit =word[0].sub( 0,i+1);
-				TTF_SizeUTF8( font, fit.c_str(), &w, &h);
-				if ( w>m_rect.width())
-				{
-					if ( i==0)
-					{
-						//Log.write( "Even one character does not fit!!");
-						m_lock.unlock();
-						return;
-					}
-					fit =word[0].sub( 0,i);
-					bitmap =blend( fit, m_textColour, font, true);
-					//bitmap =TTF_RenderUTF8_Blended( font ,fit.c_str(), m_textColour);
-					if ( bitmap ==NULL)
-					{
-						// ( "CtextSurface::CtextSurface  Cannot create a surface to paint on!!");
-						// Something wrong in memory, skip the rest.
-						break;
-					}
-					m_height +=bitmap->h+m_vertical_spacing;
-					m_index +=fit.size();
-					fit =word[0].sub( i);
-					m_split.insert( lineNr+1, fit);
-					m_surfaces.push_back( bitmap);
-					break;
-				}
-			}
-			// Split the first word in a part that fits and a part that doesn't.
-#if 0
-			if ( i==0)
-			{
-				break;
-			}
-			fit =word[0].sub( 0,i);
-			bitmap =blend( fit, m_textColour, font, true);
-			//bitmap =TTF_RenderUTF8_Blended( font ,fit.c_str(), m_textColour);
-			if ( bitmap ==NULL)
-			{
-				Log.error( "CtextSurface::CtextSurface  Cannot create a surface to paint on!!");
-				// Something wrong in memory, skip the rest.
-				break;
-			}
-			m_height +=bitmap->h+m_vertical_spacing;
-			fit =word[0].sub( i+1);
-			m_split.insert(1, fit);
-			m_surfaces.push_back( bitmap);
-			m_index +=fit.size();
-#endif
-			continue;
-		}
-
-		bool rendered =false;
-		for ( wordNr=1; wordNr<word.size(); wordNr++)
-		{
-			int length =fit.size();
-			fit =utf8string( fit.m_string+" "+(std::string)word[ wordNr]);
-			TTF_SizeUTF8( font, fit.c_str(), &w, &h);
-			if ( w>m_rect.width() && m_rect.width() !=0)
-			{
-				// This word doesn't fit anymore.
-				fit =fit.sub( 0, length);
-				bitmap =blend( fit, m_textColour, font, false);
-				//bitmap =TTF_RenderUTF8_Blended( font ,fit.c_str(), m_textColour);
-				if ( bitmap ==NULL)
-				{
-					// ( "CtextSurface::CtextSurface  Cannot create a surface to paint on!!");
-					// Something wrong in memory, skip the rest.
-					break;
-				}
-				m_height +=bitmap->h+m_vertical_spacing;
-				m_surfaces.push_back( bitmap);
-				m_index +=fit.size()+1;
-				std::string toinsert;
-				for ( c=wordNr; c<(int)word.size(); c++)
-				{
-					toinsert +=(std::string)word[c]+" ";
-				}
-				m_split.insert( lineNr+1, toinsert);
-				rendered =true;
-				break;
-			}
+		paragraphs.push_back( m_split[a]);
+	}
+	// Only paragraphs changed since the last text are wrapped again.
+	std::vector<SlayoutLine> lines;
+	CtextLayout::Instance()->wrap( m_fonts, m_rect.width(), paragraphs, lines);
 
-		}
-		if ( rendered ==false && fit.size()!=0)
+	// Render every line.
+	for ( int a=0; a<(int)lines.size(); a++)
+	{
+		utf8string fit( lines[a].text);
+		SDL_Surface *bitmap =blend( fit, m_textColour, lines[a].split);
+		if ( bitmap ==NULL)
 		{
-			//bitmap =TTF_RenderUTF8_Blended( font ,fit.c_str(), m_textColour);
-			bitmap =blend( fit, m_textColour, font, false);
-			if ( bitmap ==NULL)
-			{
-				// ( "CtextSurface::CtextSurface  Cannot create a surface to paint on!!");
-				break;
-			}
-			m_height +=bitmap->h+m_vertical_spacing;
-			m_surfaces.push_back( bitmap);
-			m_index +=fit.size()+1;
+			// ( "CtextSurface::CtextSurface  Cannot create a surface to paint on!!");
+			// Something wrong in memory, skip the rest.
+			break;
 		}
+		m_height +=bitmap->h+m_vertical_spacing;
+		m_surfaces.push_back( bitmap);
+		m_index +=lines[a].characters;
 	}
 	m_lock.unlock();
 }
@@ -219,7 +119,7 @@ void CtextSurface::createSurfaces( TTF_Font *font)
 /// @post       One surface calculated.
 ///
 /*============================================================================*/
-SDL_Surface * CtextSurface::blend( utf8string &text, SDL_Color fg, TTF_Font *font, bool split)
+SDL_Surface * CtextSurface::blend( utf8string &text, SDL_Color fg, bool split)
 {
 	m_lock.lock();
 	try
@@ -237,8 +137,12 @@ SDL_Surface * CtextSurface::blend( utf8string &text, SDL_Color fg, TTF_Font *fon
 			text.push_back( " ");
 		}
 
-		bitmap =( m_blend) ? TTF_RenderUTF8_Blended( font , text.c_str(), fg):
-							 TTF_RenderUTF8_Solid( font, text.c_str(), fg);
+		bitmap =CtextScript::render( text.str(), m_fonts, fg, m_blend);
+		if ( !bitmap)
+		{
+			m_lock.unlock();
+			return NULL;
+		}
 		int tcol=SDL_MapRGBA( bitmap->format, fg.r, fg.g, fg.b, 0);
 		// Find out start position cursor.
 		std::string t;
@@ -249,11 +153,11 @@ SDL_Surface * CtextSurface::blend( utf8string &text, SDL_Color fg, TTF_Font *fon
 		else
 		{
 			t =text.sub( 0, m_cursor-m_index);
-			TTF_SizeUTF8( font, t.c_str(), &w1, &h1);
+			CtextScript::size( t, m_fonts, &w1, &h1);
 		}
 		// Find out end position cursor.
 		t =text.sub( 0, m_cursor-m_index+1);
-		TTF_SizeUTF8( font, t.c_str(), &w2, &h2);
+		CtextScript::size( t, m_fonts, &w2, &h2);
 		if ( w2==w1) { w1=w1-1; }
 
 		SDL_LockSurface( bitmap);
@@ -276,8 +180,7 @@ SDL_Surface * CtextSurface::blend( utf8string &text, SDL_Color fg, TTF_Font *fon
 		return bitmap;
 	}
 	// Blend without cursor.
-	bitmap =( m_blend) ? TTF_RenderUTF8_Blended( font , text.c_str(), fg):
-						 TTF_RenderUTF8_Solid( font, text.c_str(), fg);
+	bitmap =CtextScript::render( text.str(), m_fonts, fg, m_blend);
 	m_lock.unlock();
 	return bitmap;
 	}
@@ -332,7 +235,7 @@ CtextSurface::CtextSurface( std::shared_ptr<Cgraphics> graphics,
 		                    Egravity gravity,
 		                    colour textColour,
 		                    colour cursorColour,
-		                    TTF_Font *font)
+		                    const StextFonts &fonts)
 : m_height(0)
 , m_gravity( gravity)
 , m_split( text, ",", "\n")
@@ -341,6 +244,7 @@ CtextSurface::CtextSurface( std::shared_ptr<Cgraphics> graphics,
 , m_cursor(cursor)
 , m_owner(false)
 , m_blend(true)
+, m_fonts( fonts)
 {
 	(void)cursor;
 	setColour( textColour, cursorColour);
@@ -355,23 +259,50 @@ CtextSurface::CtextSurface( std::shared_ptr<Cgraphics> graphics,
 		// Something wrong in memory, should skip the rest.
 	//}
 
-	createSurfaces( font);
+	StextKey key;
+	key.font =fonts.font[SCRIPT_LOCAL];
+	key.fallback =fonts.font[SCRIPT_CJK];
+	key.style =TTF_GetFontStyle( key.font);
+	key.textColour =textColour;
+	key.cursorColour =cursorColour;
+	key.width =rect.width();
+	key.height =rect.height();
+	key.gravity =gravity;
+	key.cursor =cursor;
+	key.text =text;
+	if ( CtextCache::Instance()->paint( key, m_graphics.get(), rect.left(), rect.top()))
+	{
+		// Same text painted before, no need to split, measure and render.
+		return;
+	}
+	createSurfaces();
+	std::vector<SDL_Rect> positions;
+	layoutSurfaces( positions);
+	if ( CtextCache::Instance()->store( key, m_graphics.get(), m_surfaces, positions)
+	  && CtextCache::Instance()->paint( key, m_graphics.get(), rect.left(), rect.top(), false))
+	{
+		clean();
+		return;
+	}
 	renderSurfaces();
 	clean();
 }
 
 /*==============================================================================
-**              CtextSurface::renderSurfaces
+**              CtextSurface::layoutSurfaces
 **============================================================================*/
 ///
-/// @brief		Render the text-lines together to one video memory.
+/// @brief		Calculate where each text-line is painted.
 ///
-/// @post       Final surface calculated.
+/// @param      positions [out] Position per line, relative to the rectangle.
+///
+/// @post       Lines that do not fit anymore are skipped.
 ///
 /*============================================================================*/
-void CtextSurface::renderSurfaces()
+void CtextSurface::layoutSurfaces( std::vector<SDL_Rect> &positions)
 {
 	m_lock.lock();
+	positions.clear();
 	// All lines are calcuated, now the display.
 	int top_offset =0;
 	if ( m_rect.height()>m_height)
@@ -419,12 +350,39 @@ void CtextSurface::renderSurfaces()
 			break;
 		}
 		int hblit =( pixels_left >=s->h) ? s->h:pixels_left;
-		if (hblit >0)
+		if (hblit <=0)
 		{
-			m_graphics->renderSurface( *a, m_rect.left()+x_offset, m_rect.top()+top_offset);
-			pixels_left -=hblit;
-			top_offset +=hblit+m_vertical_spacing;
+			break;
 		}
+		SDL_Rect position;
+		position.x =x_offset;
+		position.y =top_offset;
+		position.w =s->w;
+		position.h =s->h;
+		positions.push_back( position);
+		pixels_left -=hblit;
+		top_offset +=hblit+m_vertical_spacing;
+	}
+	m_lock.unlock();
+}
+
+/*==============================================================================
+**              CtextSurface::renderSurfaces
+**============================================================================*/
+///
+/// @brief		Render the text-lines together to one video memory.
+///
+/// @post       Final surface calculated.
+///
+/*============================================================================*/
+void CtextSurface::renderSurfaces()
+{
+	std::vector<SDL_Rect> positions;
+	layoutSurfaces( positions);
+	m_lock.lock();
+	for ( int a=0; a<(int)positions.size(); a++)
+	{
+		m_graphics->renderSurface( m_surfaces[a], m_rect.left()+positions[a].x, m_rect.top()+positions[a].y);
 	}
 	m_lock.unlock();
 }
@@ -452,12 +410,12 @@ void CtextSurface::clean()
 
 /** @brief		Create text surface.
  *  @param      text [in] What to write
- *  @param		font [in] Which font to use
+ *  @param		fonts [in] Which font to use per script
  *  @param 		size [in] Size of the surface
  *  @param      gravity [in] What gravity to use
  */
 CtextSurface::CtextSurface( const std::string &text,
-		                    TTF_Font *font,
+		                    const StextFonts &fonts,
 		                    const Csize &size,
 		                    Egravity gravity
 		                    )
@@ -471,6 +429,7 @@ CtextSurface::CtextSurface( const std::string &text,
 , m_cursor(-1)
 , m_owner(false)
 , m_blend(false)
+, m_fonts( fonts)
 {
 	m_textColour.b =8;
 	m_textColour.r =8;
@@ -478,7 +437,7 @@ CtextSurface::CtextSurface( const std::string &text,
 #ifndef USE_SDL2
 	m_textColour.unused =128;
 #endif
-	createSurfaces( font);
+	createSurfaces();
 	createGraphics();
 	renderSurfaces();
 }
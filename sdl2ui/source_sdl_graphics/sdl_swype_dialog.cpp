@@ -36,6 +36,8 @@
  **===========================================================================*/
 
 /*------------- Standard includes --------------------------------------------*/
+#include <math.h>
+#include <time.h>
 #include "sdl_swype_dialog.h"
 #include "sdl_surface.h"
 #include "sdl_graphics.h"
@@ -67,11 +69,15 @@ CswypeDialog::CswypeDialog( Cdialog *parent, const Crect &rect, keybutton firstK
 , m_moveTime(0)
 , m_dialogSpeed(0)
 , m_repaint(false)
+, m_ahead(false)
+, m_snap(true)
+, m_preRendering(false)
 , m_dragEnable(0)
 , m_dragIndex(0)
 , m_object(NULL)
 , m_cursor(0)
 {
+	clearStats();
 	m_object =new CscrollObject( this, 0, Csize(m_rect.width(), itemBlocks()));
 
 	m_graphics =parent->graphics();
@@ -87,35 +93,14 @@ void CswypeDialog::setRect( const Crect &rect)
 {
 	m_rect.setLeft( rect.left());
 	m_rect.setTop( rect.top());
-	int py =rect.height()*8;
-	int px =rect.width()*8;
 
-	if ( m_rect.width() !=rect.width() || m_rect.height() !=rect.height()
-	   || m_graphics ==NULL)
+	if ( m_rect.width() !=rect.width() || m_rect.height() !=rect.height())
 	{
 		m_rect =rect;
-		if ( m_horizontal)
-		{
-			int pixelsReserved=3*m_rect.width()*8+itemBlocks()*8-1;
-			m_endMargin =itemBlocks()*1*8;
-			pixelsReserved =pixelsReserved -(pixelsReserved%itemBlocks());
-		   /* Create a 32-bit surface with the bytes of each pixel in R,G,B,A order,
-		       as expected by OpenGL for textures */
-			px *=3;
-			px =px-(px%(itemBlocks()*8));
-		}
-		else
-		{
-			int pixelsReserved=3*m_rect.height()*8+itemBlocks()*8-1;
-			m_endMargin =itemBlocks()*1*8;
-			pixelsReserved =pixelsReserved -(pixelsReserved%itemBlocks());
-		   /* Create a 32-bit surface with the bytes of each pixel in R,G,B,A order,
-		       as expected by OpenGL for textures */
-			py *=3;
-			py =py-(py%(itemBlocks()*8));
-		}
-	    m_graphics =std::make_shared<Cgraphics>(Csize(px, py), false);
-	    m_graphics->init();
+		m_endMargin =itemBlocks()*1*8;
+		// Tiles have the old size, the atlas is made again on the next paint.
+		clean();
+		calculateItemRect();
 	}
 }
 
@@ -153,8 +138,10 @@ int CswypeDialog::getScrollIndex( keybutton sym)
  */
 void CswypeDialog::onPaintSurfaceHorizontal( bool optional)
 {
-	static int count =5;
-
+	if ( !allocateTiles())
+	{
+		return;
+	}
 	for (int mx=0; mx<200; mx++) // Remove endless loop.
 	{
 		// Check what to paint.
@@ -187,31 +174,20 @@ void CswypeDialog::onPaintSurfaceHorizontal( bool optional)
 			break;
 
 		case PAINT_TOP_OPTIONAL:
-			if ( !optional) return;
-			if ( --count>0) return;
-			paintSurfaceTop();
-			count =5;
+			if ( optional) paintSurfaceTop();
 			return;
 
 		case PAINT_BOTTOM_OPTIONAL:
-			if ( !optional) return;
-			if ( --count>0) return;
-			paintSurfaceBottom();
-			count =5;
+			if ( optional) paintSurfaceBottom();
 			return;
 
 		case PAINT_LEFT_OPTIONAL:
-			if ( !optional) return;
-			if ( --count>0) return;
-			paintSurfaceLeft();
-			count =5;
+			if ( optional) paintSurfaceLeft();
 			return;
 
 		case PAINT_RIGHT_OPTIONAL:
-			if ( !optional) return;
-			if ( --count>0) return;
-			count =5;
-			paintSurfaceRight();
+			if ( optional) paintSurfaceRight();
+			return;
 
 		case PAINT_READY:
 			return;
@@ -251,11 +227,14 @@ Epainted CswypeDialog::visiblePainted()
 	{
 		return m_horizontal ? PAINT_RIGHT:PAINT_BOTTOM;
 	}
-	if ( m_firstUnitPainted >m_firstOptionalUnit && m_visibleBuffers<m_validBuffers)
+	// Painting ahead may only recycle a tile outside the optional range.
+	if (   m_firstUnitPainted >m_firstOptionalUnit
+		&& ( m_visibleBuffers<m_validBuffers || m_lastUnitPainted>m_lastOptionalUnit))
 	{
 		return m_horizontal ? PAINT_LEFT_OPTIONAL:PAINT_TOP_OPTIONAL;
 	}
-	if ( m_lastUnitPainted <m_lastOptionalUnit && m_visibleBuffers<m_validBuffers)
+	if (   m_lastUnitPainted <m_lastOptionalUnit
+		&& ( m_visibleBuffers<m_validBuffers || m_firstUnitPainted<m_firstOptionalUnit))
 	{
 		return m_horizontal ? PAINT_RIGHT_OPTIONAL:PAINT_BOTTOM_OPTIONAL;
 	}
@@ -267,8 +246,11 @@ Epainted CswypeDialog::visiblePainted()
  */
 void CswypeDialog::onPaintSurfaceVertical( bool optional)
 {
-	static int count =5;
 	calculateSurfacePosition();
+	if ( !allocateTiles())
+	{
+		return;
+	}
 
 	for (int mx=0; mx<2000; mx++) // Remove endless loop.
 	{
@@ -291,19 +273,11 @@ void CswypeDialog::onPaintSurfaceVertical( bool optional)
 			break;
 
 		case PAINT_TOP_OPTIONAL:
-			if ( !optional) return;
-			if ( --count>0) return;
-			count=10;
-			paintSurfaceTop();
-			m_repaint =true;
+			if ( optional) paintSurfaceTop();
 			return;
 
 		case PAINT_BOTTOM_OPTIONAL:
-			if ( !optional) return;
-			if ( --count>0) return;
-			count=10;
-			paintSurfaceBottom();
-			m_repaint =true;
+			if ( optional) paintSurfaceBottom();
 			return;
 
 		case PAINT_READY:
@@ -314,53 +288,142 @@ void CswypeDialog::onPaintSurfaceVertical( bool optional)
 	}
 }
 
-/** @brief Insert a texture at the begin of the list
- *  @return Pointer to (new) object
+/** @brief Number of tiles to cover the visible rows and the rows painted ahead.
+ *  @return Slots needed in the atlas.
  */
-CswypeObject *CswypeDialog::insertAtBegin()
+int CswypeDialog::tileCount()
 {
-	sdlTexture *texture;
-	CswypeObject *obj;
-	// Erase first item?
-	m_visibleSize =m_lastVisibleUnit-m_firstVisibleUnit+1;
+	int extent =m_horizontal ? m_rect.width():m_rect.height();
+	int visible =extent/gMax( 1, itemBlocks())+2;
+	return visible+2*(m_listSize/4)+1;
+}
 
-	if ( m_visibleBuffers<m_validBuffers)
-	{
-		// Re-use last image in list if too many
-		obj =m_swypeObjects[ m_validBuffers-1];
-		texture =obj->texture;
-		m_swypeObjects.erase( m_swypeObjects.begin()+m_validBuffers-1);
-		m_swypeObjects.insert( m_swypeObjects.begin(), obj);
-		m_visibleBuffers++;
-	}
-	else if ( m_visibleBuffers>=m_visibleSize*3)
-	{
-		// Re-use last valid image in list
-		obj =m_swypeObjects[ m_validBuffers-1];
-		texture =obj->texture;
-		m_swypeObjects.erase( m_swypeObjects.begin()+m_validBuffers-1);
-		m_swypeObjects.insert( m_swypeObjects.begin(), obj);
-		// Need to correct last unit painted.
-		int last =m_swypeObjects[m_validBuffers-1]->index;
-		if ( last<m_lastUnitPainted)
+/** @brief Largest atlas the renderer accepts.
+ *  @param width [out] Maximum width in pixels.
+ *  @param height [out] Maximum height in pixels.
+ */
+void CswypeDialog::atlasLimits( int &width, int &height)
+{
+	width =SWYPE_ATLAS_WIDTH;
+	height =SWYPE_ATLAS_PIXELS;
+#ifdef USE_SDL2
+	SDL_RendererInfo info;
+	if ( SDL_GetRendererInfo( graphics()->getRenderer(), &info) ==0)
+	{
+		if ( info.max_texture_width>0)
+		{
+			width =gMin( width, info.max_texture_width);
+		}
+		if ( info.max_texture_height>0)
 		{
-			m_lastUnitPainted =last+1;
+			height =gMin( height, info.max_texture_height);
 		}
 	}
-	else
+#endif
+}
+
+/** @brief Make the atlases with all tiles, only when the tile size changed.
+ *  @return true when the tiles can be used.
+ */
+bool CswypeDialog::allocateTiles()
+{
+	int count =tileCount();
+	int w =m_itemRect.width();
+	int h =m_itemRect.height();
+	if (   !m_atlases.empty() && (int)m_tiles.size() ==count
+		&& m_tiles[0].slot.width() ==w && m_tiles[0].slot.height() ==h)
+	{
+		return true;
+	}
+	clean();
+	if ( count<=0 || w<=0 || h<=0)
 	{
-		// Create new one.
-		texture =createSurface();
-		obj =new CswypeObject( texture, 0, m_itemRect);
-		if ( !texture || !obj)
+		return false;
+	}
+	// Tiles are stacked in columns, to stay within the maximum texture size.
+	int maxWidth, maxHeight;
+	atlasLimits( maxWidth, maxHeight);
+	int perColumn =gLimit( maxHeight/(h*8), 1, count);
+	int perRow =gLimit( maxWidth/(w*8), 1, (count+perColumn-1)/perColumn);
+	if ( !createAtlases( count, perColumn, perRow))
+	{
+		// No video memory for a big atlas, try one texture per tile.
+		clean();
+		if ( perColumn*perRow ==1 || !createAtlases( count, 1, 1))
+		{
+			clean();
+			return false;
+		}
+	}
+	m_validBuffers =count;
+	calculateSurfacePosition();
+	m_firstUnitPainted =m_firstVisibleUnit;
+	m_lastUnitPainted =m_firstVisibleUnit;
+	return true;
+}
+
+/** @brief Spread the tiles over as many atlases as needed.
+ *  @param count [in] Number of tiles.
+ *  @param perColumn [in] Tiles on top of each other in one atlas.
+ *  @param perRow [in] Columns of tiles in one atlas.
+ *  @return false when a texture cannot be made.
+ */
+bool CswypeDialog::createAtlases( int count, int perColumn, int perRow)
+{
+	int w =m_itemRect.width();
+	int h =m_itemRect.height();
+	m_tiles.resize( count);
+	for ( int first=0; first<count; first+=perColumn*perRow)
+	{
+		int tiles =gMin( count-first, perColumn*perRow);
+		int columns =(tiles+perColumn-1)/perColumn;
+		sdlTexture *atlas =createSurface( columns*w, gMin( tiles, perColumn)*h);
+		if ( !atlas)
+		{
+			return false;
+		}
+		m_atlases.push_back( atlas);
+		for ( int n=0; n<tiles; n++)
 		{
-			return NULL;
+			m_tiles[first+n] =CswypeObject( atlas, -1, Crect( (n/perColumn)*w, (n%perColumn)*h, w, h));
 		}
-		m_validBuffers++;
-		m_visibleBuffers++;
-		m_swypeObjects.insert( m_swypeObjects.begin(), obj);
 	}
-	obj->index =--m_firstUnitPainted;
+	return true;
+}
+
+/** @brief Find the tile slot for a row or unit.
+ *  @param unit [in] Row for a vertical list, column for a horizontal list.
+ *  @return Tile in the ring, NULL when there are no tiles.
+ */
+CswypeObject *CswypeDialog::tile( int unit)
+{
+	if ( m_tiles.empty() || unit<0)
+	{
+		return NULL;
+	}
+	return &m_tiles[ unit%(int)m_tiles.size()];
+}
+
+/** @brief Take the tile in front of the painted units.
+ *  When all tiles are used, the tile of the last unit is recycled.
+ *  @return Pointer to the tile, NULL without atlas.
+ */
+CswypeObject *CswypeDialog::insertAtBegin()
+{
+	m_visibleSize =m_lastVisibleUnit-m_firstVisibleUnit+1;
+	if ( m_tiles.empty() || m_firstUnitPainted<=0)
+	{
+		return NULL;
+	}
+	if ( m_visibleBuffers>=m_validBuffers)
+	{
+		// Unit n-1 shares its slot with the last unit.
+		m_lastUnitPainted--;
+		m_visibleBuffers--;
+	}
+	CswypeObject *obj =tile( --m_firstUnitPainted);
+	obj->index =m_firstUnitPainted;
+	m_visibleBuffers++;
 	return obj;
 }
 
@@ -369,47 +432,20 @@ CswypeObject *CswypeDialog::insertAtBegin()
  */
 sdlTexture *CswypeDialog::createSurface()
 {
-#ifdef USE_SDL2
-	SDL_Texture *texture =SDL_CreateTexture( graphics()->getRenderer(),
-			SDL_PIXELFORMAT_ARGB8888,
-			SDL_TEXTUREACCESS_TARGET, m_itemRect.width()*8, m_itemRect.height()*8); //, itemBlocks()*8, m_rect.height()*8);
-	return texture;
-#else
-	int options =SDL_SWSURFACE; //|SDL_NOFRAME;
-    Uint32 rmask, gmask, bmask, amask;
-
-    /* SDL interprets each pixel as a 32-bit number, so our masks must depend
-       on the endianness (byte order) of the machine */
-	#if 0 //SDL_BYTEORDER ==SDL_BIG_ENDIAN
-		rmask = 0xff000000;
-		gmask = 0x00ff0000;
-		bmask = 0x0000ff00;
-		amask = 0x000000ff;
-	#else
-		bmask = 0x000000ff;
-		gmask = 0x0000ff00;
-		rmask = 0x00ff0000;
-		amask = 0; //0xff000000;
-	#endif
-
-    SDL_Surface *surface =SDL_CreateRGBSurface( options, m_itemRect.width()*8, m_itemRect.height()*8,
-    		                         32, //::m_mainGraph->m_renderSurface->format->BitsPerPixel,
-                                     rmask, gmask, bmask, amask);
-	return surface;
-#endif
+	return createSurface( m_itemRect.width(), m_itemRect.height());
 }
 
 /** @brief Create a surface for a part of the swipe to use
+ *  @param w [in] Width in blocks of 8 pixels.
+ *  @param h [in] Height in blocks of 8 pixels.
  *  @return Surface pointer
  */
 sdlTexture *CswypeDialog::createSurface( int w, int h)
 {
 #ifdef USE_SDL2
-	(void)w;
-	(void)h;
 	SDL_Texture *texture =SDL_CreateTexture( graphics()->getRenderer(),
 			SDL_PIXELFORMAT_ARGB8888,
-			SDL_TEXTUREACCESS_TARGET, m_itemRect.width()*8, m_itemRect.height()*8); //, itemBlocks()*8, m_rect.height()*8);
+			SDL_TEXTUREACCESS_TARGET, w*8, h*8);
 	return texture;
 #else
 	int options =SDL_SWSURFACE; //|SDL_NOFRAME;
@@ -436,113 +472,198 @@ sdlTexture *CswypeDialog::createSurface( int w, int h)
 #endif
 }
 
-/** @brief Insert a texture at the end of the list
- *  @return Pointer to (new) object
+/** @brief Take the tile behind the painted units.
+ *  When all tiles are used, the tile of the first unit is recycled.
+ *  @return Pointer to the tile, NULL without atlas.
  */
 CswypeObject *CswypeDialog::insertAtEnd()
 {
-	sdlTexture *texture;
-	CswypeObject *obj;
-	// Erase first item?
 	m_visibleSize =m_lastVisibleUnit-m_firstVisibleUnit+1;
-	if ( m_visibleBuffers< m_validBuffers)
-	{
-		int sz=(int)m_swypeObjects.size();
-		if ( sz!=m_validBuffers)
-		{
-			return NULL;
-		}
-		obj =m_swypeObjects[ m_visibleBuffers++];
-	}
-	else if ( m_visibleBuffers>=m_visibleSize*3)
+	if ( m_tiles.empty())
 	{
-		// Re-use first image in list if too many
-		obj =m_swypeObjects[ 0];
-		m_swypeObjects.erase( m_swypeObjects.begin());
-		m_swypeObjects.push_back( obj);
-		int first =m_swypeObjects[0]->index;
-		if ( first>m_firstUnitPainted)
-		{
-			m_firstUnitPainted =first;
-		}
+		return NULL;
 	}
-	else
+	if ( m_visibleBuffers>=m_validBuffers)
 	{
-		// Create new one.
-		texture =createSurface();
-		obj =new CswypeObject( texture, 0, m_itemRect);
-		if ( !texture || !obj)
-		{
-			// ("CswypeDialog::insertAtEnd  Cannot create texture+object");
-			return NULL;
-		}
-		m_swypeObjects.push_back( obj);
-		m_validBuffers++;
-		m_visibleBuffers++;
+		// Unit n shares its slot with the first unit.
+		m_firstUnitPainted++;
+		m_visibleBuffers--;
 	}
+	CswypeObject *obj =tile( m_lastUnitPainted);
 	obj->index =m_lastUnitPainted++;
+	m_visibleBuffers++;
 	return obj;
 }
 
-/** @brief Paint a row on top of a scrolling dialog.
- *  @param row [in] Which row or element.
- *  @param location [in] Location in a temporary surface.
+/** @brief Paint a single tile in its slot of the atlas.
+ *  @param obj [in] Tile to paint, the unit is obj->index.
  */
+void CswypeDialog::paintTile( CswypeObject *obj)
+{
+	if ( !obj)
+	{
+		return;
+	}
+	SDL_Rect clip;
+	clip.x =obj->slot.left()*8;
+	clip.y =obj->slot.top()*8;
+	clip.w =obj->slot.width()*8;
+	clip.h =obj->slot.height()*8;
+	obj->ahead =m_preRendering;
+	if ( m_preRendering)
+	{
+		m_stats.rendered++;
+	}
+	else
+	{
+		m_stats.demand++;
+	}
+	graphics()->setRenderArea( obj->texture);
+	graphics()->setViewport( &clip);
+	onPaintUnit( obj->index, obj->slot);
+	graphics()->setViewport( NULL);
+	graphics()->setRenderArea( NULL);
+}
+
+/** @brief Paint a row on top of a scrolling dialog. */
 void CswypeDialog::paintSurfaceTop()
 {
-	CswypeObject *obj =insertAtBegin();
-	// Actual painting
-	m_graphics->setRenderArea( obj->texture);
-	onPaintUnit( obj->index, m_itemRect);
-	m_graphics->setRenderArea( NULL);
+	paintTile( insertAtBegin());
 }
 
 /** @brief Paint a column on the left of a scrolling dialog.
- *  @param row [in] Which row or element.
- *  @param location [in] Location in a temporary surface.
+ *  @return true when painted.
  */
 bool CswypeDialog::paintSurfaceLeft()
 {
 	CswypeObject *obj =insertAtBegin();
-	// Actual painting
-	graphics()->setRenderArea( obj->texture);
-	onPaintUnit( obj->index, m_itemRect);
-	graphics()->setRenderArea( NULL);
-	return true;
+	paintTile( obj);
+	return obj !=NULL;
 }
 
-/** @brief Paint a row on the bottom of a scrolling dialog.
- *  @param row [in] Which row or element.
- *  @param location [in] Location in a temporary surface.
- */
+/** @brief Paint a row on the bottom of a scrolling dialog. */
 void CswypeDialog::paintSurfaceBottom()
 {
-	CswypeObject *obj =insertAtEnd();
-	if (obj)
-	{
-		// Actual painting
-		m_graphics->setRenderArea( obj->texture);
-		onPaintUnit( obj->index, m_itemRect);
-		m_graphics->setRenderArea( NULL);
-	}
+	paintTile( insertAtEnd());
 }
 
 /** @brief Paint a column on the right of a scrolling dialog.
- *  @param row [in] Which row or element.
- *  @param location [in] Location in a temporary surface.
+ *  @return true when painted.
  */
 bool CswypeDialog::paintSurfaceRight()
 {
 	CswypeObject *obj =insertAtEnd();
-	if (obj)
+	paintTile( obj);
+	return obj !=NULL;
+}
+
+/** @brief Guess where the scroll offset will be in a few frames.
+ *  @return Scroll offset in pixels.
+ */
+double CswypeDialog::predictScroll()
+{
+	double target =m_scroll;
+	if ( m_moveTime >0)
 	{
-		// Actual painting
-		graphics()->setRenderArea( obj->texture);
-		onPaintUnit( obj->index, m_itemRect);
-		graphics()->setRenderArea( NULL); // Back to main window
-		return true;
+		target =m_endPosition;
+	}
+	else if ( m_speeding.isMoving())
+	{
+		target =m_scroll+m_speeding.getSpeed()*SWYPE_PREDICT_FRAMES;
+	}
+	return gLimit( target, 0.0, (double)scrollMax());
+}
+
+/** @brief Move the optional range towards the rows we expect to see.
+ *  Tiles behind the movement are spare, so the range may grow ahead up to
+ *  the size of the ring.
+ */
+void CswypeDialog::predictUnits()
+{
+	double scroll =m_scroll;
+	double target =predictScroll();
+	calculateSurfacePosition();
+	if ( (int)target ==(int)scroll)
+	{
+		return;
+	}
+	int first =m_firstVisibleUnit;
+	int last =m_lastVisibleUnit;
+	int firstOptional =m_firstOptionalUnit;
+	int lastOptional =m_lastOptionalUnit;
+
+	// The subclass knows how pixels map to units.
+	m_scroll =target;
+	calculateSurfacePosition();
+	int predictedFirst =m_firstVisibleUnit;
+	int predictedLast =m_lastVisibleUnit;
+	m_scroll =scroll;
+	calculateSurfacePosition();
+
+	if ( target>scroll)
+	{
+		m_firstOptionalUnit =first;
+		m_lastOptionalUnit =gMin( gMax( lastOptional, predictedLast), first+m_validBuffers);
+	}
+	else
+	{
+		m_lastOptionalUnit =last;
+		m_firstOptionalUnit =gMax( gMax( 0, last-m_validBuffers), gMin( firstOptional, predictedFirst));
 	}
-	return false;
+}
+
+/** @brief Paint rows before they become visible, within the frame budget.
+ *  @return true when there are still tiles to paint ahead.
+ */
+bool CswypeDialog::paintAhead()
+{
+	if ( m_tiles.empty())
+	{
+		return false;
+	}
+	unsigned long start =Ctimeout::GetTickCount();
+	predictUnits();
+	m_preRendering =true;
+	bool more =true;
+	while ( more)
+	{
+		switch ( visiblePainted())
+		{
+		case PAINT_TOP_OPTIONAL:
+			paintSurfaceTop();
+			break;
+		case PAINT_BOTTOM_OPTIONAL:
+			paintSurfaceBottom();
+			break;
+		case PAINT_LEFT_OPTIONAL:
+			paintSurfaceLeft();
+			break;
+		case PAINT_RIGHT_OPTIONAL:
+			paintSurfaceRight();
+			break;
+		case PAINT_READY:
+			more =false;
+			break;
+		default:
+			// Visible rows are painted by onPaint.
+			m_preRendering =false;
+			return true;
+		}
+		if ( more && Ctimeout::GetTickCount()-start >=SWYPE_PRERENDER_TIME)
+		{
+			break;
+		}
+	}
+	m_preRendering =false;
+	return more;
+}
+
+/// @brief Start counting painted rows again.
+void CswypeDialog::clearStats()
+{
+	m_stats.rendered =0;
+	m_stats.served =0;
+	m_stats.demand =0;
 }
 
 /// @brief Paint all things.
@@ -558,11 +679,11 @@ void CswypeDialog::onPaint()
 	graphics()->setPixelOffset(0,0);
 	if (m_horizontal)
 	{
-		onPaintSurfaceHorizontal( true);
+		onPaintSurfaceHorizontal( false);
 	}
 	else
 	{
-		onPaintSurfaceVertical( true);
+		onPaintSurfaceVertical( false);
 	}
 	rct.x =(Sint16)(m_rect.left()*8+m_dialogOffset.x);
 	rct.y =(Sint16)(m_rect.top()*8+m_dialogOffset.y);
@@ -575,37 +696,31 @@ void CswypeDialog::onPaint()
 	m_graphics->setColour( m_backgroundColour);
 	m_graphics->setViewport( &rct);
 	m_graphics->bar( rct.x, rct.y, rct.x+rct.w, rct.y+rct.h);
-	if ( m_visibleBuffers >0)
+	// Only tiles on the display are copied from the atlas.
+	int first =gMax( m_firstUnitPainted, m_firstVisibleUnit);
+	int last =gMin( m_lastUnitPainted, m_lastVisibleUnit+1);
+	if ( m_horizontal)
 	{
-		if ( m_horizontal)
+		int width =itemBlocks()*8;
+		// Draw horizontal items
+		rct.w =(Uint16)(m_itemRect.width()*8);
+		rct.h =(Uint16)(m_itemRect.height()*8);
+		for ( int unit=first; unit<last; unit++)
 		{
-			int width =itemBlocks()*8;
-			int x=rct.x+m_swypeObjects[0]->index*width-(int)m_scroll;
-			// Draw horizontal items
-			rct.w =(Uint16)(m_swypeObjects[0]->destination.width()*8);
-			rct.h =(Uint16)(m_swypeObjects[0]->destination.height()*8);
-			for ( int n=0; n<m_lastUnitPainted-m_firstUnitPainted; n++)
-			{
-				CswypeObject *obj =m_swypeObjects[n];
-				rct.x =(Sint16)x;
-				x +=width;
-				renderCopy( obj->texture, &rct);
-			}
+			rct.x =(Sint16)(dlg.x+unit*width-(int)m_scroll);
+			renderCopy( tile( unit), &rct);
 		}
-		else
+	}
+	else
+	{
+		int height =itemBlocks()*8;
+		// Draw vertical items
+		rct.w =(Uint16)(m_itemRect.width()*8);
+		rct.h =(Uint16)height;
+		for ( int unit=first; unit<last; unit++)
 		{
-			int height =itemBlocks()*8;
-			int y=rct.y+m_swypeObjects[0]->index*height-(int)m_scroll;
-			// Draw horizontal items
-			rct.w =(Uint16)(m_itemRect.width()*8);
-			rct.h =(Uint16)height;
-			for ( int n=0; n<m_visibleBuffers; n++)
-			{
-				CswypeObject *obj =m_swypeObjects[n];
-				rct.y =(Sint16)y;
-				y +=height;
-				renderCopy( obj->texture, &rct);
-			}
+			rct.y =(Sint16)(dlg.y+unit*height-(int)m_scroll);
+			renderCopy( tile( unit), &rct);
 		}
 	}
 	// Put back old viewport
@@ -626,6 +741,29 @@ void CswypeDialog::renderCopy( sdlTexture *surface, SDL_Rect *rect)
 #endif
 }
 
+/** @brief Render one tile out of the atlas
+ *  @param obj [in] Tile to paint
+ *  @param rect [in] Rectangle to use
+ */
+void CswypeDialog::renderCopy( CswypeObject *obj, SDL_Rect *rect)
+{
+	if ( !obj)
+	{
+		return;
+	}
+	if ( obj->ahead)
+	{
+		obj->ahead =false;
+		m_stats.served++;
+	}
+	SDL_Rect source;
+	source.x =obj->slot.left()*8;
+	source.y =obj->slot.top()*8;
+	source.w =obj->slot.width()*8;
+	source.h =obj->slot.height()*8;
+	graphics()->renderPart( obj->texture, source, *rect);
+}
+
 /** @brief Clean dialog afterwards */
 void CswypeDialog::onCleanup()
 {
@@ -714,6 +852,7 @@ bool CswypeDialog::scrollRelative( double distance, bool flow)
 		return true;
 	}
 	m_repaint =true;
+	m_ahead =true;
 	calculateSurfacePosition();
 	return true;
 }
@@ -721,11 +860,16 @@ bool CswypeDialog::scrollRelative( double distance, bool flow)
 /** Remove all buffers to see. */
 void CswypeDialog::clean()
 {
-	for ( int n=0; n<(int)m_swypeObjects.size(); n++)
+	m_tiles.clear();
+	for ( int a=0; a<(int)m_atlases.size(); a++)
 	{
-		delete m_swypeObjects[n];
+#ifdef USE_SDL2
+		SDL_DestroyTexture( m_atlases[a]);
+#else
+		SDL_FreeSurface( m_atlases[a]);
+#endif
 	}
-	m_swypeObjects.clear();
+	m_atlases.clear();
 	m_validBuffers =0;
 	m_visibleBuffers =0;
 	m_firstUnitPainted =0;
@@ -747,6 +891,7 @@ void CswypeDialog::resetPaintedArea()
 	calculateItemRect();
 	calculateSurfacePosition();
 	m_repaint =true;
+	m_ahead =true;
 }
 
 /** @brief Make sure the item is visible.
@@ -835,17 +980,19 @@ void CswypeDialog::calculateSurfacePosition()
 {
 	int nrRows =(int)rows();
 	int siz;
+	// An overscroll shows background, no extra rows.
+	double scroll =gLimit( m_scroll, 0.0, (double)scrollMax());
 	if ( m_horizontal)
 	{
 		siz =m_itemRect.width()*8;
-		m_firstVisibleUnit =(int)(m_scroll/siz);
-		m_lastVisibleUnit =(int)((m_scroll+m_rect.width()*8+siz-1)/siz);
+		m_firstVisibleUnit =(int)(scroll/siz);
+		m_lastVisibleUnit =(int)((scroll+m_rect.width()*8+siz-1)/siz);
 	}
 	else
 	{
 		siz =m_itemRect.height()*8;
-		m_firstVisibleUnit =(int)(m_scroll/siz);
-		m_lastVisibleUnit =(int)((m_scroll+m_rect.height()*8+siz-1)/siz);
+		m_firstVisibleUnit =(int)(scroll/siz);
+		m_lastVisibleUnit =(int)((scroll+m_rect.height()*8+siz-1)/siz);
 	}
 	m_firstOptionalUnit =m_firstVisibleUnit-m_listSize/4;
 	m_lastOptionalUnit =m_lastVisibleUnit+m_listSize/4;
@@ -906,16 +1053,26 @@ bool CswypeDialog::onLoop()
 	case MOUSE_START_SCROLL_OR_DRAG:
 		m_dialogSpeed =0;
 		m_speeding.clear();
+		if ( m_scroll<0 || m_scroll>scrollMax())
+		{
+			// Caught during an overscroll.
+			setScroll( gLimit( m_scroll, 0.0, (double)scrollMax()));
+		}
 		break;
 
 	case MOUSE_RELEASED:
-		//speed =m_speeding.getRelative();
-		//Log.write( "Scroll speed =%f", speed);
 		if ( m_moveTime !=0)
 		{
 			m_speeding.clear();
 		}
-		scrollRelative( m_speeding.getSpeed(), false);
+		else
+		{
+			double position =m_scroll;
+			if ( m_speeding.step( position, scrollMax(), m_snap ? itemBlocks()*8:0))
+			{
+				setScroll( position);
+			}
+		}
 		break;
 
 	case MOUSE_SCROLL:
@@ -958,9 +1115,57 @@ bool CswypeDialog::onLoop()
 		}
 	}
 	onPaint();
+	if ( m_ahead)
+	{
+		// Rest of the frame: prepare the rows we scroll to.
+		m_ahead =paintAhead();
+	}
 	return m_alive;
 }
 
+/*============================================================================*/
+///
+/// @brief 		Tell when onLoop() should be called again.
+///
+/// @return     Milliseconds, -1 when the dialog does not move.
+///
+/*============================================================================*/
+int CswypeDialog::nextDeadline()
+{
+	int deadline =Cdialog::nextDeadline();
+	if ( m_visible ==false)
+	{
+		return deadline;
+	}
+	if (   m_moveTime >0
+		|| (   CdialogEvent::Instance()->getStatus() ==MOUSE_RELEASED
+			&& m_speeding.isMoving()))
+	{
+		deadline =earliestDeadline( deadline, SWYPE_FRAME_TIME);
+	}
+	else if ( m_ahead)
+	{
+		deadline =earliestDeadline( deadline, SWYPE_FRAME_TIME);
+	}
+	return deadline;
+}
+
+/** @brief Move to a position from the fling, which may be past the edges.
+ *  @param position [in] New scroll offset in pixels.
+ */
+void CswypeDialog::setScroll( double position)
+{
+	double overscroll =(m_horizontal ? m_rect.width():m_rect.height())*2.0;
+	position =gLimit( position, -overscroll, scrollMax()+overscroll);
+	if ( (int)(position+0.5) !=(int)(m_scroll+0.5))
+	{
+		m_repaint =true;
+		m_ahead =true;
+	}
+	m_scroll =position;
+	calculateSurfacePosition();
+}
+
 /** @brief Stop auto scroll of the swipe dialog */
 void CswypeDialog::clearSpeed()
 {
@@ -1036,71 +1241,223 @@ void CswypeDialog::wheelDown( int mx, int my)
 /// @brief constructor.
 Cspeeding::Cspeeding()
 : m_measurements(0)
-, m_previousTime(0)
+, m_head(0)
+, m_decay(1.0)
+, m_velocity(0)
+, m_clock(0)
+, m_target(0)
+, m_flinging(false)
+, m_settling(false)
+{
+	for ( int n=0; n<MEASUREMENTS; n++)
+	{
+		m_position[n] =0;
+		m_time[n] =0;
+	}
+	// swype_friction halves the speed in 10000/swype_friction milliseconds.
+	double friction =Cgraphics::m_defaults.swype_friction*M_LN2/10.0;
+	m_decay =exp( -friction*SPEEDING_STEP);
+}
+
+/** @brief Monotonic time, not changed by setting the clock.
+ *  @return Seconds.
+ */
+double Cspeeding::now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec+(double)ts.tv_nsec/1000000000.0;
+}
+
+/** @brief Stop moving and forget the drag samples. */
+void Cspeeding::clear()
 {
-	m_friction =Cgraphics::m_defaults.swype_friction;
+	m_measurements =0;
+	m_velocity =0;
+	m_flinging =false;
+	m_settling =false;
 }
 
-/** @brief Add a new position to the speeding
- *  @param position [in] Relative position to add to the speed
+/** @brief Add a new position while dragging
+ *  @param position [in] Scroll offset in pixels
  */
 void Cspeeding::addPosition( double position)
 {
-	// ( "Add position %f", position);
-	if ( (int)position ==(int)m_position[0])
+	double t =now();
+	m_flinging =false;
+	m_settling =false;
+	if ( m_measurements>0)
+	{
+		double delta_t =t-m_time[m_head];
+		if ( delta_t>SPEEDING_WINDOW)
+		{
+			// Finger rested, older samples say nothing about the speed.
+			m_measurements =0;
+		}
+		else if ( delta_t<0.001)
+		{
+			// Same time, no use to record timestamps.
+			m_position[m_head] =position;
+			return;
+		}
+	}
+	m_head =(m_head+1)%MEASUREMENTS;
+	m_position[m_head] =position;
+	m_time[m_head] =t;
+	if ( m_measurements<MEASUREMENTS) m_measurements++;
+}
+
+/** @brief Least squares speed over the last drag samples.
+ *  @return Pixels per second, 0 when the finger rested before release.
+ */
+double Cspeeding::velocity()
+{
+	if ( m_measurements<2)
+	{
+		return 0;
+	}
+	double newest =m_time[m_head];
+	if ( now()-newest >SPEEDING_WINDOW)
+	{
+		return 0;
+	}
+	int count =0;
+	double sumT =0;
+	double sumX =0;
+	for ( int n=0; n<m_measurements; n++)
+	{
+		int k =(m_head-n+MEASUREMENTS)%MEASUREMENTS;
+		if ( newest-m_time[k] >SPEEDING_WINDOW)
+		{
+			break;
+		}
+		sumT +=m_time[k]-newest;
+		sumX +=m_position[k];
+		count++;
+	}
+	if ( count<2)
 	{
-		return; // same position.
+		return 0;
 	}
-	int now =Ctimeout::GetTickCount();
-	int delta_t=m_previousTime-now;
-	if ( delta_t<0) { delta_t =now-m_previousTime; }
-	m_previousTime =now;
-	if ( delta_t>4000)
+	double meanT =sumT/count;
+	double meanX =sumX/count;
+	double covariance =0;
+	double variance =0;
+	for ( int n=0; n<count; n++)
 	{
+		int k =(m_head-n+MEASUREMENTS)%MEASUREMENTS;
+		double t =m_time[k]-newest-meanT;
+		covariance +=t*(m_position[k]-meanX);
+		variance +=t*t;
+	}
+	return ( variance>1e-9) ? covariance/variance:0;
+}
+
+/** @brief Move the fling on to the current time.
+ *  @param position [in,out] Scroll offset in pixels.
+ *  @param maximum [in] Largest scroll offset without overscroll.
+ *  @param snap [in] Row size in pixels to stop on, 0 to stop anywhere.
+ *  @return true when the position changed.
+ */
+bool Cspeeding::step( double &position, double maximum, double snap)
+{
+	if ( !m_flinging)
+	{
+		if ( m_measurements ==0)
+		{
+			return false;
+		}
+		// Finger released: start the fling.
+		m_velocity =( Cgraphics::m_defaults.swype_friction>1000) ? 0:velocity();
 		m_measurements =0;
+		m_flinging =true;
+		m_settling =false;
+		m_clock =now();
+	}
+	double t =now();
+	double start =position;
+	int steps =0;
+	while ( m_flinging && m_clock+SPEEDING_STEP<=t)
+	{
+		integrate( position, maximum, snap);
+		m_clock +=SPEEDING_STEP;
+		if ( ++steps>=SPEEDING_MAX_STEPS)
+		{
+			m_clock =t;
+			break;
+		}
+	}
+	return position !=start;
+}
+
+/** @brief One fixed step of the fling.
+ *  @param position [in,out] Scroll offset in pixels.
+ *  @param maximum [in] Largest scroll offset without overscroll.
+ *  @param snap [in] Row size in pixels, 0 for none.
+ */
+void Cspeeding::integrate( double &position, double maximum, double snap)
+{
+	if ( position<0 || position>maximum)
+	{
+		// Overscroll: the edge pulls back.
+		m_settling =true;
+		m_target =( position<0) ? 0:maximum;
 	}
-	if ( delta_t<4)
+	else if ( !m_settling && fabs( m_velocity)<SPEEDING_SNAP_SPEED)
 	{
-		// Same time, no use to record timestamps.
-		m_position[0]=position;
+		m_settling =true;
+		m_target =position;
+		if ( snap>0)
+		{
+			m_target =gLimit( floor( position/snap+0.5)*snap, 0.0, maximum);
+		}
+	}
+	if ( !m_settling)
+	{
+		m_velocity *=m_decay;
+		position +=m_velocity*SPEEDING_STEP;
 		return;
 	}
-	int n=( m_measurements>=MEASUREMENTS) ? MEASUREMENTS-1:m_measurements;
-	for ( int x=n-1; x>=0; x--)
+	// Critically damped spring, no bounce.
+	double omega =sqrt( SPEEDING_SPRING);
+	double accelerate =-SPEEDING_SPRING*(position-m_target)-2.0*omega*m_velocity;
+	m_velocity +=accelerate*SPEEDING_STEP;
+	position +=m_velocity*SPEEDING_STEP;
+	if ( fabs( position-m_target)<0.5 && fabs( m_velocity)<SPEEDING_SNAP_SPEED/10.0)
 	{
-		m_position[x+1] =m_position[x];
-		m_time[x+1] =m_time[x];
+		position =m_target;
+		m_velocity =0;
+		m_flinging =false;
+		m_settling =false;
 	}
-	m_position[0] =position;
-    m_time[0] =(double)delta_t;
-    if ( m_measurements<MEASUREMENTS) m_measurements++;
 }
 
 /** @brief Get speed to run now
- *  @return speed in pixels
+ *  @return speed in pixels per frame
  */
 double Cspeeding::getSpeed()
 {
-	if ( m_measurements==0)
-	{
-		return 0;
-	}
-	double totalSpeed =0;
-	/// Calculate speeds.
-	for ( int n=0; n<m_measurements-1; n++)
+	double speed =m_flinging ? m_velocity:velocity();
+	return speed*SWYPE_FRAME_TIME/1000.0;
+}
+
+/** @brief Check if the list moves, so the loop must wake for it.
+ *  A finger resting on the list does not count.
+ *  @return true while flinging or springing, or when the last drag sample moved.
+ */
+bool Cspeeding::isMoving()
+{
+	if ( m_flinging)
 	{
-		m_speed[n] =(m_position[n+1]-m_position[n])/(m_time[n]+0.001);
-		totalSpeed -=m_speed[n];
+		return true;
 	}
-	int now=Ctimeout::GetTickCount();
-	int delta_t=m_previousTime-now;
-	if ( delta_t<0) { delta_t =now-m_previousTime; }
-	if ( delta_t<20 || m_friction>1000)
+	if ( m_measurements<2)
 	{
-		return 0;
+		return false;
 	}
-	//totalSpeed/=(1+m_friction*y);
-	return totalSpeed*1000.0f/(1000.0f+(delta_t*m_friction)/10.0f);
+	int previous =(m_head-1+MEASUREMENTS)%MEASUREMENTS;
+	return (   m_position[m_head] !=m_position[previous]
+			&& now()-m_time[m_head] <=SPEEDING_WINDOW);
 }
 
 /** @brief Paint one item in the list again
@@ -1113,21 +1470,10 @@ void CswypeDialog::invalidate( int row)
 		m_repaint =true;
 		return;
 	}
-	int idx;
-	CswypeObject *obj;
-	int sz=(int)m_swypeObjects.size();
-	for ( idx=0; idx<sz; idx++)
+	if ( row>=m_firstUnitPainted && row<m_lastUnitPainted)
 	{
-		obj =m_swypeObjects[ idx];
-		if ( obj && obj->index ==row)
-		{
-			graphics()->setRenderArea( obj->texture);
-			Crect rect( 0, 0, obj->destination.width(), obj->destination.height());
-			onPaintUnit( row, rect);
-			graphics()->setRenderArea( NULL);
-			m_repaint =true;
-			break;
-		}
+		paintTile( tile( row));
+		m_repaint =true;
 	}
 }
 
@@ -146,22 +146,13 @@ void Ctext::onPaint( int touch)
 void Ctext::onPaint( const std::string &text, int touch)
 {
 	(void)touch;
-	utf8string zs(text); // Conversion old format.
-	std::string t(zs);
-	TTF_Font *f=m_font.local.font;
-	for ( int a=0; a<(int)zs.size(); a++)
-	{
-		if ( zs[a]>16384) // && zs[a]!=0x20ac)
-		{
-			f=m_font.chinese.font;
-			break;
-		}
-	}
-	if (!f)
+	// Chinese parts are painted with the Chinese font, the rest local.
+	StextFonts fonts( CtextFont::styled( m_font.local.font, m_style),
+			          CtextFont::styled( m_font.chinese.font, m_style));
+	if ( !fonts.font[SCRIPT_LOCAL])
 	{
 		return;
 	}
-	TTF_SetFontStyle( f, m_style);
 	Crect rect( m_rect*8);
 	rect =Crect( rect.left()+m_horizontal_margin, rect.top()+m_vertical_margin,
 			     rect.width()-2*m_horizontal_margin, rect.height()-2*m_vertical_margin);
@@ -169,9 +160,9 @@ void Ctext::onPaint( const std::string &text, int touch)
 	{
 		Crect rectp=rect;
 		rectp.addLeft(1); rectp.addTop(1);
-		CtextSurface surface1( m_graphics, t, rectp, m_cursor, m_gravity, m_shadow, m_cursorColour, f);
+		CtextSurface surface1( m_graphics, text, rectp, m_cursor, m_gravity, m_shadow, m_cursorColour, fonts);
 	}
-	CtextSurface surface2( m_graphics, t, rect, m_cursor, m_gravity, m_colour, m_cursorColour, f);
+	CtextSurface surface2( m_graphics, text, rect, m_cursor, m_gravity, m_colour, m_cursorColour, fonts);
 }
 
 /*============================================================================*/
@@ -186,6 +177,7 @@ void Ctext::setTextId( textId textId)
 	m_textId =textId;
 	m_value ="";
 	m_useTextId =true;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -198,6 +190,7 @@ void Ctext::setTextId( textId textId)
 void Ctext::setColour( colour text)
 {
 	m_colour =text;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -212,6 +205,7 @@ void Ctext::setText( const std::string &textId)
 	m_textId =INVALID_TEXT_ID;
 	m_value =textId;
 	m_useTextId =false;
+	invalidate();
 }
 
 /*============================================================================*/
@@ -0,0 +1,215 @@
+/*============================================================================*/
+/**  @file       sdl_text_cache.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Keep rendered text lines between frames.
+ **
+ **  Cache for the finished line layout of a CtextSurface.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtextCache
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include "sdl_text_cache.h"
+
+/** @brief Constructor, empty cache. */
+CtextCache::CtextCache()
+: m_bytes(0)
+{
+}
+
+/** @brief Destructor, release all textures. */
+CtextCache::~CtextCache()
+{
+	clear();
+}
+
+/** @brief Paint a text from the cache.
+ *  @param key [in] What text to find.
+ *  @param graphics [in] Where to paint.
+ *  @param left [in] Left position of the text rectangle in pixels.
+ *  @param top [in] Top position of the text rectangle in pixels.
+ *  @param count [in] Count a hit or miss, false for a text just stored.
+ *  @return true when found and painted, false when the text must be rendered.
+ */
+bool CtextCache::paint( const StextKey &key, Cgraphics *graphics, int left, int top, bool count)
+{
+	if ( graphics ==NULL || Cgraphics::m_defaults.text_cache_size<=0)
+	{
+		return false;
+	}
+	m_lock.lock();
+	std::map<StextKey, StextLayout>::iterator it =m_layouts.find( key);
+	if ( it ==m_layouts.end())
+	{
+		if ( count)
+		{
+			Cgraphics::m_defaults.text_cache_misses++;
+		}
+		m_lock.unlock();
+		return false;
+	}
+	if ( count)
+	{
+		Cgraphics::m_defaults.text_cache_hits++;
+	}
+	StextLayout &layout =it->second;
+	// Most recent to the front.
+	m_lru.splice( m_lru.begin(), m_lru, layout.lru);
+	for ( int a=0; a<(int)layout.lines.size(); a++)
+	{
+		StextLine &line =layout.lines[a];
+#ifdef USE_SDL2
+		graphics->renderTexture( line.texture, left+line.x, top+line.y, line.w, line.h);
+#else
+		graphics->renderSurface( line.texture, left+line.x, top+line.y);
+#endif
+	}
+	m_lock.unlock();
+	return true;
+}
+
+/** @brief Store a finished layout.
+ *  @param key [in] What text is rendered.
+ *  @param graphics [in] Graphics the text is painted on.
+ *  @param surfaces [in] One surface per line, still owned by the caller.
+ *  @param positions [in] Position per line relative to the text rectangle.
+ *  @return true when stored.
+ */
+bool CtextCache::store( const StextKey &key,
+		                Cgraphics *graphics,
+		                const std::vector<SDL_Surface*> &surfaces,
+		                const std::vector<SDL_Rect> &positions)
+{
+	int budget =Cgraphics::m_defaults.text_cache_size;
+	if ( graphics ==NULL || budget<=0)
+	{
+		return false;
+	}
+#ifdef USE_SDL2
+	SDL_Renderer *renderer =graphics->getRenderer();
+	if ( renderer ==NULL)
+	{
+		return false;
+	}
+#endif
+	StextLayout layout;
+	layout.bytes =(int)key.text.size();
+	for ( int a=0; a<(int)positions.size() && a<(int)surfaces.size(); a++)
+	{
+		SDL_Surface *s =surfaces[a];
+		StextLine line;
+		line.x =positions[a].x;
+		line.y =positions[a].y;
+		line.w =s->w;
+		line.h =s->h;
+#ifdef USE_SDL2
+		line.texture =SDL_CreateTextureFromSurface( renderer, s);
+#else
+		line.texture =SDL_ConvertSurface( s, s->format, s->flags);
+#endif
+		if ( line.texture ==NULL)
+		{
+			release( layout);
+			return false;
+		}
+		layout.bytes +=s->w*s->h*4;
+		layout.lines.push_back( line);
+	}
+	if ( layout.bytes>budget/4)
+	{
+		// One text should never flush the complete cache.
+		release( layout);
+		return false;
+	}
+	m_lock.lock();
+	std::map<StextKey, StextLayout>::iterator it =m_layouts.find( key);
+	if ( it !=m_layouts.end())
+	{
+		// Another thread was faster.
+		m_lock.unlock();
+		release( layout);
+		return true;
+	}
+	evict( budget-layout.bytes);
+	m_lru.push_front( key);
+	layout.lru =m_lru.begin();
+	m_layouts[key] =layout;
+	m_bytes +=layout.bytes;
+	m_lock.unlock();
+	return true;
+}
+
+/** @brief Remove least recently used texts until we fit in the budget.
+ *  @param budget [in] Maximum bytes in use after eviction.
+ */
+void CtextCache::evict( int budget)
+{
+	while ( m_bytes>budget && !m_lru.empty())
+	{
+		std::map<StextKey, StextLayout>::iterator it =m_layouts.find( m_lru.back());
+		m_lru.pop_back();
+		if ( it !=m_layouts.end())
+		{
+			m_bytes -=it->second.bytes;
+			release( it->second);
+			m_layouts.erase( it);
+		}
+	}
+}
+
+/** @brief Release all textures of a layout.
+ *  @param layout [in] Layout to clean.
+ */
+void CtextCache::release( StextLayout &layout)
+{
+	for ( int a=0; a<(int)layout.lines.size(); a++)
+	{
+#ifdef USE_SDL2
+		SDL_DestroyTexture( layout.lines[a].texture);
+#else
+		SDL_FreeSurface( layout.lines[a].texture);
+#endif
+	}
+	layout.lines.clear();
+}
+
+/** @brief Remove all texts, e.g. when fonts or renderer are closed. */
+void CtextCache::clear()
+{
+	m_lock.lock();
+	for ( std::map<StextKey, StextLayout>::iterator it =m_layouts.begin(); it !=m_layouts.end(); ++it)
+	{
+		release( it->second);
+	}
+	m_layouts.clear();
+	m_lru.clear();
+	m_bytes =0;
+	m_lock.unlock();
+}
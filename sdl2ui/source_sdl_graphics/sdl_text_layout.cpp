@@ -0,0 +1,416 @@
+/*============================================================================*/
+/**  @file       sdl_text_layout.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Break text into lines that fit a width.
+ **
+ **  A paragraph is measured once: the advance of every character is added
+ **  into a prefix table, so the width of any first part is one lookup.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtextLayout
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include <algorithm>
+#include "sdl_text_layout.h"
+#include "text_splitter.h"
+
+/// Most wraps remembered, one per font and width.
+#define MAX_WRAPS	64
+
+/** @brief Constructor, nothing measured yet. */
+CtextLayout::CtextLayout()
+{
+}
+
+/** @brief Destructor. */
+CtextLayout::~CtextLayout()
+{
+	clear();
+}
+
+/** @brief Forget all advances and wraps, e.g. when fonts are closed. */
+void CtextLayout::clear()
+{
+	m_lock.lock();
+	m_glyphs.clear();
+	m_wraps.clear();
+	m_lock.unlock();
+}
+
+/** @brief Ask the font for the advance of one character.
+ *  @param font [in] Font to use.
+ *  @param character [in] Unicode value.
+ *  @return Advance in pixels.
+ */
+int CtextLayout::glyphAdvance( TTF_Font *font, int character)
+{
+	int minx, maxx, miny, maxy, advance;
+	if ( character <=0xffff
+	  && TTF_GlyphMetrics( font, (Uint16)character, &minx, &maxx, &miny, &maxy, &advance) ==0)
+	{
+		return advance;
+	}
+	// Outside the basic plane, let SDL_ttf measure the character.
+	utf8string s;
+	s.push_back( character);
+	int w =0, h =0;
+	TTF_SizeUTF8( font, s.c_str(), &w, &h);
+	return w;
+}
+
+/** @brief Advances and kerning of one font, filled the first time.
+ *  Latin-1 advances and kerning between ASCII characters are asked from
+ *  FreeType once, so common text is measured from the tables only.
+ *  @param font [in] Font to use.
+ *  @return Tables for the font in its current style.
+ */
+SglyphTable &CtextLayout::table( TTF_Font *font)
+{
+	std::pair<TTF_Font*,int> key( font, TTF_GetFontStyle( font));
+	std::map< std::pair<TTF_Font*,int>, SglyphTable>::iterator it =m_glyphs.find( key);
+	if ( it !=m_glyphs.end())
+	{
+		return it->second;
+	}
+	SglyphTable &table =m_glyphs[key];
+	for ( int a=0; a<256; a++)
+	{
+		table.low[a] =glyphAdvance( font, a);
+	}
+	table.kerning =false;
+#ifdef SDL_TTF_VERSION_ATLEAST
+	if ( TTF_GetFontKerning( font))
+	{
+		table.kerning =true;
+		for ( int a=0; a<KERN_CHARACTERS; a++)
+		for ( int b=0; b<KERN_CHARACTERS; b++)
+		{
+			table.kern[a][b] =(short)TTF_GetFontKerningSizeGlyphs( font, (Uint16)(a+' '), (Uint16)(b+' '));
+		}
+	}
+#endif
+	return table;
+}
+
+/** @brief Fill the tables of a font before it is used.
+ *  @param font [in] Newly opened font.
+ */
+void CtextLayout::prepare( TTF_Font *font)
+{
+	if ( !font)
+	{
+		return;
+	}
+	m_lock.lock();
+	table( font);
+	m_lock.unlock();
+}
+
+/** @brief Advance of one character, asked once per font and style.
+ *  @param font [in] Font to use.
+ *  @param character [in] Unicode value.
+ *  @return Advance in pixels.
+ */
+int CtextLayout::advance( TTF_Font *font, int character)
+{
+	m_lock.lock();
+	SglyphTable &t =table( font);
+	int result;
+	if ( character>=0 && character<256)
+	{
+		result =t.low[character];
+	}
+	else
+	{
+		std::map<int,int>::iterator g =t.high.find( character);
+		if ( g ==t.high.end())
+		{
+			g =t.high.insert( std::make_pair( character, glyphAdvance( font, character))).first;
+		}
+		result =g->second;
+	}
+	m_lock.unlock();
+	return result;
+}
+
+/** @brief Kerning between two characters of one font.
+ *  @param font [in] Font to use.
+ *  @param previous [in] Character on the left.
+ *  @param character [in] Character on the right.
+ *  @return Pixels to add.
+ */
+int CtextLayout::kerning( TTF_Font *font, int previous, int character)
+{
+#ifdef SDL_TTF_VERSION_ATLEAST
+	SglyphTable &t =table( font);
+	if ( !t.kerning)
+	{
+		return 0;
+	}
+	int a =previous-' ';
+	int b =character-' ';
+	if ( a>=0 && a<KERN_CHARACTERS && b>=0 && b<KERN_CHARACTERS)
+	{
+		return t.kern[a][b];
+	}
+	return TTF_GetFontKerningSizeGlyphs( font, (Uint16)previous, (Uint16)character);
+#else
+	(void)font;
+	(void)previous;
+	(void)character;
+	return 0;
+#endif
+}
+
+/** @brief Width of every first part of a text.
+ *  @param fonts [in] Font per script.
+ *  @param text [in] Text to measure.
+ *  @param prefix [out] Width of the first n characters at index n.
+ */
+void CtextLayout::measure( const StextFonts &fonts, const utf8string &text, std::vector<int> &prefix)
+{
+	prefix.clear();
+	prefix.reserve( text.size()+1);
+	prefix.push_back( 0);
+	TTF_Font *last =NULL;
+	int previous =0;
+	m_lock.lock();
+	for ( utf8string::const_iterator it =text.begin(); it !=text.end(); ++it)
+	{
+		int character =*it;
+		TTF_Font *font =fonts.font[ CtextScript::script( character)];
+		int width =prefix.back()+advance( font, character);
+		if ( font ==last)
+		{
+			width +=kerning( font, previous, character);
+		}
+		prefix.push_back( width);
+		last =font;
+		previous =character;
+	}
+	m_lock.unlock();
+}
+
+/** @brief Find the longest first part that fits.
+ *  @param prefix [in] Width per number of characters.
+ *  @param from [in] Fewest characters to try.
+ *  @param to [in] Most characters to try.
+ *  @param width [in] Available pixels.
+ *  @return Number of characters, from-1 when even from does not fit.
+ */
+int CtextLayout::fitting( const std::vector<int> &prefix, int from, int to, int width)
+{
+	int low =from;
+	int high =to;
+	while ( low<=high)
+	{
+		int mid =(low+high)/2;
+		if ( prefix[mid]<=width)
+		{
+			low =mid+1;
+		}
+		else
+		{
+			high =mid-1;
+		}
+	}
+	return high;
+}
+
+/** @brief Put as many words as fit on one line.
+ *  @param fonts [in] Font per script.
+ *  @param width [in] Available pixels, 0 is no limit.
+ *  @param paragraph [in] Text to wrap.
+ *  @param lines [in,out] Line added when anything fits.
+ *  @param carry [out] Words for the next paragraph.
+ *  @return false when not even one character fits.
+ */
+bool CtextLayout::wrapParagraph( const StextFonts &fonts, int width, const utf8string &paragraph,
+		                         std::vector<SlayoutLine> &lines, std::string &carry)
+{
+	carry.clear();
+	CtextSplitter word( paragraph.str(), " ", "\t");
+	if ( word.size() ==0)
+	{
+		return true;
+	}
+	// Words joined by one space, end of each word in characters.
+	utf8string joined( word[0]);
+	std::vector<int> ends;
+	ends.push_back( (int)joined.size());
+	std::string rest;
+	for ( int a=1; a<word.size(); a++)
+	{
+		utf8string w( word[a]);
+		rest +=" "+w.str();
+		ends.push_back( ends.back()+1+(int)w.size());
+	}
+	joined.push_back( rest);
+	std::vector<int> prefix;
+	measure( fonts, joined, prefix);
+
+	SlayoutLine line;
+	if ( width !=0 && prefix[ ends[0]]>width)
+	{
+		// Even the first word does not fit, break it.
+		int i =fitting( prefix, 1, ends[0], width);
+		if ( i<=0)
+		{
+			return false;
+		}
+		line.text =joined.sub( 0, i);
+		line.split =true;
+		line.characters =i;
+		lines.push_back( line);
+		carry =joined.sub( i);
+		if ( ends.size()>1)
+		{
+			carry +=" ";
+		}
+		return true;
+	}
+	// Last word that still fits.
+	int low =0;
+	int high =(int)ends.size()-1;
+	if ( width !=0)
+	{
+		while ( low<high)
+		{
+			int mid =(low+high+1)/2;
+			if ( prefix[ ends[mid]]<=width)
+			{
+				low =mid;
+			}
+			else
+			{
+				high =mid-1;
+			}
+		}
+	}
+	int last =high;
+	if ( ends[last]>0)
+	{
+		line.text =joined.sub( 0, ends[last]);
+		line.split =false;
+		line.characters =ends[last]+1;
+		lines.push_back( line);
+	}
+	if ( last+1<(int)ends.size())
+	{
+		carry =joined.sub( ends[last]+1)+" ";
+	}
+	return true;
+}
+
+/** @brief Break paragraphs into lines. Words that do not fit move to the
+ *         front of the next paragraph. The previous wrap with the same fonts
+ *         and width is kept up to the first changed paragraph.
+ *  @param fonts [in] Font per script.
+ *  @param width [in] Available pixels, 0 is no limit.
+ *  @param paragraphs [in] Text split at new lines.
+ *  @param lines [out] Lines to render.
+ */
+void CtextLayout::wrap( const StextFonts &fonts, int width,
+		                const std::vector<utf8string> &paragraphs,
+		                std::vector<SlayoutLine> &lines)
+{
+	m_lock.lock();
+	SwrapKey key;
+	key.local =fonts.font[SCRIPT_LOCAL];
+	key.cjk =fonts.font[SCRIPT_CJK];
+	key.style =TTF_GetFontStyle( key.local);
+	key.width =width;
+	if ( m_wraps.size()>=MAX_WRAPS && m_wraps.find( key) ==m_wraps.end())
+	{
+		m_wraps.clear();
+	}
+	SwrapState &state =m_wraps[key];
+
+	// First paragraph that differs from the last wrap.
+	int same =0;
+	if ( state.linesBefore.size())
+	{
+		int most =(int)std::min( paragraphs.size(), state.paragraphs.size());
+		while ( same<most && paragraphs[same].str() ==state.paragraphs[same].str())
+		{
+			same++;
+		}
+		if ( same ==(int)paragraphs.size() && same ==(int)state.paragraphs.size())
+		{
+			lines =state.lines;
+			m_lock.unlock();
+			return;
+		}
+		if ( state.stopped>=0 && state.stopped<same)
+		{
+			// Stopped before the change, nothing else to paint.
+			state.paragraphs =paragraphs;
+			lines =state.lines;
+			m_lock.unlock();
+			return;
+		}
+		if ( same>=(int)state.linesBefore.size())
+		{
+			same =0;
+		}
+	}
+	std::string carry;
+	if ( same>0)
+	{
+		state.lines.resize( state.linesBefore[same]);
+		carry =state.carry[same];
+	}
+	else
+	{
+		state.lines.clear();
+	}
+	state.linesBefore.resize( same);
+	state.carry.resize( same);
+	state.paragraphs =paragraphs;
+	state.stopped =-1;
+
+	for ( int p=same; p<(int)paragraphs.size() || carry.size(); p++)
+	{
+		state.linesBefore.push_back( (int)state.lines.size());
+		state.carry.push_back( carry);
+		utf8string paragraph( carry);
+		if ( p<(int)paragraphs.size())
+		{
+			paragraph.push_back( paragraphs[p].str());
+		}
+		if ( !wrapParagraph( fonts, width, paragraph, state.lines, carry))
+		{
+			state.stopped =p;
+			break;
+		}
+	}
+	lines =state.lines;
+	m_lock.unlock();
+}
@@ -0,0 +1,283 @@
+/*============================================================================*/
+/**  @file       sdl_text_script.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Choose the font per part of a text.
+ **
+ **  The script of a character is found by binary search in a table of
+ **  code point ranges. Text without any character from the table is passed
+ **  to SDL_ttf directly, without splitting.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtextScript
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include "sdl_text_script.h"
+#include "utf8string.h"
+
+/// @brief Code point range painted with one script.
+typedef struct
+{
+	int		first;	///< First character.
+	int		last;	///< Last character.
+	Escript	script;	///< Font to use.
+} SscriptRange;
+
+/// @brief Ranges sorted by first character, all others are local.
+static const SscriptRange scriptRanges[] =
+{
+	{ 0x01100, 0x011ff, SCRIPT_CJK }, // Hangul Jamo
+	{ 0x02e80, 0x04dbf, SCRIPT_CJK }, // Radicals, punctuation, kana, bopomofo, extension A
+	{ 0x04e00, 0x09fff, SCRIPT_CJK }, // Unified ideographs
+	{ 0x0a960, 0x0a97f, SCRIPT_CJK }, // Hangul Jamo extended A
+	{ 0x0ac00, 0x0d7ff, SCRIPT_CJK }, // Hangul syllables, Jamo extended B
+	{ 0x0f900, 0x0faff, SCRIPT_CJK }, // Compatibility ideographs
+	{ 0x0fe30, 0x0fe4f, SCRIPT_CJK }, // Compatibility forms
+	{ 0x0ff00, 0x0ffef, SCRIPT_CJK }, // Half- and full-width forms
+	{ 0x20000, 0x3ffff, SCRIPT_CJK }, // Extension B and later
+};
+
+#define SCRIPT_RANGES	(int)(sizeof(scriptRanges)/sizeof(scriptRanges[0]))
+
+/** @brief Find the script of one character.
+ *  @param character [in] Unicode value.
+ *  @return Script, local when not in the table.
+ */
+Escript CtextScript::script( int character)
+{
+	if ( character <scriptRanges[0].first)
+	{
+		return SCRIPT_LOCAL;
+	}
+	int low =0;
+	int high =SCRIPT_RANGES-1;
+	while ( low<=high)
+	{
+		int mid =(low+high)/2;
+		if ( character <scriptRanges[mid].first)
+		{
+			high =mid-1;
+		}
+		else if ( character >scriptRanges[mid].last)
+		{
+			low =mid+1;
+		}
+		else
+		{
+			return scriptRanges[mid].script;
+		}
+	}
+	return SCRIPT_LOCAL;
+}
+
+/** @brief Split a text in runs of one script. A space continues the
+ *         current run, so words of one script stay together.
+ *  @param text [in] UTF-8 text.
+ *  @param runs [out] Runs from left to right.
+ */
+void CtextScript::split( const std::string &text, std::vector<StextRun> &runs)
+{
+	runs.clear();
+	const char *s =text.c_str();
+	int offset =0;
+	while ( s[offset])
+	{
+		int length =utf8string::characterLength( s+offset);
+		int character =utf8string::utf8character( s+offset);
+		if ( runs.size() && character ==' ')
+		{
+			runs.back().bytes +=length;
+		}
+		else
+		{
+			Escript sc =script( character);
+			if ( runs.size() ==0 || runs.back().script !=sc)
+			{
+				StextRun run;
+				run.offset =offset;
+				run.bytes =0;
+				run.script =sc;
+				runs.push_back( run);
+			}
+			runs.back().bytes +=length;
+		}
+		offset +=length;
+	}
+}
+
+/** @brief Check whether one font paints the whole text.
+ *  @param text [in] UTF-8 text.
+ *  @param fonts [in] Font per script.
+ *  @param font [out] The font when only one is needed.
+ *  @return true when one font is enough.
+ */
+bool CtextScript::single( const std::string &text, const StextFonts &fonts, TTF_Font **font)
+{
+	*font =fonts.font[SCRIPT_LOCAL];
+	if ( fonts.font[SCRIPT_CJK] ==fonts.font[SCRIPT_LOCAL])
+	{
+		return true;
+	}
+	utf8string zs( text);
+	if ( !zs.containsAbove( scriptRanges[0].first-1))
+	{
+		return true;
+	}
+	std::vector<StextRun> runs;
+	split( text, runs);
+	if ( runs.size()>1)
+	{
+		return false;
+	}
+	if ( runs.size() ==1)
+	{
+		*font =fonts.font[ runs[0].script];
+	}
+	return true;
+}
+
+/** @brief Size of a text painted with more fonts. Runs are put on one
+ *         baseline, the height includes the tallest font.
+ *  @param text [in] UTF-8 text.
+ *  @param fonts [in] Font per script.
+ *  @param w [out] Width in pixels.
+ *  @param h [out] Height in pixels.
+ *  @return 0 when correct, -1 on error like TTF_SizeUTF8.
+ */
+int CtextScript::size( const std::string &text, const StextFonts &fonts, int *w, int *h)
+{
+	TTF_Font *font;
+	if ( single( text, fonts, &font))
+	{
+		return TTF_SizeUTF8( font, text.c_str(), w, h);
+	}
+	std::vector<StextRun> runs;
+	split( text, runs);
+	int ascent =0;
+	for ( int a=0; a<(int)runs.size(); a++)
+	{
+		int fa =TTF_FontAscent( fonts.font[ runs[a].script]);
+		if ( fa>ascent) ascent =fa;
+	}
+	*w =0;
+	*h =0;
+	for ( int a=0; a<(int)runs.size(); a++)
+	{
+		TTF_Font *f =fonts.font[ runs[a].script];
+		int rw, rh;
+		if ( TTF_SizeUTF8( f, text.substr( runs[a].offset, runs[a].bytes).c_str(), &rw, &rh) !=0)
+		{
+			return -1;
+		}
+		*w +=rw;
+		int bottom =ascent-TTF_FontAscent( f)+rh;
+		if ( bottom>*h) *h =bottom;
+	}
+	return 0;
+}
+
+/** @brief Render a text, each run in its own font.
+ *  @param text [in] UTF-8 text.
+ *  @param fonts [in] Font per script.
+ *  @param fg [in] Colour of the characters.
+ *  @param blended [in] Anti-aliased or solid characters.
+ *  @return New surface, NULL on error.
+ */
+SDL_Surface *CtextScript::render( const std::string &text, const StextFonts &fonts,
+		                          SDL_Color fg, bool blended)
+{
+	TTF_Font *font;
+	if ( single( text, fonts, &font))
+	{
+		return blended ? TTF_RenderUTF8_Blended( font, text.c_str(), fg):
+						 TTF_RenderUTF8_Solid( font, text.c_str(), fg);
+	}
+	std::vector<StextRun> runs;
+	split( text, runs);
+	std::vector<SDL_Surface*> parts;
+	int ascent =0;
+	for ( int a=0; a<(int)runs.size(); a++)
+	{
+		int fa =TTF_FontAscent( fonts.font[ runs[a].script]);
+		if ( fa>ascent) ascent =fa;
+	}
+	int w =0;
+	int h =0;
+	bool failed =false;
+	for ( int a=0; a<(int)runs.size(); a++)
+	{
+		TTF_Font *f =fonts.font[ runs[a].script];
+		std::string part =text.substr( runs[a].offset, runs[a].bytes);
+		SDL_Surface *s =blended ? TTF_RenderUTF8_Blended( f, part.c_str(), fg):
+								  TTF_RenderUTF8_Solid( f, part.c_str(), fg);
+		parts.push_back( s);
+		if ( !s)
+		{
+			failed =true;
+			break;
+		}
+		w +=s->w;
+		int bottom =ascent-TTF_FontAscent( f)+s->h;
+		if ( bottom>h) h =bottom;
+	}
+	SDL_Surface *bitmap =NULL;
+	if ( !failed && w>0 && h>0)
+	{
+		bitmap =SDL_CreateRGBSurface( 0, w, h, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+	}
+	if ( bitmap)
+	{
+		// Same background as TTF_RenderUTF8_Blended, the cursor looks for it.
+		SDL_FillRect( bitmap, NULL, blended ? SDL_MapRGBA( bitmap->format, fg.r, fg.g, fg.b, 0):0);
+		int x =0;
+		for ( int a=0; a<(int)parts.size(); a++)
+		{
+			SDL_Rect dst;
+			dst.x =x;
+			dst.y =ascent-TTF_FontAscent( fonts.font[ runs[a].script]);
+			dst.w =parts[a]->w;
+			dst.h =parts[a]->h;
+			if ( blended)
+			{
+#ifdef USE_SDL2
+				SDL_SetSurfaceBlendMode( parts[a], SDL_BLENDMODE_NONE);
+#else
+				SDL_SetAlpha( parts[a], 0, SDL_ALPHA_OPAQUE);
+#endif
+			}
+			SDL_BlitSurface( parts[a], NULL, bitmap, &dst);
+			x +=parts[a]->w;
+		}
+	}
+	for ( int a=0; a<(int)parts.size(); a++)
+	{
+		if ( parts[a]) SDL_FreeSurface( parts[a]);
+	}
+	return bitmap;
+}
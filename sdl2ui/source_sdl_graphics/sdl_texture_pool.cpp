@@ -0,0 +1,335 @@
+/*============================================================================*/
+/**  @file       sdl_texture_pool.cpp
+ **  @ingroup    sdl2ui
+ **  @brief		 Re-use textures to upload surfaces.
+ **
+ **  Size-bucketed pool of streaming textures.
+ **
+ **  @author     mensfort
+ **
+ **  @par Classes:
+ **              CtexturePool
+ */
+/*------------------------------------------------------------------------------
+ ** Copyright (C) 2011, 2014, 2015
+ ** Houkes Horeca Applications
+ **
+ ** This file is part of the SDL2UI Library.  This library is free
+ ** software; you can redistribute it and/or modify it under the
+ ** terms of the GNU General Public License as published by the
+ ** Free Software Foundation; either version 3, or (at your option)
+ ** any later version.
+
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+
+ ** Under Section 7 of GPL version 3, you are granted additional
+ ** permissions described in the GCC Runtime Library Exception, version
+ ** 3.1, as published by the Free Software Foundation.
+
+ ** You should have received a copy of the GNU General Public License and
+ ** a copy of the GCC Runtime Library Exception along with this program;
+ ** see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ ** <http://www.gnu.org/licenses/>
+ **===========================================================================*/
+
+/*------------- Standard includes --------------------------------------------*/
+#include <limits.h>
+#include <SDL_timer.h>
+#include "sdl_texture_pool.h"
+
+#ifdef USE_SDL2
+
+/// Smallest bucket in pixels.
+#define MINIMUM_BUCKET		16
+/// Free textures kept for later use.
+#define MAXIMUM_FREE_SLOTS	32
+/// Bits of a handle with the slot, the rest is the serial.
+#define SLOT_BITS			10
+/// Maximum number of slots.
+#define MAXIMUM_SLOTS		(1<<SLOT_BITS)
+/// Milliseconds without upload or paint before a busy texture is taken back.
+#define IDLE_SLOT_TIME		5000
+
+/** @brief Constructor, no textures yet. */
+CtexturePool::CtexturePool()
+: m_renderer(NULL)
+, m_free(0)
+, m_serial(0)
+{
+}
+
+/** @brief Destructor, destroy all textures. */
+CtexturePool::~CtexturePool()
+{
+	clear();
+}
+
+/** @brief Set renderer for new textures.
+ *  @param renderer [in] Renderer, textures of an old renderer are removed.
+ */
+void CtexturePool::setRenderer( SDL_Renderer *renderer)
+{
+	if ( renderer !=m_renderer)
+	{
+		clear();
+		m_renderer =renderer;
+	}
+}
+
+/** @brief Round a size up to the bucket size.
+ *  @param size [in] Width or height in pixels.
+ *  @return Power of two, at least MINIMUM_BUCKET.
+ */
+int CtexturePool::bucket( int size)
+{
+	int b=MINIMUM_BUCKET;
+	while ( b<size)
+	{
+		b <<=1;
+	}
+	return b;
+}
+
+/** @brief Find the slot of a handle.
+ *  @param handle [in] Result of upload().
+ *  @return Slot, -1 when the handle is invalid or taken back.
+ */
+int CtexturePool::slotOf( int handle)
+{
+	if ( handle<0)
+	{
+		return -1;
+	}
+	int a =handle & (MAXIMUM_SLOTS-1);
+	if (   a>=(int)m_slots.size() || !m_slots[a].busy
+		|| m_slots[a].serial !=( handle >> SLOT_BITS))
+	{
+		return -1;
+	}
+	return a;
+}
+
+/** @brief Make the handle for a busy slot.
+ *  @param slot [in] Index in m_slots.
+ *  @return Handle for the user.
+ */
+int CtexturePool::handleOf( int slot)
+{
+	return ( m_slots[slot].serial << SLOT_BITS) | slot;
+}
+
+/** @brief Find a free slot or create a new one.
+ *  @param width [in] Bucket width.
+ *  @param height [in] Bucket height.
+ *  @return Slot or -1.
+ */
+int CtexturePool::find( int width, int height)
+{
+	reclaim();
+	// A new serial, so old handles of the slot are rejected.
+	m_serial =( m_serial+1) & ( INT_MAX >> SLOT_BITS);
+	int empty =-1;
+	for ( int a=0; a<(int)m_slots.size(); a++)
+	{
+		StextureSlot &slot =m_slots[a];
+		if ( slot.busy)
+		{
+			continue;
+		}
+		if ( slot.texture && slot.width ==width && slot.height ==height)
+		{
+			slot.busy =true;
+			slot.serial =m_serial;
+			m_free--;
+			return a;
+		}
+		if ( slot.texture ==NULL && empty <0)
+		{
+			empty =a;
+		}
+	}
+	if ( empty <0 && (int)m_slots.size()>=MAXIMUM_SLOTS)
+	{
+		return -1;
+	}
+	SDL_Texture *texture =SDL_CreateTexture( m_renderer,
+			                                 SDL_PIXELFORMAT_ARGB8888,
+			                                 SDL_TEXTUREACCESS_STREAMING,
+			                                 width, height);
+	if ( texture ==NULL)
+	{
+		return -1;
+	}
+	SDL_SetTextureBlendMode( texture, SDL_BLENDMODE_BLEND);
+	StextureSlot slot;
+	slot.texture =texture;
+	slot.width =width;
+	slot.height =height;
+	slot.used_w =0;
+	slot.used_h =0;
+	slot.busy =true;
+	slot.serial =m_serial;
+	slot.last_used =0;
+	if ( empty <0)
+	{
+		m_slots.push_back( slot);
+		return (int)m_slots.size()-1;
+	}
+	m_slots[empty] =slot;
+	return empty;
+}
+
+/** @brief Copy a surface into a texture.
+ *  @param surface [in] Surface to upload.
+ *  @param handle [in] Previous handle for this surface, re-used when it fits.
+ *  @return Handle, valid until release() or until the surface content changes.
+ */
+int CtexturePool::upload( SDL_Surface *surface, int handle)
+{
+	if ( surface ==NULL || m_renderer ==NULL)
+	{
+		release( handle);
+		return INVALID_TEXTURE_HANDLE;
+	}
+	int width =bucket( surface->w);
+	int height =bucket( surface->h);
+	int a =slotOf( handle);
+	if ( a>=0 && ( m_slots[a].width !=width || m_slots[a].height !=height))
+	{
+		// Size changed, other bucket.
+		release( handle);
+		a =-1;
+	}
+	if ( a<0)
+	{
+		a =find( width, height);
+		if ( a<0)
+		{
+			return INVALID_TEXTURE_HANDLE;
+		}
+		handle =handleOf( a);
+	}
+	SDL_Surface *converted =NULL;
+	if ( surface->format->format !=SDL_PIXELFORMAT_ARGB8888)
+	{
+		converted =SDL_ConvertSurfaceFormat( surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if ( converted ==NULL)
+		{
+			release( handle);
+			return INVALID_TEXTURE_HANDLE;
+		}
+		surface =converted;
+	}
+	StextureSlot &slot =m_slots[a];
+	SDL_Rect rect;
+	rect.x =0;
+	rect.y =0;
+	rect.w =surface->w;
+	rect.h =surface->h;
+	SDL_LockSurface( surface);
+	SDL_UpdateTexture( slot.texture, &rect, surface->pixels, surface->pitch);
+	SDL_UnlockSurface( surface);
+	slot.used_w =surface->w;
+	slot.used_h =surface->h;
+	slot.last_used =SDL_GetTicks();
+	if ( converted)
+	{
+		SDL_FreeSurface( converted);
+	}
+	return handle;
+}
+
+/** @brief Get texture for a handle.
+ *  @param handle [in] Result of upload().
+ *  @param source [out] Part of the texture with the surface.
+ *  @return Texture or NULL for an invalid handle.
+ */
+SDL_Texture *CtexturePool::texture( int handle, SDL_Rect *source)
+{
+	int a =slotOf( handle);
+	if ( a<0)
+	{
+		return NULL;
+	}
+	StextureSlot &slot =m_slots[a];
+	slot.last_used =SDL_GetTicks();
+	if ( source)
+	{
+		source->x =0;
+		source->y =0;
+		source->w =slot.used_w;
+		source->h =slot.used_h;
+	}
+	return slot.texture;
+}
+
+/** @brief Give a texture back to the pool.
+ *  @param handle [in] Result of upload().
+ */
+void CtexturePool::release( int handle)
+{
+	int a =slotOf( handle);
+	if ( a<0)
+	{
+		return;
+	}
+	m_slots[a].busy =false;
+	m_free++;
+	if ( m_free>MAXIMUM_FREE_SLOTS)
+	{
+		trim();
+	}
+}
+
+/** @brief Take back textures a user has not uploaded or painted for a while,
+ *  e.g. the background of a dialog that is not shown.
+ */
+void CtexturePool::reclaim()
+{
+	Uint32 now =SDL_GetTicks();
+	for ( int a=0; a<(int)m_slots.size(); a++)
+	{
+		StextureSlot &slot =m_slots[a];
+		if ( slot.busy && slot.texture && now-slot.last_used>IDLE_SLOT_TIME)
+		{
+			// The handle is stale now, the next upload finds a new slot.
+			SDL_DestroyTexture( slot.texture);
+			slot.texture =NULL;
+			slot.busy =false;
+		}
+	}
+}
+
+/** @brief Destroy free textures when too many are kept. */
+void CtexturePool::trim()
+{
+	for ( int a=0; a<(int)m_slots.size() && m_free>MAXIMUM_FREE_SLOTS/2; a++)
+	{
+		StextureSlot &slot =m_slots[a];
+		if ( !slot.busy && slot.texture)
+		{
+			SDL_DestroyTexture( slot.texture);
+			slot.texture =NULL;
+			m_free--;
+		}
+	}
+}
+
+/** @brief Destroy all textures, handles are invalid afterwards. */
+void CtexturePool::clear()
+{
+	for ( int a=0; a<(int)m_slots.size(); a++)
+	{
+		if ( m_slots[a].texture)
+		{
+			SDL_DestroyTexture( m_slots[a].texture);
+		}
+	}
+	m_slots.clear();
+	m_free =0;
+}
+
+#endif
@@ -43,10 +43,12 @@
 #include "sdl_dialog.h"
 #include "sdl_dialog_list.h"
 #include "sdl_label.h"
+#include "sdl_image_loader.h"
+#include "sdl_font.h"
+#include "sdl_profiler.h"
 
 int Cworld::m_init = 0;
 pthread_t Cworld::m_main_thread = 0;
-CkeyFile Cworld::m_key_file;
 
 
 Cworld::Cworld(std::shared_ptr<Cgraphics> mainGraph)
@@ -55,6 +57,8 @@ Cworld::Cworld(std::shared_ptr<Cgraphics> mainGraph)
 , m_main_graph(mainGraph)
 , m_drag_point(0,0)
 , m_invalidate(false)
+, m_painting(false)
+, m_frozen(false)
 {
 }
 
@@ -63,7 +67,15 @@ void Cworld::init()
 	if (!m_init)
 	{
 		m_main_thread =pthread_self();
-		m_key_file.init();
+#ifdef USE_PROFILER
+		// Made here, before other threads add scopes.
+		Cprofiler::Instance();
+#endif
+		if ( Cgraphics::m_defaults.font_manifest.size())
+		{
+			// Open fonts now instead of during the first paint.
+			CtextFont::preload( Cgraphics::m_defaults.font_path+Cgraphics::m_defaults.font_manifest);
+		}
 	}
 	m_init++;
 }
@@ -79,7 +91,15 @@ void Cworld::addDialog( Cdialog *dialog)
 
 void Cworld::checkInMainThread()
 {
-	assert( pthread_self()==m_main_thread);
+	assert( inMainThread());
+}
+
+/** @brief Check if we may paint and handle events.
+ *  @return true when called from the thread that started the world.
+ */
+bool Cworld::inMainThread()
+{
+	return pthread_equal( pthread_self(), m_main_thread) !=0;
 }
 
 Cworld::~Cworld()
@@ -98,6 +118,7 @@ void Cworld::clean()
 		//CdialogBase *a;
 		m_lock.unlock(); // Children+Messageboxes should not change end.
 		CdialogEvent::Instance()->KillInstance();
+		CimageLoader::Instance()->KillInstance();
 	}
 }
 
@@ -106,11 +127,182 @@ void Cworld::invalidate()
 	m_invalidate = true;
 }
 
+/** @brief Damage part of the screen, only this part is painted again.
+ *  @param rect [in] Rectangle in pixels.
+ */
+void Cworld::invalidateRect( const Crect &rect)
+{
+	m_lock.lock();
+	if ( !m_painting)
+	{
+		m_damage.add( rect);
+	}
+	m_lock.unlock();
+}
+
+/** @brief Find how long the main loop may sleep without input.
+ *  @param dialog [in] Dialog running the loop.
+ *  @return Milliseconds until the next deadline.
+ */
+int Cworld::nextDeadline( Cdialog *dialog)
+{
+	int deadline =Cgraphics::m_defaults.maximum_idle_time;
+	if ( m_invalidate || !m_damage.isEmpty())
+	{
+		return 0;
+	}
+	if (   ( dialog && dialog->isInvalidated())
+		|| ( m_active_dialog && m_active_dialog->isInvalidated()))
+	{
+		// Paint first, the next frame is due now.
+		return 0;
+	}
+	if ( Cgraphics::m_defaults.get_test_event)
+	{
+		// Test events are not in the SDL queue.
+		deadline =earliestDeadline( deadline, 10);
+	}
+	deadline =earliestDeadline( deadline, CdialogEvent::Instance()->nextDeadline());
+	deadline =earliestDeadline( deadline, Ctimeout::nextDeadline());
+	if ( dialog)
+	{
+		deadline =earliestDeadline( deadline, dialog->nextDeadline());
+	}
+	if ( m_active_dialog && m_active_dialog !=dialog)
+	{
+		deadline =earliestDeadline( deadline, m_active_dialog->nextDeadline());
+	}
+	for ( auto a : m_message_box)
+	{
+		Cdialog *t=dynamic_cast<Cdialog*>(a);
+		if ( t && t->isInvalidated())
+		{
+			return 0;
+		}
+		if ( t && t !=dialog)
+		{
+			deadline =earliestDeadline( deadline, t->nextDeadline());
+		}
+	}
+	return deadline;
+}
+
+/** @brief Sleep until input arrives or the next deadline passes.
+ *  @param dialog [in] Dialog running the loop.
+ */
+void Cworld::waitEvent( Cdialog *dialog)
+{
+	PROFILE_IDLE( "Cworld::waitEvent");
+	int deadline =nextDeadline( dialog);
+	if ( deadline<0)
+	{
+		deadline =Cgraphics::m_defaults.maximum_idle_time;
+	}
+	if ( deadline>0)
+	{
+		CdialogEvent::Instance()->waitEvent( deadline);
+	}
+}
+
+/** @brief Check if the complete screen must be painted.
+ *  @return false when only the damage list is painted.
+ */
+bool Cworld::needsFullPaint()
+{
+	if (   m_invalidate
+		|| !Cgraphics::m_defaults.damage_tracking
+		|| Cgraphics::m_defaults.debug_coordinates
+		|| Cgraphics::m_defaults.debug_profiler
+		|| m_damage.isFull()
+		|| m_active_dialog ==NULL
+		|| !m_active_dialog->m_full_screen
+		|| m_active_dialog->m_myGraphics
+		|| m_active_dialog->isInvalidated()
+		|| !m_active_dialog->m_dragObject.isEmpty()
+		|| m_message_box.begin() !=m_message_box.end())
+	{
+		return true;
+	}
+	// Sub dialogs scroll and render themselves.
+	return m_active_dialog->m_children.begin() !=m_active_dialog->m_children.end();
+}
+
+/** @brief Paint and show only the damaged rectangles of the active dialog. */
+void Cworld::paintDamage()
+{
+	m_lock.lock();
+	if ( m_damage.isEmpty())
+	{
+		// Nothing changed, the screen stays as it is.
+		Cgraphics::m_defaults.painted_pixels =0;
+		m_lock.unlock();
+		return;
+	}
+	CdamageRegion damage( m_damage);
+	m_damage.clear();
+	m_painting =true;
+	m_lock.unlock();
+
+	const std::vector<Crect> &rects =damage.rects();
+	for ( int a=0; a<(int)rects.size(); a++)
+	{
+		SDL_Rect clip;
+		clip.x =rects[a].left();
+		clip.y =rects[a].top();
+		clip.w =rects[a].width();
+		clip.h =rects[a].height();
+		m_main_graph->setViewport( &clip);
+		m_active_dialog->onClearScreen( rects[a]);
+		m_active_dialog->onPaint();
+		m_active_dialog->onPaintButtons( rects[a]);
+	}
+	m_main_graph->setViewport( NULL);
+	Cgraphics::m_defaults.painted_pixels =damage.area();
+
+	m_lock.lock();
+	m_painting =false;
+#ifdef USE_SDL2
+	// The back buffer is undefined after a present, so the composed texture
+	// is copied as one. Painting is still limited to the damage.
+	m_main_graph->update();
+#else
+	for ( int a=0; a<(int)rects.size(); a++)
+	{
+		m_main_graph->update( rects[a]);
+	}
+#endif
+	m_lock.unlock();
+}
+
 /** Paint all, during an invalidate or at every render action */
 void Cworld::paintAll()
 {
-	m_message_box.onPaint();
-	m_main_graph->update();
+	PROFILE_FRAME();
+	PROFILE_SCOPE( "Cworld::paintAll");
+	if ( m_main_graph->collectImages())
+	{
+		// Decoded images replace their placeholders.
+		invalidate();
+	}
+	m_damage.setBounds( Crect( 0, 0, Cgraphics::m_defaults.width, Cgraphics::m_defaults.height));
+	if ( m_message_box.size()>0)
+	{
+		paintOverlays();
+		return;
+	}
+	if ( m_frozen)
+	{
+		// Last message box closed, the dialog below runs again.
+		m_main_graph->pop_back();
+		m_frozen =false;
+		m_invalidate =true;
+	}
+	if ( !needsFullPaint())
+	{
+		paintDamage();
+		return;
+	}
+	m_painting =true;
 
 	if (m_active_dialog)
 	{
@@ -128,15 +320,148 @@ void Cworld::paintAll()
 			p.setText(tt);
 			p.onPaint(0);
 		}
+#ifdef USE_PROFILER
+		if ( Cgraphics::m_defaults.debug_profiler)
+		{
+			paintProfiler();
+		}
+#endif
+		m_active_dialog->invalidate( false);
 	}
+	m_painting =false;
+	m_damage.clear();
+	Cgraphics::m_defaults.painted_pixels =m_main_graph->width()*m_main_graph->height();
 	m_invalidate =false;
 	onRender();
 }
 
+#ifdef USE_PROFILER
+/** @brief Show the busy time of the last frames and the slowest objects.
+ *  Bars are green within 60 frames per second, the line is the budget.
+ */
+void Cworld::paintProfiler()
+{
+	Cprofiler *profiler =Cprofiler::Instance();
+	int left =m_main_graph->width()/8-PROFILE_OVERLAY_WIDTH-1;
+	int right =( left+PROFILE_OVERLAY_WIDTH)*8;
+	int bottom =8+PROFILE_OVERLAY_HEIGHT;
+	int budget =bottom-PROFILE_OVERLAY_HEIGHT*PROFILE_BUDGET/PROFILE_OVERLAY_RANGE;
+	uint32_t worst =0;
+
+	m_main_graph->setColour( 0x000000);
+	m_main_graph->bar( left*8, 8, right, bottom);
+	for ( int a=0; a<profiler->frames(); a++)
+	{
+		uint32_t t =profiler->frameTime( a);
+		int height =(int)( ( t<PROFILE_OVERLAY_RANGE ? t:PROFILE_OVERLAY_RANGE)
+						   *PROFILE_OVERLAY_HEIGHT/PROFILE_OVERLAY_RANGE);
+		int x =right-2*(a+1);
+		m_main_graph->setColour( ( t<=PROFILE_BUDGET) ? 0x00c000:0xe00000);
+		m_main_graph->bar( x, bottom-height, x+1, bottom);
+		worst =( t>worst) ? t:worst;
+	}
+	m_main_graph->setColour( 0xffff00);
+	m_main_graph->line( left*8, budget, right-1, budget);
+
+	char s[80];
+	int top =PROFILE_OVERLAY_HEIGHT/8+2;
+	snprintf( s, sizeof(s), "frame %.1f ms, max %.1f ms",
+			  profiler->frameTime( 0)/1000.0, worst/1000.0);
+	Clabel frame( m_active_dialog, Crect( left, top, PROFILE_OVERLAY_WIDTH, 3), KEY_NOCHANGE);
+	frame.setText( s);
+	frame.onPaint( 0);
+	for ( const SprofileScope &scope : profiler->slowest())
+	{
+		top +=3;
+		snprintf( s, sizeof(s), "%s %s %.2f ms", Cprofiler::className( scope.name),
+				  ((std::string)Ckeybutton( (keybutton)scope.key)).c_str(), scope.duration/1000.0);
+		Clabel object( m_active_dialog, Crect( left, top, PROFILE_OVERLAY_WIDTH, 3), KEY_NOCHANGE);
+		object.setText( s);
+		object.onPaint( 0);
+	}
+}
+#endif
+
+/** @brief Check if a message box must be painted again.
+ *  @return true when the world or one of the boxes is invalidated.
+ */
+bool Cworld::overlaysInvalidated()
+{
+	if ( m_invalidate || !m_frozen || !m_damage.isEmpty())
+	{
+		return true;
+	}
+	for ( auto a : m_message_box)
+	{
+		Cdialog *t=dynamic_cast<Cdialog*>(a);
+		if ( t && t->isInvalidated())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief Paint the message boxes on top of the frozen screen.
+ *  The dialog below is painted once and saved with push_back(). While boxes
+ *  are open, only that copy is restored and the boxes are painted on top.
+ */
+void Cworld::paintOverlays()
+{
+	m_lock.lock();
+	if ( !overlaysInvalidated())
+	{
+		Cgraphics::m_defaults.painted_pixels =0;
+		m_lock.unlock();
+		return;
+	}
+	m_painting =true;
+	if ( !m_frozen)
+	{
+		if ( m_active_dialog)
+		{
+			m_active_dialog->onClearScreen();
+			m_active_dialog->onPaint();
+			m_active_dialog->onPaintButtons();
+			m_active_dialog->m_children.onPaint();
+			m_active_dialog->onRender();
+			m_active_dialog->invalidate( false);
+		}
+		m_frozen =m_main_graph->push_back();
+	}
+	else
+	{
+		m_main_graph->front();
+	}
+	for ( auto a : m_message_box)
+	{
+		Cdialog *t=dynamic_cast<Cdialog*>(a);
+		if ( t==NULL || t->m_visible ==false)
+		{
+			continue;
+		}
+		t->onClearScreen();
+		t->onPaintButtons();
+		t->onPaint();
+		if ( t->m_render_after_paint)
+		{
+			t->onRender();
+		}
+		t->invalidate( false);
+	}
+	m_painting =false;
+	m_damage.clear();
+	m_invalidate =false;
+	Cgraphics::m_defaults.painted_pixels =m_main_graph->width()*m_main_graph->height();
+	m_main_graph->update();
+	m_lock.unlock();
+}
+
 /** Render all dialogs to the world graphic, which is the background in the end
  *  Some dialogs may not have their own Cgraphics, so we have to paint them again */
 void Cworld::onRender()
 {
+	PROFILE_SCOPE( "Cworld::onRender");
 	// First render all the dialogs
 	m_lock.lock();
 	if (m_active_dialog == NULL)
@@ -166,6 +491,12 @@ std::shared_ptr<Cgraphics> Cworld::graphics()
 void Cworld::setActiveDialog(Cdialog *dialog)
 {
 	m_lock.lock();
+	if ( m_frozen && dialog !=m_active_dialog)
+	{
+		// Message boxes stay open, freeze the new dialog below them.
+		m_main_graph->pop_back();
+		m_frozen =false;
+	}
 	m_active_dialog = dialog;
 	m_lock.unlock();
 }
@@ -213,32 +544,14 @@ void Cworld::notifyInvalidate()
 /** Touch all dialogs irregularly for updates */
 bool Cworld::onLoop()
 {
+	PROFILE_SCOPE( "Cworld::onLoop");
 	bool no_action =true;
 	if ( Cgraphics::m_defaults.external_loop )
 	{
 		Cgraphics::m_defaults.external_loop();
 	}
 
-	for ( auto a : m_message_box)
-	{
-		Cdialog *t=dynamic_cast<Cdialog*>(a);
-		if (!t)
-		{
-			continue;
-		}
-		if (t->onLoop()==false)
-		{
-			// Close the dialog, not the layers below.
-			if ( t->m_alive ==false || t->m_selfDestruct==true)
-			{
-				//Cdialog::onExecute  delete the message box  t->m_name
-				invalidate();
-				unregisterMessageBox(t);
-				delete t;
-				break;
-			}
-		}
-	}
+	loopMessageBoxes();
 	for ( auto a : m_active_dialog->m_children )
 	{
 		Cdialog *t=dynamic_cast<Cdialog*>(a);
@@ -258,7 +571,6 @@ bool Cworld::onLoop()
 	}
 	EpollStatus status;
 	int n=10;
-	int cnt3=0;
 	while (  m_active_dialog->isRunning() ==true
 		  && (status=CdialogEvent::Instance()->pollEvent(m_active_dialog) )!=POLL_EMPTY)
 	{
@@ -268,35 +580,47 @@ bool Cworld::onLoop()
 		{
 			break;
 		}
-		for ( auto a : m_message_box )
-		{
-			Cdialog *t=dynamic_cast<Cdialog*>(a);
-			if (!t)
-			{
-				continue;
-			}
-			if (t->onLoop()==false)
-			{
-				// Close the dialog, not the layers below.
-				if ( t->m_alive ==false || t->m_selfDestruct==true)
-				{
-					//Cdialog::onExecute  delete the message box  t->m_name
-					invalidate();
-					unregisterMessageBox(t);
-					delete t;
-					break;
-				}
-			}
-			cnt3++;
-		}
+		loopMessageBoxes();
 		if ( status==POLL_TESTING)
 		{
 			break;
 		}
 	}
+	if ( no_action ==false)
+	{
+		// Events may change any object.
+		invalidate();
+	}
 	return no_action;
 }
 
+/** @brief Touch the message boxes, close the ones that stopped.
+ *  A closed box gets onExit() first, which may open the next box. The list is
+ *  not changed while walking it.
+ */
+void Cworld::loopMessageBoxes()
+{
+	std::vector<Cdialog*> closed;
+	for ( auto a : m_message_box)
+	{
+		Cdialog *t=dynamic_cast<Cdialog*>(a);
+		if ( t && t->onLoop()==false)
+		{
+			// Close the dialog, not the layers below.
+			if ( t->m_alive ==false || t->m_selfDestruct==true)
+			{
+				closed.push_back( t);
+			}
+		}
+	}
+	for ( Cdialog *t : closed)
+	{
+		t->onExit();
+		unregisterMessageBox(t);
+		delete t;
+	}
+}
+
 void Cworld::onCleanup()
 {
 	m_lock.lock();